@@ -39,6 +39,8 @@ DisplayOnPageChangeTrigger = display_ns.class_(
 
 CONF_ON_PAGE_CHANGE = "on_page_change"
 CONF_SHOW_TEST_CARD = "show_test_card"
+CONF_PAGE_CACHE = "page_cache"
+CONF_TEXT_CACHE_SIZE = "text_cache_size"
 CONF_UNSPECIFIED = "unspecified"
 
 DISPLAY_ROTATIONS = {
@@ -93,6 +95,10 @@ FULL_DISPLAY_SCHEMA = BASIC_DISPLAY_SCHEMA.extend(
             CONF_AUTO_CLEAR_ENABLED, default=CONF_UNSPECIFIED
         ): validate_auto_clear,
         cv.Optional(CONF_SHOW_TEST_CARD): cv.boolean,
+        # The page lambda runs once more to fingerprint each update, so it must not have side effects such as
+        # logging, counters, animation state or publishing sensor states
+        cv.Optional(CONF_PAGE_CACHE, default=False): cv.boolean,
+        cv.Optional(CONF_TEXT_CACHE_SIZE, default=0): cv.int_range(min=0, max=64),
     }
 )
 
@@ -130,6 +136,10 @@ async def setup_display_core_(var, config):
         )
     if config.get(CONF_SHOW_TEST_CARD):
         cg.add(var.show_test_card())
+    if config.get(CONF_PAGE_CACHE):
+        cg.add(var.set_page_cache(True))
+    if config.get(CONF_TEXT_CACHE_SIZE):
+        cg.add(var.set_text_cache_size(config[CONF_TEXT_CACHE_SIZE]))
 
 
 async def register_display(var, config):
@@ -1,4 +1,7 @@
 #include "display.h"
+#include <cinttypes>
+#include <climits>
+#include <cstring>
 #include <utility>
 #include "display_color_utils.h"
 #include "esphome/core/hal.h"
@@ -12,10 +15,19 @@ static const char *const TAG = "display";
 const Color COLOR_OFF(0, 0, 0, 0);
 const Color COLOR_ON(255, 255, 255, 255);
 
-void Display::fill(Color color) { this->filled_rectangle(0, 0, this->get_width(), this->get_height(), color); }
+void Display::fill(Color color) {
+  if (this->record_(RECORD_FILL, color))
+    return;
+  this->filled_rectangle(0, 0, this->get_width(), this->get_height(), color);
+}
 void Display::clear() { this->fill(COLOR_OFF); }
-void Display::set_rotation(DisplayRotation rotation) { this->rotation_ = rotation; }
+void Display::set_rotation(DisplayRotation rotation) {
+  this->rotation_ = rotation;
+  this->update_clip_();
+}
 void HOT Display::line(int x1, int y1, int x2, int y2, Color color) {
+  if (this->record_(RECORD_LINE, x1, y1, x2, y2, color))
+    return;
   const int32_t dx = abs(x2 - x1), sx = x1 < x2 ? 1 : -1;
   const int32_t dy = -abs(y2 - y1), sy = y1 < y2 ? 1 : -1;
   int32_t err = dx + dy;
@@ -41,11 +53,15 @@ void Display::line_at_angle(int x, int y, int angle, int length, Color color) {
 }
 
 void Display::line_at_angle(int x, int y, int angle, int start_radius, int stop_radius, Color color) {
+  if (this->record_(RECORD_LINE_AT_ANGLE, x, y, angle, start_radius, stop_radius, color))
+    return;
   // Calculate start and end points
-  int x1 = (start_radius * cos(angle * M_PI / 180)) + x;
-  int y1 = (start_radius * sin(angle * M_PI / 180)) + y;
-  int x2 = (stop_radius * cos(angle * M_PI / 180)) + x;
-  int y2 = (stop_radius * sin(angle * M_PI / 180)) + y;
+  int32_t cos_a = cos_fixed(angle * FIXED_ANGLE_SCALE);
+  int32_t sin_a = sin_fixed(angle * FIXED_ANGLE_SCALE);
+  int x1 = ((start_radius * cos_a) >> FIXED_TRIG_SHIFT) + x;
+  int y1 = ((start_radius * sin_a) >> FIXED_TRIG_SHIFT) + y;
+  int x2 = ((stop_radius * cos_a) >> FIXED_TRIG_SHIFT) + x;
+  int y2 = ((stop_radius * sin_a) >> FIXED_TRIG_SHIFT) + y;
 
   // Draw line
   this->line(x1, y1, x2, y2, color);
@@ -53,6 +69,8 @@ void Display::line_at_angle(int x, int y, int angle, int start_radius, int stop_
 
 void Display::draw_pixels_at(int x_start, int y_start, int w, int h, const uint8_t *ptr, ColorOrder order,
                              ColorBitness bitness, bool big_endian, int x_offset, int y_offset, int x_pad) {
+  if (this->record_pixels_(x_start, y_start, w, h, ptr, order, bitness, big_endian, x_offset, y_offset, x_pad))
+    return;
   size_t line_stride = x_offset + w + x_pad;  // length of each source line in pixels
   uint32_t color_value;
   for (int y = 0; y != h; y++) {
@@ -85,335 +103,193 @@ void Display::draw_pixels_at(int x_start, int y_start, int w, int h, const uint8
   }
 }
 
-void HOT Display::horizontal_line(int x, int y, int width, Color color) {
-  // Future: Could be made more efficient by manipulating buffer directly in certain rotations.
+void HOT Display::fill_row(int x, int y, int width, Color color) {
+  if (this->record_(RECORD_ROW, x, y, width, color))
+    return;
   for (int i = x; i < x + width; i++)
     this->draw_pixel_at(i, y, color);
 }
-void HOT Display::vertical_line(int x, int y, int height, Color color) {
-  // Future: Could be made more efficient by manipulating buffer directly in certain rotations.
+void HOT Display::fill_column(int x, int y, int height, Color color) {
+  if (this->record_(RECORD_COLUMN, x, y, height, color))
+    return;
   for (int i = y; i < y + height; i++)
     this->draw_pixel_at(x, i, color);
 }
+void HOT Display::horizontal_line(int x, int y, int width, Color color) { this->fill_row(x, y, width, color); }
+void HOT Display::vertical_line(int x, int y, int height, Color color) { this->fill_column(x, y, height, color); }
 void Display::rectangle(int x1, int y1, int width, int height, Color color) {
+  if (this->record_(RECORD_RECTANGLE, x1, y1, width, height, color))
+    return;
   this->horizontal_line(x1, y1, width, color);
   this->horizontal_line(x1, y1 + height - 1, width, color);
   this->vertical_line(x1, y1, height, color);
   this->vertical_line(x1 + width - 1, y1, height, color);
 }
 void Display::filled_rectangle(int x1, int y1, int width, int height, Color color) {
-  // Future: Use vertical_line and horizontal_line methods depending on rotation to reduce memory accesses.
-  for (int i = y1; i < y1 + height; i++) {
-    this->horizontal_line(x1, i, width, color);
+  if (this->record_(RECORD_FILLED_RECTANGLE, x1, y1, width, height, color))
+    return;
+  // Use the spans that run along the rows of the underlying buffer, with 90 and 270 degrees those are columns.
+  if (this->rotation_ == DISPLAY_ROTATION_90_DEGREES || this->rotation_ == DISPLAY_ROTATION_270_DEGREES) {
+    for (int i = x1; i < x1 + width; i++) {
+      this->fill_column(i, y1, height, color);
+    }
+  } else {
+    for (int i = y1; i < y1 + height; i++) {
+      this->fill_row(x1, i, width, color);
+    }
   }
 }
 void HOT Display::circle(int center_x, int center_xy, int radius, Color color) {
-  int dx = -radius;
-  int dy = 0;
-  int err = 2 - 2 * radius;
-  int e2;
-
-  do {
-    this->draw_pixel_at(center_x - dx, center_xy + dy, color);
-    this->draw_pixel_at(center_x + dx, center_xy + dy, color);
-    this->draw_pixel_at(center_x + dx, center_xy - dy, color);
-    this->draw_pixel_at(center_x - dx, center_xy - dy, color);
-    e2 = err;
-    if (e2 < dy) {
-      err += ++dy * 2 + 1;
-      if (-dx == dy && e2 <= dx) {
-        e2 = 0;
+  if (this->record_(RECORD_CIRCLE, center_x, center_xy, radius, color))
+    return;
+  CircleScanner scanner(radius);
+  int dy, outer, inner;
+  while (scanner.next(&dy, &outer, &inner)) {
+    for (int y : {center_xy + dy, center_xy - dy}) {
+      if (inner == 0) {
+        this->horizontal_line(center_x - outer, y, 2 * outer + 1, color);
+      } else if (inner == outer) {
+        // the steep parts are single pixels, those are cheaper to draw as such
+        this->draw_pixel_at(center_x - outer, y, color);
+        this->draw_pixel_at(center_x + outer, y, color);
+      } else {
+        this->horizontal_line(center_x - outer, y, outer - inner + 1, color);
+        this->horizontal_line(center_x + inner, y, outer - inner + 1, color);
       }
+      if (dy == 0)
+        break;
     }
-    if (e2 > dx) {
-      err += ++dx * 2 + 1;
-    }
-  } while (dx <= 0);
+  }
 }
 void Display::filled_circle(int center_x, int center_y, int radius, Color color) {
-  int dx = -int32_t(radius);
-  int dy = 0;
-  int err = 2 - 2 * radius;
-  int e2;
-
-  do {
-    this->draw_pixel_at(center_x - dx, center_y + dy, color);
-    this->draw_pixel_at(center_x + dx, center_y + dy, color);
-    this->draw_pixel_at(center_x + dx, center_y - dy, color);
-    this->draw_pixel_at(center_x - dx, center_y - dy, color);
-    int hline_width = 2 * (-dx) + 1;
-    this->horizontal_line(center_x + dx, center_y + dy, hline_width, color);
-    this->horizontal_line(center_x + dx, center_y - dy, hline_width, color);
-    e2 = err;
-    if (e2 < dy) {
-      err += ++dy * 2 + 1;
-      if (-dx == dy && e2 <= dx) {
-        e2 = 0;
-      }
-    }
-    if (e2 > dx) {
-      err += ++dx * 2 + 1;
-    }
-  } while (dx <= 0);
+  if (this->record_(RECORD_FILLED_CIRCLE, center_x, center_y, radius, color))
+    return;
+  CircleScanner scanner(radius);
+  int dy, outer, inner;
+  while (scanner.next(&dy, &outer, &inner)) {
+    this->horizontal_line(center_x - outer, center_y + dy, 2 * outer + 1, color);
+    if (dy != 0)
+      this->horizontal_line(center_x - outer, center_y - dy, 2 * outer + 1, color);
+  }
 }
 void Display::filled_ring(int center_x, int center_y, int radius1, int radius2, Color color) {
+  if (this->record_(RECORD_FILLED_RING, center_x, center_y, radius1, radius2, color))
+    return;
   int rmax = radius1 > radius2 ? radius1 : radius2;
   int rmin = radius1 < radius2 ? radius1 : radius2;
-  int dxmax = -int32_t(rmax), dxmin = -int32_t(rmin);
-  int dymax = 0, dymin = 0;
-  int errmax = 2 - 2 * rmax, errmin = 2 - 2 * rmin;
-  int e2max, e2min;
-  do {
-    // 8 dots for borders
-    this->draw_pixel_at(center_x - dxmax, center_y + dymax, color);
-    this->draw_pixel_at(center_x + dxmax, center_y + dymax, color);
-    this->draw_pixel_at(center_x - dxmin, center_y + dymin, color);
-    this->draw_pixel_at(center_x + dxmin, center_y + dymin, color);
-    this->draw_pixel_at(center_x + dxmax, center_y - dymax, color);
-    this->draw_pixel_at(center_x - dxmax, center_y - dymax, color);
-    this->draw_pixel_at(center_x + dxmin, center_y - dymin, color);
-    this->draw_pixel_at(center_x - dxmin, center_y - dymin, color);
-    if (dymin < rmin) {
-      // two parts - four lines
-      int hline_width = -(dxmax - dxmin) + 1;
-      this->horizontal_line(center_x + dxmax, center_y + dymax, hline_width, color);
-      this->horizontal_line(center_x - dxmin, center_y + dymax, hline_width, color);
-      this->horizontal_line(center_x + dxmax, center_y - dymax, hline_width, color);
-      this->horizontal_line(center_x - dxmin, center_y - dymax, hline_width, color);
-    } else {
-      // one part - top and bottom
-      int hline_width = 2 * (-dxmax) + 1;
-      this->horizontal_line(center_x + dxmax, center_y + dymax, hline_width, color);
-      this->horizontal_line(center_x + dxmax, center_y - dymax, hline_width, color);
-    }
-    e2max = errmax;
-    // tune external
-    if (e2max < dymax) {
-      errmax += ++dymax * 2 + 1;
-      if (-dxmax == dymax && e2max <= dxmax) {
-        e2max = 0;
-      }
-    }
-    if (e2max > dxmax) {
-      errmax += ++dxmax * 2 + 1;
-    }
-    // tune internal
-    while (dymin < dymax && dymin < rmin) {
-      e2min = errmin;
-      if (e2min < dymin) {
-        errmin += ++dymin * 2 + 1;
-        if (-dxmin == dymin && e2min <= dxmin) {
-          e2min = 0;
-        }
-      }
-      if (e2min > dxmin) {
-        errmin += ++dxmin * 2 + 1;
+  CircleScanner outer_scanner(rmax), inner_scanner(rmin);
+  int dy, outer, outer_inner, inner = 0, inner_inner;
+  while (outer_scanner.next(&dy, &outer, &outer_inner)) {
+    // Both circles advance one row at a time, the inner one runs out once its top is reached.
+    int inner_dy;
+    if (dy < rmin)
+      inner_scanner.next(&inner_dy, &inner, &inner_inner);
+    for (int y : {center_y + dy, center_y - dy}) {
+      if (dy < rmin) {
+        // two parts - left and right of the hole, a thin ring can leave the outer outline reaching further inside
+        int hline_width = outer - std::min(inner, outer_inner) + 1;
+        this->horizontal_line(center_x - outer, y, hline_width, color);
+        this->horizontal_line(center_x + outer - hline_width + 1, y, hline_width, color);
+      } else {
+        // one part - above and below the hole
+        this->horizontal_line(center_x - outer, y, 2 * outer + 1, color);
       }
+      if (dy == 0)
+        break;
     }
-  } while (dxmax <= 0);
+  }
 }
 void Display::filled_gauge(int center_x, int center_y, int radius1, int radius2, int progress, Color color) {
+  if (this->record_(RECORD_FILLED_GAUGE, center_x, center_y, radius1, radius2, progress, color))
+    return;
   int rmax = radius1 > radius2 ? radius1 : radius2;
   int rmin = radius1 < radius2 ? radius1 : radius2;
-  int dxmax = -int32_t(rmax), dxmin = -int32_t(rmin), upd_dxmax, upd_dxmin;
-  int dymax = 0, dymin = 0;
-  int errmax = 2 - 2 * rmax, errmin = 2 - 2 * rmin;
-  int e2max, e2min;
   progress = std::max(0, std::min(progress, 100));  // 0..100
+  // The gauge fills clockwise from the left, up to a ray from the center at 1.8 degrees per percent. Past 50% the
+  // ray is measured from the right instead, so the slope stays finite and everything left of it is filled.
   int draw_progress = progress > 50 ? (100 - progress) : progress;
-  float tan_a = (progress == 50) ? 65535 : tan(float(draw_progress) * M_PI / 100);  // slope
-
-  do {
-    // outer dots
-    this->draw_pixel_at(center_x + dxmax, center_y - dymax, color);
-    this->draw_pixel_at(center_x - dxmax, center_y - dymax, color);
-    if (dymin < rmin) {  // side parts
-      int lhline_width = -(dxmax - dxmin) + 1;
-      if (progress >= 50) {
-        if (float(dymax) < float(-dxmax) * tan_a) {
-          upd_dxmax = ceil(float(dymax) / tan_a);
-        } else {
-          upd_dxmax = -dxmax;
-        }
-        this->horizontal_line(center_x + dxmax, center_y - dymax, lhline_width, color);  // left
-        if (!dymax)
-          this->horizontal_line(center_x - dxmin, center_y, lhline_width, color);  // right horizontal border
-        if (upd_dxmax > -dxmin) {                                                  // right
-          int rhline_width = (upd_dxmax + dxmin) + 1;
-          this->horizontal_line(center_x - dxmin, center_y - dymax,
-                                rhline_width > lhline_width ? lhline_width : rhline_width, color);
-        }
-      } else {
-        if (float(dymin) > float(-dxmin) * tan_a) {
-          upd_dxmin = ceil(float(dymin) / tan_a);
-        } else {
-          upd_dxmin = -dxmin;
-        }
-        lhline_width = -(dxmax + upd_dxmin) + 1;
-        if (!dymax)
-          this->horizontal_line(center_x - dxmin, center_y, lhline_width, color);  // right horizontal border
-        if (lhline_width > 0)
-          this->horizontal_line(center_x + dxmax, center_y - dymax, lhline_width, color);
+  int32_t angle = (draw_progress * 18 * FIXED_ANGLE_SCALE + 5) / 10;
+  int32_t sin_a = sin_fixed(angle);
+  int32_t cos_a = cos_fixed(angle);
+
+  CircleScanner outer_scanner(rmax), inner_scanner(rmin);
+  int dy, outer, outer_inner, inner = 0, inner_inner = 0;
+  bool has_inner = true;
+  while (outer_scanner.next(&dy, &outer, &outer_inner)) {
+    int inner_dy;
+    has_inner = has_inner && inner_scanner.next(&inner_dy, &inner, &inner_inner);
+    int y = center_y - dy;
+
+    // Everything up to the column `limit` (relative to the center) is filled on this row.
+    int limit;
+    if (sin_a == 0) {
+      limit = (progress > 50 || dy == 0) ? outer : -outer - 1;
+    } else {
+      int run = (dy * cos_a + sin_a - 1) / sin_a;  // ceil(dy / tan(a))
+      limit = progress > 50 ? run : -run;
+    }
+
+    // Outlines of both half circles and the filled part, added from left to right.
+    RowSpans spans;
+    spans.add(-outer, -outer_inner);
+    if (dy < rmin) {  // side parts
+      spans.add(-outer, std::min(-inner, limit));
+      if (has_inner) {
+        spans.add(-inner, -inner_inner);
+        spans.add(inner_inner, inner);
       }
-    } else {  // top part
-      int hline_width = 2 * (-dxmax) + 1;
-      if (progress >= 50) {
-        if (dymax < float(-dxmax) * tan_a) {
-          upd_dxmax = ceil(float(dymax) / tan_a);
-          hline_width = -dxmax + upd_dxmax + 1;
-        }
+      if (dy == 0) {
+        spans.add(inner, outer);  // right horizontal border
       } else {
-        if (dymax < float(-dxmax) * tan_a) {
-          upd_dxmax = ceil(float(dymax) / tan_a);
-          hline_width = -dxmax - upd_dxmax + 1;
-        } else {
-          hline_width = 0;
-        }
+        spans.add(inner, std::min(outer, limit));
       }
-      if (hline_width > 0)
-        this->horizontal_line(center_x + dxmax, center_y - dymax, hline_width, color);
-    }
-    e2max = errmax;
-    if (e2max < dymax) {
-      errmax += ++dymax * 2 + 1;
-      if (-dxmax == dymax && e2max <= dxmax) {
-        e2max = 0;
+    } else {  // top part
+      spans.add(-outer, std::min(outer, limit));
+      if (has_inner) {
+        spans.add(-inner, -inner_inner);
+        spans.add(inner_inner, inner);
       }
     }
-    if (e2max > dxmax) {
-      errmax += ++dxmax * 2 + 1;
-    }
-    while (dymin <= dymax && dymin <= rmin && dxmin <= 0) {
-      this->draw_pixel_at(center_x + dxmin, center_y - dymin, color);
-      this->draw_pixel_at(center_x - dxmin, center_y - dymin, color);
-      e2min = errmin;
-      if (e2min < dymin) {
-        errmin += ++dymin * 2 + 1;
-        if (-dxmin == dymin && e2min <= dxmin) {
-          e2min = 0;
-        }
-      }
-      if (e2min > dxmin) {
-        errmin += ++dxmin * 2 + 1;
+    spans.add(outer_inner, outer);
+    spans.flush([&](int x, int width) {
+      // as with circle(), the steep parts of the outlines are single pixels
+      if (width == 1) {
+        this->draw_pixel_at(center_x + x, y, color);
+      } else {
+        this->horizontal_line(center_x + x, y, width, color);
       }
-    }
-  } while (dxmax <= 0);
+    });
+  }
 }
 void HOT Display::triangle(int x1, int y1, int x2, int y2, int x3, int y3, Color color) {
+  if (this->record_(RECORD_TRIANGLE, x1, y1, x2, y2, x3, y3, color))
+    return;
   this->line(x1, y1, x2, y2, color);
   this->line(x1, y1, x3, y3, color);
   this->line(x2, y2, x3, y3, color);
 }
-void Display::sort_triangle_points_by_y_(int *x1, int *y1, int *x2, int *y2, int *x3, int *y3) {
-  if (*y1 > *y2) {
-    int x_temp = *x1, y_temp = *y1;
-    *x1 = *x2, *y1 = *y2;
-    *x2 = x_temp, *y2 = y_temp;
-  }
-  if (*y1 > *y3) {
-    int x_temp = *x1, y_temp = *y1;
-    *x1 = *x3, *y1 = *y3;
-    *x3 = x_temp, *y3 = y_temp;
-  }
-  if (*y2 > *y3) {
-    int x_temp = *x2, y_temp = *y2;
-    *x2 = *x3, *y2 = *y3;
-    *x3 = x_temp, *y3 = y_temp;
-  }
-}
-void Display::filled_flat_side_triangle_(int x1, int y1, int x2, int y2, int x3, int y3, Color color) {
-  // y2 must be equal to y3 (same horizontal line)
-
-  // Initialize Bresenham's algorithm for side 1
-  int s1_current_x = x1;
-  int s1_current_y = y1;
-  bool s1_axis_swap = false;
-  int s1_dx = abs(x2 - x1);
-  int s1_dy = abs(y2 - y1);
-  int s1_sign_x = ((x2 - x1) >= 0) ? 1 : -1;
-  int s1_sign_y = ((y2 - y1) >= 0) ? 1 : -1;
-  if (s1_dy > s1_dx) {  // swap values
-    int tmp = s1_dx;
-    s1_dx = s1_dy;
-    s1_dy = tmp;
-    s1_axis_swap = true;
-  }
-  int s1_error = 2 * s1_dy - s1_dx;
-
-  // Initialize Bresenham's algorithm for side 2
-  int s2_current_x = x1;
-  int s2_current_y = y1;
-  bool s2_axis_swap = false;
-  int s2_dx = abs(x3 - x1);
-  int s2_dy = abs(y3 - y1);
-  int s2_sign_x = ((x3 - x1) >= 0) ? 1 : -1;
-  int s2_sign_y = ((y3 - y1) >= 0) ? 1 : -1;
-  if (s2_dy > s2_dx) {  // swap values
-    int tmp = s2_dx;
-    s2_dx = s2_dy;
-    s2_dy = tmp;
-    s2_axis_swap = true;
-  }
-  int s2_error = 2 * s2_dy - s2_dx;
-
-  // Iterate on side 1 and allow side 2 to be processed to match the advance of the y-axis.
-  for (int i = 0; i <= s1_dx; i++) {
-    if (s1_current_x <= s2_current_x) {
-      this->horizontal_line(s1_current_x, s1_current_y, s2_current_x - s1_current_x + 1, color);
-    } else {
-      this->horizontal_line(s2_current_x, s2_current_y, s1_current_x - s2_current_x + 1, color);
-    }
-
-    // Bresenham's #1
-    // Side 1 s1_current_x and s1_current_y calculation
-    while (s1_error >= 0) {
-      if (s1_axis_swap) {
-        s1_current_x += s1_sign_x;
-      } else {
-        s1_current_y += s1_sign_y;
-      }
-      s1_error = s1_error - 2 * s1_dx;
-    }
-    if (s1_axis_swap) {
-      s1_current_y += s1_sign_y;
-    } else {
-      s1_current_x += s1_sign_x;
-    }
-    s1_error = s1_error + 2 * s1_dy;
-
-    // Bresenham's #2
-    // Side 2 s2_current_x and s2_current_y calculation
-    while (s2_current_y != s1_current_y) {
-      while (s2_error >= 0) {
-        if (s2_axis_swap) {
-          s2_current_x += s2_sign_x;
-        } else {
-          s2_current_y += s2_sign_y;
-        }
-        s2_error = s2_error - 2 * s2_dx;
-      }
-      if (s2_axis_swap) {
-        s2_current_y += s2_sign_y;
-      } else {
-        s2_current_x += s2_sign_x;
-      }
-      s2_error = s2_error + 2 * s2_dy;
+void Display::filled_polygon_(ScanEdge *edges, size_t count, Color color) {
+  int y_top = INT_MAX, y_bottom = INT_MIN;
+  for (size_t i = 0; i < count; i++) {
+    y_top = std::min(y_top, edges[i].top());
+    y_bottom = std::max(y_bottom, edges[i].bottom());
+  }
+  for (int y = y_top; y <= y_bottom; y++) {
+    int x_min = INT_MAX, x_max = INT_MIN;
+    for (size_t i = 0; i < count; i++) {
+      if (edges[i].top() <= y && y <= edges[i].bottom())
+        edges[i].step(x_min, x_max);
     }
+    if (x_min <= x_max)
+      this->horizontal_line(x_min, y, x_max - x_min + 1, color);
   }
 }
 void Display::filled_triangle(int x1, int y1, int x2, int y2, int x3, int y3, Color color) {
-  // Sort the three points by y-coordinate ascending, so [x1,y1] is the topmost point
-  this->sort_triangle_points_by_y_(&x1, &y1, &x2, &y2, &x3, &y3);
-
-  if (y2 == y3) {  // Check for special case of a bottom-flat triangle
-    this->filled_flat_side_triangle_(x1, y1, x2, y2, x3, y3, color);
-  } else if (y1 == y2) {  // Check for special case of a top-flat triangle
-    this->filled_flat_side_triangle_(x3, y3, x1, y1, x2, y2, color);
-  } else {  // General case: split the no-flat-side triangle in a top-flat triangle and bottom-flat triangle
-    int x_temp = (int) (x1 + ((float) (y2 - y1) / (float) (y3 - y1)) * (x3 - x1)), y_temp = y2;
-    this->filled_flat_side_triangle_(x1, y1, x2, y2, x_temp, y_temp, color);
-    this->filled_flat_side_triangle_(x3, y3, x2, y2, x_temp, y_temp, color);
-  }
+  if (this->record_(RECORD_FILLED_TRIANGLE, x1, y1, x2, y2, x3, y3, color))
+    return;
+  // The edges run in the same directions as the lines of triangle(), which cover the same pixels
+  ScanEdge edges[3] = {ScanEdge(x1, y1, x2, y2), ScanEdge(x1, y1, x3, y3), ScanEdge(x2, y2, x3, y3)};
+  this->filled_polygon_(edges, 3, color);
 }
 void HOT Display::get_regular_polygon_vertex(int vertex_id, int *vertex_x, int *vertex_y, int center_x, int center_y,
                                              int radius, int edges, RegularPolygonVariation variation,
@@ -423,24 +299,31 @@ void HOT Display::get_regular_polygon_vertex(int vertex_id, int *vertex_x, int *
     // For a regular polygon, the human reference would be the top of the polygon,
     // hence we rotate the shape by 270° to orient the polygon up.
     rotation_degrees += ROTATION_270_DEGREES;
-    // Convert the rotation to radians, easier to use in trigonometrical calculations
-    float rotation_radians = rotation_degrees * PI / 180;
+    // Work in fixed point fractions of a degree, the trigonometry comes from a lookup table.
+    int32_t rotation = lroundf(rotation_degrees * FIXED_ANGLE_SCALE);
     // A pointy top variation means the first vertex of the polygon is at the top center of the shape, this requires no
     // additional rotation of the shape.
     // A flat top variation means the first point of the polygon has to be rotated so that the first edge is horizontal,
-    // this requires to rotate the shape by π/edges radians counter-clockwise so that the first point is located on the
+    // this requires to rotate the shape by 180°/edges counter-clockwise so that the first point is located on the
     // left side of the first horizontal edge.
-    rotation_radians -= (variation == VARIATION_FLAT_TOP) ? PI / edges : 0.0;
+    rotation -= (variation == VARIATION_FLAT_TOP) ? 180 * FIXED_ANGLE_SCALE / edges : 0;
 
-    float vertex_angle = ((float) vertex_id) / edges * 2 * PI + rotation_radians;
-    *vertex_x = (int) round(cos(vertex_angle) * radius) + center_x;
-    *vertex_y = (int) round(sin(vertex_angle) * radius) + center_y;
+    int32_t vertex_angle = (vertex_id % edges) * 360 * FIXED_ANGLE_SCALE / edges + rotation;
+    constexpr int32_t half = 1 << (FIXED_TRIG_SHIFT - 1);
+    *vertex_x = ((cos_fixed(vertex_angle) * radius + half) >> FIXED_TRIG_SHIFT) + center_x;
+    *vertex_y = ((sin_fixed(vertex_angle) * radius + half) >> FIXED_TRIG_SHIFT) + center_y;
   }
 }
 
 void HOT Display::regular_polygon(int x, int y, int radius, int edges, RegularPolygonVariation variation,
                                   float rotation_degrees, Color color, RegularPolygonDrawing drawing) {
+  if (this->record_(RECORD_REGULAR_POLYGON, x, y, radius, edges, variation, rotation_degrees, color, drawing))
+    return;
   if (edges >= 2) {
+    // A filled polygon is rasterized in one pass over all of its edges.
+    std::vector<ScanEdge> edges_list;
+    if (drawing == DRAWING_FILLED)
+      edges_list.reserve(edges);
     int previous_vertex_x, previous_vertex_y;
     for (int current_vertex_id = 0; current_vertex_id <= edges; current_vertex_id++) {
       int current_vertex_x, current_vertex_y;
@@ -448,7 +331,7 @@ void HOT Display::regular_polygon(int x, int y, int radius, int edges, RegularPo
                                  variation, rotation_degrees);
       if (current_vertex_id > 0) {  // Start drawing after the 2nd vertex coordinates has been calculated
         if (drawing == DRAWING_FILLED) {
-          this->filled_triangle(x, y, previous_vertex_x, previous_vertex_y, current_vertex_x, current_vertex_y, color);
+          edges_list.emplace_back(previous_vertex_x, previous_vertex_y, current_vertex_x, current_vertex_y);
         } else if (drawing == DRAWING_OUTLINE) {
           this->line(previous_vertex_x, previous_vertex_y, current_vertex_x, current_vertex_y, color);
         }
@@ -456,6 +339,8 @@ void HOT Display::regular_polygon(int x, int y, int radius, int edges, RegularPo
       previous_vertex_x = current_vertex_x;
       previous_vertex_y = current_vertex_y;
     }
+    if (drawing == DRAWING_FILLED)
+      this->filled_polygon_(edges_list.data(), edges_list.size(), color);
   }
 }
 void HOT Display::regular_polygon(int x, int y, int radius, int edges, RegularPolygonVariation variation, Color color,
@@ -478,10 +363,27 @@ void Display::filled_regular_polygon(int x, int y, int radius, int edges, Color
 }
 
 void Display::print(int x, int y, BaseFont *font, Color color, TextAlign align, const char *text, Color background) {
+  // Glyphs never change, the font and the text are enough
+  if (this->record_(RECORD_PRINT, x, y, uint32_t(reinterpret_cast<uintptr_t>(font)), color, uint32_t(align), text,
+                    background))
+    return;
   int x_start, y_start;
-  int width, height;
-  this->get_text_bounds(x, y, text, font, align, &x_start, &y_start, &width, &height);
-  font->print(x_start, y_start, this, color, text, background);
+  const TextRun *run = this->text_cache_.get(this, font, color, background, text);
+  if (run == nullptr) {
+    int width, height;
+    this->get_text_bounds(x, y, text, font, align, &x_start, &y_start, &width, &height);
+    font->print(x_start, y_start, this, color, text, background);
+    return;
+  }
+
+  this->align_text_(x, y, align, run->width, run->baseline, run->height, &x_start, &y_start);
+  for (const TextSpan &span : run->spans) {
+    if (span.width == 1) {
+      this->draw_pixel_at(x_start + span.x, y_start + span.y, span.color);
+    } else {
+      this->fill_row(x_start + span.x, y_start + span.y, span.width, span.color);
+    }
+  }
 }
 
 void Display::vprintf_(int x, int y, BaseFont *font, Color color, Color background, TextAlign align, const char *format,
@@ -549,16 +451,18 @@ void Display::get_text_bounds(int x, int y, const char *text, BaseFont *font, Te
                               int *width, int *height) {
   int x_offset, baseline;
   font->measure(text, width, &x_offset, &baseline, height);
-
+  this->align_text_(x, y, align, *width, baseline, *height, x1, y1);
+}
+void Display::align_text_(int x, int y, TextAlign align, int width, int baseline, int height, int *x1, int *y1) {
   auto x_align = TextAlign(int(align) & 0x18);
   auto y_align = TextAlign(int(align) & 0x07);
 
   switch (x_align) {
     case TextAlign::RIGHT:
-      *x1 = x - *width;
+      *x1 = x - width;
       break;
     case TextAlign::CENTER_HORIZONTAL:
-      *x1 = x - (*width) / 2;
+      *x1 = x - width / 2;
       break;
     case TextAlign::LEFT:
     default:
@@ -569,13 +473,13 @@ void Display::get_text_bounds(int x, int y, const char *text, BaseFont *font, Te
 
   switch (y_align) {
     case TextAlign::BOTTOM:
-      *y1 = y - *height;
+      *y1 = y - height;
       break;
     case TextAlign::BASELINE:
       *y1 = y - baseline;
       break;
     case TextAlign::CENTER_VERTICAL:
-      *y1 = y - (*height) / 2;
+      *y1 = y - height / 2;
       break;
     case TextAlign::TOP:
     default:
@@ -646,7 +550,51 @@ void Display::show_page(DisplayPage *page) {
 }
 void Display::show_next_page() { this->page_->show_next(); }
 void Display::show_prev_page() { this->page_->show_prev(); }
-void Display::do_update_() {
+bool Display::do_update_() {
+  uint32_t start = this->begin_render_stats_();
+  bool changed = !this->page_unchanged_();
+  if (changed)
+    this->render_page_();
+  this->end_render_stats_(start);
+  return changed;
+}
+uint32_t Display::begin_render_stats_() {
+  this->stats_.pixels = 0;
+  this->stats_.spans = 0;
+  return micros();
+}
+void Display::end_render_stats_(uint32_t start) { this->stats_.render_us = micros() - start; }
+void Display::report_stats_(bool sent) {
+  this->stats_.frames++;
+  if (!sent) {
+    this->stats_.skipped_frames++;
+    this->stats_.bytes_sent = 0;
+    this->stats_.refresh_ms = 0;
+  }
+  ESP_LOGD(TAG, "Update: render %.1fms, %" PRIu32 " px, %" PRIu32 " spans, %" PRIu32 " B sent, refresh %" PRIu32
+                "ms, %" PRIu32 "/%" PRIu32 " skipped",
+           this->stats_.render_us / 1000.0f, this->stats_.pixels, this->stats_.spans, this->stats_.bytes_sent,
+           this->stats_.refresh_ms, this->stats_.skipped_frames, this->stats_.frames);
+#ifdef USE_SENSOR
+  if (this->render_time_sensor_ != nullptr)
+    this->render_time_sensor_->publish_state(this->stats_.render_us / 1000.0f);
+  if (this->pixels_sensor_ != nullptr)
+    this->pixels_sensor_->publish_state(this->stats_.pixels);
+  if (this->spans_sensor_ != nullptr)
+    this->spans_sensor_->publish_state(this->stats_.spans);
+  if (this->bytes_sent_sensor_ != nullptr)
+    this->bytes_sent_sensor_->publish_state(this->stats_.bytes_sent);
+  if (this->refresh_time_sensor_ != nullptr)
+    this->refresh_time_sensor_->publish_state(this->stats_.refresh_ms);
+  if (this->skipped_frames_sensor_ != nullptr)
+    this->skipped_frames_sensor_->publish_state(this->stats_.skipped_frames);
+#endif
+  // Transfers are counted until the next report
+  this->stats_.bytes_sent = 0;
+}
+void Display::render_page_() {
+  // Drivers that do not go through DisplayBuffer::init_internal_() may only know their size once set up
+  this->update_clip_();
   if (this->auto_clear_enabled_) {
     this->clear();
   }
@@ -659,6 +607,82 @@ void Display::do_update_() {
   }
   this->clear_clipping_();
 }
+/** Takes the place of a display while its page writer is fingerprinted.
+ *
+ * Only the drawing methods of Display itself run on it, and every one of them records its call instead of drawing.
+ * Sizes and the display type are those of the real display.
+ */
+class PageRecorder : public Display {
+ public:
+  explicit PageRecorder(Display *display) : display_(display) {
+    this->rotation_ = display->get_rotation();
+    this->recording_ = true;
+    this->fingerprint_ = 2166136261u;
+    this->record_(RECORD_PAGE, this->rotation_, display->get_width(), display->get_height());
+  }
+
+  void update() override {}
+  void draw_pixel_at(int x, int y, Color color) override { this->record_(RECORD_PIXEL, x, y, color); }
+  int get_width() override { return this->display_->get_width(); }
+  int get_height() override { return this->display_->get_height(); }
+  DisplayType get_display_type() override { return this->display_->get_display_type(); }
+
+ protected:
+  int get_height_internal() override { return this->display_->get_native_height(); }
+  int get_width_internal() override { return this->display_->get_native_width(); }
+
+  Display *display_;
+};
+
+bool Display::page_unchanged_() {
+  if (!this->page_cache_enabled_)
+    return false;
+  // The test card stops the poller, it must only run for real
+  if (this->show_test_card_) {
+    this->page_fingerprint_valid_ = false;
+    return false;
+  }
+
+  // The writer draws on a stand-in, so no driver override of draw_pixel_at() and friends can draw for real
+  PageRecorder recorder(this);
+  if (this->page_ != nullptr) {
+    this->page_->get_writer()(recorder);
+  } else if (this->writer_.has_value()) {
+    (*this->writer_)(recorder);
+  }
+
+  bool unchanged = this->page_fingerprint_valid_ && recorder.fingerprint_ == this->page_fingerprint_;
+  this->page_fingerprint_ = recorder.fingerprint_;
+  this->page_fingerprint_valid_ = true;
+  if (unchanged)
+    ESP_LOGV(TAG, "Page unchanged, skipping update");
+  return unchanged;
+}
+bool Display::record_pixels_(int x_start, int y_start, int w, int h, const uint8_t *ptr, ColorOrder order,
+                             ColorBitness bitness, bool big_endian, int x_offset, int y_offset, int x_pad) {
+  if (!this->recording_)
+    return false;
+  this->record_(RECORD_PIXELS, x_start, y_start, w, h, order, bitness, big_endian);
+  size_t bytes_per_pixel = bitness == COLOR_BITNESS_888 ? 3 : bitness == COLOR_BITNESS_565 ? 2 : 1;
+  size_t line_stride = (x_offset + w + x_pad) * bytes_per_pixel;
+  for (int y = 0; y < h; y++) {
+    const uint8_t *row = ptr + (y_offset + y) * line_stride + x_offset * bytes_per_pixel;
+    for (size_t i = 0; i < w * bytes_per_pixel; i++)
+      this->fingerprint_mix_(row[i]);
+  }
+  return true;
+}
+void Display::fingerprint_mix_(float value) {
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  this->fingerprint_mix_(bits);
+}
+void Display::fingerprint_mix_(const char *text) {
+  for (; *text != '\0'; text++)
+    this->fingerprint_mix_(uint32_t(uint8_t(*text)));
+  // Terminate, so that consecutive strings can't run into each other
+  this->fingerprint_mix_(0u);
+}
 void DisplayOnPageChangeTrigger::process(DisplayPage *from, DisplayPage *to) {
   if ((this->from_ == nullptr || this->from_ == from) && (this->to_ == nullptr || this->to_ == to))
     this->trigger(from, to);
@@ -684,32 +708,45 @@ void Display::strftime(int x, int y, BaseFont *font, const char *format, ESPTime
 }
 
 void Display::start_clipping(Rect rect) {
+  this->record_(RECORD_START_CLIPPING, rect.x, rect.y, rect.w, rect.h);
   if (!this->clipping_rectangle_.empty()) {
     Rect r = this->clipping_rectangle_.back();
-    rect.shrink(r);
+    if (!rect.is_set()) {
+      // The entire screen, as far as the enclosing clipping allows
+      rect = r;
+    } else if (r.is_set()) {
+      rect.shrink(r);
+    }
   }
   this->clipping_rectangle_.push_back(rect);
+  this->update_clip_();
 }
 void Display::end_clipping() {
+  this->record_(RECORD_END_CLIPPING);
   if (this->clipping_rectangle_.empty()) {
     ESP_LOGE(TAG, "clear: Clipping is not set.");
   } else {
     this->clipping_rectangle_.pop_back();
   }
+  this->update_clip_();
 }
 void Display::extend_clipping(Rect add_rect) {
+  this->record_(RECORD_EXTEND_CLIPPING, add_rect.x, add_rect.y, add_rect.w, add_rect.h);
   if (this->clipping_rectangle_.empty()) {
     ESP_LOGE(TAG, "add: Clipping is not set.");
   } else {
     this->clipping_rectangle_.back().extend(add_rect);
   }
+  this->update_clip_();
 }
 void Display::shrink_clipping(Rect add_rect) {
+  this->record_(RECORD_SHRINK_CLIPPING, add_rect.x, add_rect.y, add_rect.w, add_rect.h);
   if (this->clipping_rectangle_.empty()) {
     ESP_LOGE(TAG, "add: Clipping is not set.");
   } else {
     this->clipping_rectangle_.back().shrink(add_rect);
   }
+  this->update_clip_();
 }
 Rect Display::get_clipping() const {
   if (this->clipping_rectangle_.empty()) {
@@ -718,42 +755,33 @@ Rect Display::get_clipping() const {
     return this->clipping_rectangle_.back();
   }
 }
-void Display::clear_clipping_() { this->clipping_rectangle_.clear(); }
-bool Display::clip(int x, int y) {
-  if (x < 0 || x >= this->get_width() || y < 0 || y >= this->get_height())
-    return false;
-  if (!this->get_clipping().inside(x, y))
-    return false;
-  return true;
+void Display::clear_clipping_() {
+  this->clipping_rectangle_.clear();
+  this->update_clip_();
 }
-bool Display::clamp_x_(int x, int w, int &min_x, int &max_x) {
-  min_x = std::max(x, 0);
-  max_x = std::min(x + w, this->get_width());
-
+void Display::update_clip_() {
+  this->clip_x1_ = 0;
+  this->clip_y1_ = 0;
+  this->clip_x2_ = this->get_width();
+  this->clip_y2_ = this->get_height();
   if (!this->clipping_rectangle_.empty()) {
-    const auto &rect = this->clipping_rectangle_.back();
-    if (!rect.is_set())
-      return false;
-
-    min_x = std::max(min_x, (int) rect.x);
-    max_x = std::min(max_x, (int) rect.x2());
+    const Rect &rect = this->clipping_rectangle_.back();
+    if (rect.is_set()) {
+      this->clip_x1_ = std::max(this->clip_x1_, int(rect.x));
+      this->clip_y1_ = std::max(this->clip_y1_, int(rect.y));
+      this->clip_x2_ = std::min(this->clip_x2_, int(rect.x2()));
+      this->clip_y2_ = std::min(this->clip_y2_, int(rect.y2()));
+    }
   }
-
+}
+bool Display::clamp_x_(int x, int w, int &min_x, int &max_x) {
+  min_x = std::max(x, this->clip_x1_);
+  max_x = std::min(x + w, this->clip_x2_);
   return min_x < max_x;
 }
 bool Display::clamp_y_(int y, int h, int &min_y, int &max_y) {
-  min_y = std::max(y, 0);
-  max_y = std::min(y + h, this->get_height());
-
-  if (!this->clipping_rectangle_.empty()) {
-    const auto &rect = this->clipping_rectangle_.back();
-    if (!rect.is_set())
-      return false;
-
-    min_y = std::max(min_y, (int) rect.y);
-    max_y = std::min(max_y, (int) rect.y2());
-  }
-
+  min_y = std::max(y, this->clip_y1_);
+  max_y = std::min(y + h, this->clip_y2_);
   return min_y < max_y;
 }
 
@@ -4,6 +4,8 @@
 #include <vector>
 
 #include "rect.h"
+#include "scanline.h"
+#include "text_cache.h"
 
 #include "esphome/core/color.h"
 #include "esphome/core/automation.h"
@@ -23,6 +25,10 @@
 #include "esphome/components/graphical_display_menu/graphical_display_menu.h"
 #endif
 
+#ifdef USE_SENSOR
+#include "esphome/components/sensor/sensor.h"
+#endif
+
 namespace esphome {
 namespace display {
 
@@ -205,6 +211,18 @@ class BaseFont {
   virtual void measure(const char *str, int *width, int *x_offset, int *baseline, int *height) = 0;
 };
 
+/// What the last update cost, and totals since boot.
+struct DisplayStats {
+  uint32_t render_us{0};       ///< Time spent drawing the page, fingerprinting for the page cache included
+  /// Pixels written by the page, one at a time, in spans and from images. Drawn in bands, every band counts.
+  uint32_t pixels{0};
+  uint32_t spans{0};           ///< Row and column spans filled by the page
+  uint32_t bytes_sent{0};      ///< Image data transferred to the panel
+  uint32_t refresh_ms{0};      ///< Time from the start of the transfer until the panel finished refreshing
+  uint32_t frames{0};          ///< Updates since boot
+  uint32_t skipped_frames{0};  ///< Updates since boot that sent nothing to the panel
+};
+
 class Display : public PollingComponent {
  public:
   /// Fill the entire screen with the given color.
@@ -228,6 +246,19 @@ class Display : public PollingComponent {
   /// Set a single pixel at the specified coordinates to the given color.
   virtual void draw_pixel_at(int x, int y, Color color) = 0;
 
+  /** Fill a run of pixels in one row, the building block of lines, rectangles and filled shapes.
+   * The naive implementation here draws pixel by pixel, buffer-backed displays override it to write whole spans.
+   *
+   * \param x The first pixel of the run
+   * \param y The row
+   * \param width The number of pixels in the run, nothing is drawn when it is not positive
+   * \param color The color to fill with
+   */
+  virtual void fill_row(int x, int y, int width, Color color);
+
+  /// Fill a run of pixels in one column, see fill_row().
+  virtual void fill_column(int x, int y, int height, Color color);
+
   /** Given an array of pixels encoded in the nominated format, draw these into the display's buffer.
    * The naive implementation here will work in all cases, but can be overridden by sub-classes
    * in order to optimise the procedure.
@@ -599,6 +630,36 @@ class Display : public PollingComponent {
   // Internal method to set display auto clearing.
   void set_auto_clear(bool auto_clear_enabled) { this->auto_clear_enabled_ = auto_clear_enabled; }
 
+  /** Skip pages whose draw calls did not change since the last update.
+   *
+   * Every update first runs the page writer on a stand-in display that draws nothing and fingerprints the calls
+   * it makes, arguments and text included. When the fingerprint matches the previous one the buffer still holds
+   * that frame, so drawing and sending it are skipped. Otherwise the writer runs a second time to draw the page,
+   * so it is called twice per changed page (once more per band when drawing in bands). Its side effects happen
+   * each time: logging, counters, animation state or publish_state() calls in a writer run twice, so writers used
+   * with the page cache should only draw. Images, graphs and other content drawn by another component are
+   * fingerprinted by the pixels they produce.
+   */
+  void set_page_cache(bool page_cache) { this->page_cache_enabled_ = page_cache; }
+
+  /// Draw the next page even if its draw calls did not change, for when the buffer or panel lost the frame.
+  void invalidate_page_cache() { this->page_fingerprint_valid_ = false; }
+
+  /// Keep up to this many rendered strings to draw them again as spans, 0 disables the text cache.
+  void set_text_cache_size(size_t size) { this->text_cache_.set_capacity(size); }
+
+  /// Counters of the last update, refreshed whenever an update went out to the panel or was skipped.
+  const DisplayStats &get_stats() const { return this->stats_; }
+
+#ifdef USE_SENSOR
+  void set_render_time_sensor(sensor::Sensor *sensor) { this->render_time_sensor_ = sensor; }
+  void set_pixels_sensor(sensor::Sensor *sensor) { this->pixels_sensor_ = sensor; }
+  void set_spans_sensor(sensor::Sensor *sensor) { this->spans_sensor_ = sensor; }
+  void set_bytes_sent_sensor(sensor::Sensor *sensor) { this->bytes_sent_sensor_ = sensor; }
+  void set_refresh_time_sensor(sensor::Sensor *sensor) { this->refresh_time_sensor_ = sensor; }
+  void set_skipped_frames_sensor(sensor::Sensor *sensor) { this->skipped_frames_sensor_ = sensor; }
+#endif
+
   DisplayRotation get_rotation() const { return this->rotation_; }
 
   /** Get the type of display that the buffer corresponds to. In case of dynamically configurable displays,
@@ -651,11 +712,18 @@ class Display : public PollingComponent {
 
   /** Check if pixel is within region of display.
    */
-  bool clip(int x, int y);
+  bool clip(int x, int y) const {
+    return x >= this->clip_x1_ && x < this->clip_x2_ && y >= this->clip_y1_ && y < this->clip_y2_;
+  }
 
   void test_card();
   void show_test_card() { this->show_test_card_ = true; }
-  void do_update_();
+
+  /** Draw the active page, or the writer lambda, into the buffer.
+   *
+   * @return false if the page cache found the page unchanged, nothing was drawn and the buffer still holds it
+   */
+  bool do_update_();
 
  protected:
   bool clamp_x_(int x, int w, int &min_x, int &max_x);
@@ -664,18 +732,88 @@ class Display : public PollingComponent {
                 va_list arg);
 
   void clear_clipping_();
+  /// Intersect the top of the clipping stack with the screen, whenever either of them changes.
+  void update_clip_();
+
+  /// Place text of the given measurements at the anchor point [x,y].
+  void align_text_(int x, int y, TextAlign align, int width, int baseline, int height, int *x1, int *y1);
+
+  /// Clear if auto clear is enabled and run the test card, the active page or the writer lambda.
+  void render_page_();
+
+  /// Start counting for a new update, returns the start time to pass to end_render_stats_().
+  uint32_t begin_render_stats_();
+  void end_render_stats_(uint32_t start);
+
+  /** Log and publish the counters of an update once the driver is done with it.
+   *
+   * @param sent false if nothing was transferred to the panel
+   */
+  void report_stats_(bool sent);
+
+  /** Run the page writer on a stand-in that draws nothing and compare the fingerprint of its draw calls to the previous one.
+   *
+   * @return true if the page cache is enabled and the page is the same as on the last update
+   */
+  bool page_unchanged_();
+
+  /// Draw calls that end up in the page fingerprint
+  enum RecordedCall : uint8_t {
+    RECORD_PAGE,
+    RECORD_FILL,
+    RECORD_PIXEL,
+    RECORD_PIXELS,
+    RECORD_ROW,
+    RECORD_COLUMN,
+    RECORD_LINE,
+    RECORD_LINE_AT_ANGLE,
+    RECORD_RECTANGLE,
+    RECORD_FILLED_RECTANGLE,
+    RECORD_CIRCLE,
+    RECORD_FILLED_CIRCLE,
+    RECORD_FILLED_RING,
+    RECORD_FILLED_GAUGE,
+    RECORD_TRIANGLE,
+    RECORD_FILLED_TRIANGLE,
+    RECORD_REGULAR_POLYGON,
+    RECORD_PRINT,
+    RECORD_START_CLIPPING,
+    RECORD_EXTEND_CLIPPING,
+    RECORD_SHRINK_CLIPPING,
+    RECORD_END_CLIPPING,
+  };
+
+  /** Mix a draw call and its arguments into the page fingerprint while the page is being fingerprinted.
+   *
+   * @return true if the call is only recorded and must not draw anything
+   */
+  template<typename... Ts> inline bool record_(RecordedCall call, Ts... args) {
+    if (!this->recording_)
+      return false;
+    this->fingerprint_mix_(call);
+    (this->fingerprint_mix_(args), ...);
+    return true;
+  }
+  /// Record a block of encoded pixels by its content, the same data may change between updates.
+  bool record_pixels_(int x_start, int y_start, int w, int h, const uint8_t *ptr, ColorOrder order,
+                      ColorBitness bitness, bool big_endian, int x_offset, int y_offset, int x_pad);
+
+  /// FNV-1a, a word at a time
+  void fingerprint_mix_(uint32_t value) { this->fingerprint_ = (this->fingerprint_ ^ value) * 16777619u; }
+  void fingerprint_mix_(int value) { this->fingerprint_mix_(uint32_t(value)); }
+  void fingerprint_mix_(Color color) { this->fingerprint_mix_(color.raw_32); }
+  void fingerprint_mix_(float value);
+  void fingerprint_mix_(const char *text);
 
   virtual int get_height_internal() = 0;
   virtual int get_width_internal() = 0;
 
   /**
-   * This method fills a triangle using only integer variables by using a
-   * modified bresenham algorithm.
-   * It is mandatory that [x2,y2] and [x3,y3] lie on the same horizontal line,
-   * so y2 must be equal to y3.
+   * This method fills a convex polygon scanline by scanline, stepping along its edges
+   * with integer arithmetic only and drawing one span per row.
+   * Every edge is advanced in place, so the list can only be drawn once.
    */
-  void filled_flat_side_triangle_(int x1, int y1, int x2, int y2, int x3, int y3, Color color);
-  void sort_triangle_points_by_y_(int *x1, int *y1, int *x2, int *y2, int *x3, int *y3);
+  void filled_polygon_(ScanEdge *edges, size_t count, Color color);
 
   DisplayRotation rotation_{DISPLAY_ROTATION_0_DEGREES};
   optional<display_writer_t> writer_{};
@@ -684,7 +822,29 @@ class Display : public PollingComponent {
   std::vector<DisplayOnPageChangeTrigger *> on_page_change_triggers_;
   bool auto_clear_enabled_{true};
   std::vector<Rect> clipping_rectangle_;
+  /// The clipping stack intersected with the screen, x2 and y2 are exclusive. Checked for every pixel drawn.
+  int clip_x1_{0};
+  int clip_y1_{0};
+  int clip_x2_{0};
+  int clip_y2_{0};
   bool show_test_card_{false};
+
+  bool page_cache_enabled_{false};
+  /// Set on the stand-in the page writer draws on to fingerprint the page, draw calls are recorded and not drawn
+  bool recording_{false};
+  bool page_fingerprint_valid_{false};
+  uint32_t fingerprint_{0};
+  uint32_t page_fingerprint_{0};
+  TextRunCache text_cache_;
+  DisplayStats stats_;
+#ifdef USE_SENSOR
+  sensor::Sensor *render_time_sensor_{nullptr};
+  sensor::Sensor *pixels_sensor_{nullptr};
+  sensor::Sensor *spans_sensor_{nullptr};
+  sensor::Sensor *bytes_sent_sensor_{nullptr};
+  sensor::Sensor *refresh_time_sensor_{nullptr};
+  sensor::Sensor *skipped_frames_sensor_{nullptr};
+#endif
 };
 
 class DisplayPage {
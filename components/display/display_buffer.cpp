@@ -11,6 +11,12 @@ namespace display {
 static const char *const TAG = "display";
 
 void DisplayBuffer::init_internal_(uint32_t buffer_length) {
+  this->native_width_ = this->get_width_internal();
+  this->native_height_ = this->get_height_internal();
+  if (this->band_rows_ == 0)
+    this->band_rows_ = this->native_height_;
+  this->update_clip_();
+
   ExternalRAMAllocator<uint8_t> allocator(ExternalRAMAllocator<uint8_t>::ALLOW_FAILURE);
   this->buffer_ = allocator.allocate(buffer_length);
   if (this->buffer_ == nullptr) {
@@ -20,6 +26,26 @@ void DisplayBuffer::init_internal_(uint32_t buffer_length) {
   this->clear();
 }
 
+bool DisplayBuffer::render_bands_(int band_height, const std::function<void(int, int)> &flush_band) {
+  // Fingerprinted once for the whole page, the bands only hold a part of the frame
+  uint32_t start = this->begin_render_stats_();
+  if (this->page_unchanged_()) {
+    this->end_render_stats_(start);
+    return false;
+  }
+  for (int y = 0; y < this->native_height_; y += band_height) {
+    this->band_y_ = y;
+    this->band_rows_ = std::min(band_height, this->native_height_ - y);
+    // The strip still holds the previous band
+    if (!this->auto_clear_enabled_)
+      this->clear();
+    this->render_page_();
+    flush_band(this->band_y_, this->band_rows_);
+  }
+  this->end_render_stats_(start);
+  return true;
+}
+
 int DisplayBuffer::get_width() {
   switch (this->rotation_) {
     case DISPLAY_ROTATION_90_DEGREES:
@@ -45,27 +71,120 @@ int DisplayBuffer::get_height() {
 }
 
 void HOT DisplayBuffer::draw_pixel_at(int x, int y, Color color) {
-  if (!this->get_clipping().inside(x, y))
-    return;  // NOLINT
+  if (this->transform_pixel_(x, y))
+    this->draw_absolute_pixel_internal(x, y, color);
+}
+
+void DisplayBuffer::feed_wdt_() { App.feed_wdt(); }
+
+bool DisplayBuffer::clip_span_(int &start, int &length, int pos, bool horizontal) {
+  if (horizontal ? (pos < this->clip_y1_ || pos >= this->clip_y2_) : (pos < this->clip_x1_ || pos >= this->clip_x2_))
+    return false;
+
+  int end = std::min(start + length, horizontal ? this->clip_x2_ : this->clip_y2_);
+  start = std::max(start, horizontal ? this->clip_x1_ : this->clip_y1_);
+  length = end - start;
+  return length > 0;
+}
+
+void HOT DisplayBuffer::fill_row(int x, int y, int width, Color color) {
+  if (!this->clip_span_(x, width, y, true))
+    return;
 
   switch (this->rotation_) {
     case DISPLAY_ROTATION_0_DEGREES:
+      this->draw_absolute_row_internal(x, y, width, color);
       break;
     case DISPLAY_ROTATION_90_DEGREES:
-      std::swap(x, y);
-      x = this->get_width_internal() - x - 1;
+      this->draw_absolute_column_internal(this->native_width_ - y - 1, x, width, color);
       break;
     case DISPLAY_ROTATION_180_DEGREES:
-      x = this->get_width_internal() - x - 1;
-      y = this->get_height_internal() - y - 1;
+      this->draw_absolute_row_internal(this->native_width_ - x - width, this->native_height_ - y - 1, width, color);
       break;
     case DISPLAY_ROTATION_270_DEGREES:
-      std::swap(x, y);
-      y = this->get_height_internal() - y - 1;
+      this->draw_absolute_column_internal(y, this->native_height_ - x - width, width, color);
       break;
   }
-  this->draw_absolute_pixel_internal(x, y, color);
-  App.feed_wdt();
+  this->stats_.spans++;
+  this->stats_.pixels += width;
+  this->feed_wdt_();
+}
+
+void HOT DisplayBuffer::fill_column(int x, int y, int height, Color color) {
+  if (!this->clip_span_(y, height, x, false))
+    return;
+
+  switch (this->rotation_) {
+    case DISPLAY_ROTATION_0_DEGREES:
+      this->draw_absolute_column_internal(x, y, height, color);
+      break;
+    case DISPLAY_ROTATION_90_DEGREES:
+      this->draw_absolute_row_internal(this->native_width_ - y - height, x, height, color);
+      break;
+    case DISPLAY_ROTATION_180_DEGREES:
+      this->draw_absolute_column_internal(this->native_width_ - x - 1, this->native_height_ - y - height, height, color);
+      break;
+    case DISPLAY_ROTATION_270_DEGREES:
+      this->draw_absolute_row_internal(y, this->native_height_ - x - 1, height, color);
+      break;
+  }
+  this->stats_.spans++;
+  this->stats_.pixels += height;
+  this->feed_wdt_();
+}
+
+void HOT DisplayBuffer::draw_pixels_at(int x_start, int y_start, int w, int h, const uint8_t *ptr, ColorOrder order,
+                                       ColorBitness bitness, bool big_endian, int x_offset, int y_offset, int x_pad) {
+  // Clip the whole block up front
+  int x1, x2, y1, y2;
+  if (!this->clamp_x_(x_start, w, x1, x2) || !this->clamp_y_(y_start, h, y1, y2))
+    return;
+
+  PixelDecoder decoder(order, bitness, big_endian);
+  const size_t line_stride = x_offset + w + x_pad;  // length of each source line in pixels
+  const uint8_t bytes_per_pixel = decoder.bytes_per_pixel();
+  const int count = x2 - x1;
+  if (this->blit_row_.size() < size_t(count))
+    this->blit_row_.resize(count);
+  Color *row = this->blit_row_.data();
+  this->stats_.pixels += count * (y2 - y1);
+
+  for (int y = y1; y != y2; y++) {
+    size_t source_idx = (y_offset + y - y_start) * line_stride + x_offset + x1 - x_start;
+    decoder.decode_row(ptr + source_idx * bytes_per_pixel, count, row);
+
+    switch (this->rotation_) {
+      case DISPLAY_ROTATION_0_DEGREES:
+        this->draw_absolute_pixels_internal(x1, y, 1, 0, count, row);
+        break;
+      case DISPLAY_ROTATION_90_DEGREES:
+        this->draw_absolute_pixels_internal(this->native_width_ - y - 1, x1, 0, 1, count, row);
+        break;
+      case DISPLAY_ROTATION_180_DEGREES:
+        this->draw_absolute_pixels_internal(this->native_width_ - x1 - 1, this->native_height_ - y - 1, -1, 0, count,
+                                            row);
+        break;
+      case DISPLAY_ROTATION_270_DEGREES:
+        this->draw_absolute_pixels_internal(y, this->native_height_ - x1 - 1, 0, -1, count, row);
+        break;
+    }
+    this->feed_wdt_();
+  }
+}
+
+void HOT DisplayBuffer::draw_absolute_pixels_internal(int x, int y, int dx, int dy, int count, const Color *colors) {
+  for (int i = 0; i != count; i++, x += dx, y += dy)
+    this->draw_absolute_pixel_internal(x, y, colors[i]);
+}
+
+void HOT DisplayBuffer::draw_absolute_row_internal(int x, int y, int width, Color color) {
+  for (int i = x; i < x + width; i++)
+    this->draw_absolute_pixel_internal(i, y, color);
+}
+
+void HOT DisplayBuffer::draw_absolute_column_internal(int x, int y, int height, Color color) {
+  for (int i = y; i < y + height; i++)
+    this->draw_absolute_pixel_internal(x, i, color);
 }
 
 }  // namespace display
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <cstdarg>
+#include <functional>
+#include <utility>
 #include <vector>
 
 #include "display.h"
@@ -22,12 +24,94 @@ class DisplayBuffer : public Display {
   /// Set a single pixel at the specified coordinates to the given color.
   void draw_pixel_at(int x, int y, Color color) override;
 
+  using Display::draw_pixels_at;
+  /// Clip the block once, then decode it a row at a time straight into the buffer.
+  void draw_pixels_at(int x_start, int y_start, int w, int h, const uint8_t *ptr, ColorOrder order,
+                      ColorBitness bitness, bool big_endian, int x_offset, int y_offset, int x_pad) override;
+
+  /// Clip a row span and hand it to the buffer as a native row or column, depending on rotation.
+  void fill_row(int x, int y, int width, Color color) override;
+  /// Clip a column span and hand it to the buffer as a native row or column, depending on rotation.
+  void fill_column(int x, int y, int height, Color color) override;
+
  protected:
   virtual void draw_absolute_pixel_internal(int x, int y, Color color) = 0;
 
+  /// Fill a run of native pixels in one row, already clipped. Buffers override this to write the span at once.
+  virtual void draw_absolute_row_internal(int x, int y, int width, Color color);
+  /// Fill a run of native pixels in one column, already clipped.
+  virtual void draw_absolute_column_internal(int x, int y, int height, Color color);
+
+  /** Write a run of decoded pixels, starting at native [x,y] and moving by [dx,dy] after each one.
+   * The run is already clipped. Buffers override this to skip the per-pixel virtual call.
+   */
+  virtual void draw_absolute_pixels_internal(int x, int y, int dx, int dy, int count, const Color *colors);
+
+  /// Clip a span that runs from start along one axis at the fixed coordinate pos, false if nothing is left.
+  /// Pixels outside of the screen are clipped as well.
+  bool clip_span_(int &start, int &length, int pos, bool horizontal);
+
   void init_internal_(uint32_t buffer_length);
 
+  /** Draw the page once per band of native rows, for buffers that only hold band_height rows of the panel.
+   *
+   * The buffer is cleared before every band, also with auto clear off, and the page writer runs once per band.
+   * Buffers that support bands keep pixels outside [band_y_, band_y_ + band_rows_) out of the buffer.
+   *
+   * @param band_height Number of native rows held by the buffer
+   * @param flush_band Called with the first native row and the number of rows once a band is drawn
+   * @return false if the page cache found the page unchanged and no band was drawn
+   */
+  bool render_bands_(int band_height, const std::function<void(int, int)> &flush_band);
+
+  /** Clip a pixel and map it from rotated to native coordinates.
+   *
+   * Buffers that override draw_pixel_at() can use this and write the pixel without any virtual call.
+   *
+   * @return false if the pixel is clipped away
+   */
+  inline bool transform_pixel_(int &x, int &y) ESPHOME_ALWAYS_INLINE {
+    if (!this->clip(x, y))
+      return false;
+
+    switch (this->rotation_) {
+      case DISPLAY_ROTATION_0_DEGREES:
+        break;
+      case DISPLAY_ROTATION_90_DEGREES:
+        std::swap(x, y);
+        x = this->native_width_ - x - 1;
+        break;
+      case DISPLAY_ROTATION_180_DEGREES:
+        x = this->native_width_ - x - 1;
+        y = this->native_height_ - y - 1;
+        break;
+      case DISPLAY_ROTATION_270_DEGREES:
+        std::swap(x, y);
+        y = this->native_height_ - y - 1;
+        break;
+    }
+
+    this->stats_.pixels++;
+    // Long primitives still have to keep the watchdog happy, but not on every pixel
+    if ((++this->pixels_since_wdt_ & WDT_PIXEL_INTERVAL_MASK) == 0)
+      this->feed_wdt_();
+    return true;
+  }
+
+  void feed_wdt_();
+
+  static constexpr uint32_t WDT_PIXEL_INTERVAL_MASK = 0x3FFF;
+
   uint8_t *buffer_{nullptr};
+  /// Native dimensions cached by init_internal_(), they never change after setup
+  int native_width_{0};
+  int native_height_{0};
+  /// Native rows held by the buffer, all of them unless the page is drawn in bands
+  int band_y_{0};
+  int band_rows_{0};
+  uint32_t pixels_since_wdt_{0};
+  /// Decoded row of the image being blitted, kept to avoid an allocation per image
+  std::vector<Color> blit_row_;
 };
 
 }  // namespace display
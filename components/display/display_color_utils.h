@@ -155,5 +155,108 @@ class ColorUtil {
     return color;
   }
 };
+
+/** Decodes rows of packed source pixels into Color values for blitting.
+ *
+ * Gives the same result as ColorUtil::to_color(), but the format switch is taken once per row
+ * and the channel scaling comes from tables that are built once per image.
+ */
+class PixelDecoder {
+ public:
+  PixelDecoder(ColorOrder order, ColorBitness bitness, bool big_endian) : bitness_(bitness), big_endian_(big_endian) {
+    switch (order) {
+      case COLOR_ORDER_RGB:
+        this->channel_[0] = 0;
+        this->channel_[1] = 1;
+        this->channel_[2] = 2;
+        break;
+      case COLOR_ORDER_BGR:
+        this->channel_[0] = 2;
+        this->channel_[1] = 1;
+        this->channel_[2] = 0;
+        break;
+      case COLOR_ORDER_GRB:
+        this->channel_[0] = 1;
+        this->channel_[1] = 0;
+        this->channel_[2] = 2;
+        break;
+    }
+
+    uint8_t bits[3];
+    switch (bitness) {
+      case COLOR_BITNESS_565:
+        bits[0] = 5;
+        bits[1] = 6;
+        bits[2] = 5;
+        break;
+      case COLOR_BITNESS_332:
+        bits[0] = 3;
+        bits[1] = 3;
+        bits[2] = 2;
+        break;
+      case COLOR_BITNESS_888:
+      default:
+        return;
+    }
+    for (uint8_t c = 0; c < 3; c++) {
+      uint8_t max_value = (1 << bits[c]) - 1;
+      for (uint8_t i = 0; i <= max_value; i++)
+        this->lut_[c][i] = esp_scale(i, max_value);
+    }
+  }
+
+  /// Number of bytes one source pixel takes.
+  uint8_t bytes_per_pixel() const {
+    switch (this->bitness_) {
+      case COLOR_BITNESS_888:
+        return 3;
+      case COLOR_BITNESS_565:
+        return 2;
+      default:
+        return 1;
+    }
+  }
+
+  /// Decode count consecutive pixels starting at src into out.
+  void decode_row(const uint8_t *src, int count, Color *out) const {
+    switch (this->bitness_) {
+      case COLOR_BITNESS_888:
+        for (int i = 0; i != count; i++, src += 3) {
+          out[i] = this->make_(this->big_endian_ ? src[0] : src[2], src[1], this->big_endian_ ? src[2] : src[0]);
+        }
+        break;
+      case COLOR_BITNESS_565:
+        for (int i = 0; i != count; i++, src += 2) {
+          uint16_t value = this->big_endian_ ? (src[0] << 8) | src[1] : src[0] | (src[1] << 8);
+          out[i] = this->make_(this->lut_[0][value >> 11], this->lut_[1][(value >> 5) & 0x3F],
+                               this->lut_[2][value & 0x1F]);
+        }
+        break;
+      default:
+        for (int i = 0; i != count; i++, src++) {
+          uint8_t value = *src;
+          out[i] = this->make_(this->lut_[0][value >> 5], this->lut_[1][(value >> 2) & 0x07], this->lut_[2][value & 0x03]);
+        }
+        break;
+    }
+  }
+
+ protected:
+  inline Color make_(uint8_t first, uint8_t second, uint8_t third) const ESPHOME_ALWAYS_INLINE {
+    Color color;
+    color.raw[this->channel_[0]] = first;
+    color.raw[this->channel_[1]] = second;
+    color.raw[this->channel_[2]] = third;
+    return color;
+  }
+
+  ColorBitness bitness_;
+  bool big_endian_;
+  /// Index into Color::raw for the first, second and third source component.
+  uint8_t channel_[3]{0, 1, 2};
+  /// Source component value to 8 bits, for 565 and 332.
+  uint8_t lut_[3][64];
+};
+
 }  // namespace display
 }  // namespace esphome
@@ -26,7 +26,9 @@ class Rect {
   void extend(Rect rect);
   void shrink(Rect rect);
 
+  /// True if both overlap by at least one pixel, x2() and y2() are outside of a rect.
   bool inside(Rect rect, bool absolute = true) const;
+  /// True if the pixel is covered, x2() and y2() are outside of a rect.
   bool inside(int16_t test_x, int16_t test_y, bool absolute = true) const;
   bool equal(Rect rect) const;
   void info(const std::string &prefix = "rect info:");
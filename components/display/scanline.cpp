@@ -0,0 +1,102 @@
+#include "scanline.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace esphome {
+namespace display {
+
+// round(sin(x) * 16384) for every whole degree of the first quadrant.
+static const int16_t SIN_TABLE[91] = {
+    0,     286,   572,   857,   1143,  1428,  1713,  1997,  2280,  2563,  2845,  3126,  3406,  3686,  3964,  4240,
+    4516,  4790,  5063,  5334,  5604,  5872,  6138,  6402,  6664,  6924,  7182,  7438,  7692,  7943,  8192,  8438,
+    8682,  8923,  9162,  9397,  9630,  9860,  10087, 10311, 10531, 10749, 10963, 11174, 11381, 11585, 11786, 11982,
+    12176, 12365, 12551, 12733, 12911, 13085, 13255, 13421, 13583, 13741, 13894, 14044, 14189, 14330, 14466, 14598,
+    14726, 14849, 14968, 15082, 15191, 15296, 15396, 15491, 15582, 15668, 15749, 15826, 15897, 15964, 16026, 16083,
+    16135, 16182, 16225, 16262, 16294, 16322, 16344, 16362, 16374, 16382, 16384,
+};
+
+static inline int floor_div(int numerator, int denominator) {
+  int quotient = numerator / denominator;
+  if ((numerator % denominator != 0) && ((numerator < 0) != (denominator < 0)))
+    quotient--;
+  return quotient;
+}
+
+int32_t sin_fixed(int32_t angle) {
+  static constexpr int32_t QUARTER = 90 * FIXED_ANGLE_SCALE;
+  angle %= 4 * QUARTER;
+  if (angle < 0)
+    angle += 4 * QUARTER;
+  bool negative = angle >= 2 * QUARTER;
+  if (negative)
+    angle -= 2 * QUARTER;
+  if (angle > QUARTER)
+    angle = 2 * QUARTER - angle;
+
+  int index = angle / FIXED_ANGLE_SCALE;
+  int fraction = angle % FIXED_ANGLE_SCALE;
+  int32_t value = SIN_TABLE[index];
+  if (fraction != 0)
+    value += ((SIN_TABLE[index + 1] - value) * fraction + FIXED_ANGLE_SCALE / 2) / FIXED_ANGLE_SCALE;
+  return negative ? -value : value;
+}
+
+ScanEdge::ScanEdge(int x1, int y1, int x2, int y2) {
+  this->x_start_ = x1;
+  this->x_left_ = std::min(x1, x2);
+  this->x_right_ = std::max(x1, x2);
+  this->y_top_ = std::min(y1, y2);
+  this->y_bottom_ = std::max(y1, y2);
+  int dx = std::abs(x2 - x1);
+  int dy = std::abs(y2 - y1);
+  this->sx_ = x1 < x2 ? 1 : -1;
+  int sy = y1 < y2 ? 1 : -1;
+  if (dy == 0) {
+    return;
+  }
+  // Counted from the start of the line in steps t along y, line() puts the pixel of a steep line at column
+  // floor((2dx * t + dy) / 2dy). A shallow line covers the columns from boundary t to boundary t + 1 exclusive, at
+  // ceil((2dx * t - dx) / 2dy). Rows are visited from the top, which walks t backwards for lines drawn upwards.
+  this->steep_ = dy > dx;
+  this->denominator_ = 2 * dy;
+  int t = sy > 0 ? 0 : (this->steep_ ? dy : dy + 1);
+  int numerator = 2 * dx * t + (this->steep_ ? dy : 2 * dy - 1 - dx);
+  this->quotient_ = floor_div(numerator, this->denominator_);
+  this->remainder_ = numerator - this->quotient_ * this->denominator_;
+  this->step_ = floor_div(sy * 2 * dx, this->denominator_);
+  this->step_rem_ = sy * 2 * dx - this->step_ * this->denominator_;
+}
+
+void ScanEdge::advance_() {
+  this->quotient_ += this->step_;
+  this->remainder_ += this->step_rem_;
+  if (this->remainder_ >= this->denominator_) {
+    this->remainder_ -= this->denominator_;
+    this->quotient_++;
+  }
+}
+
+void ScanEdge::step(int &x_min, int &x_max) {
+  int left = this->x_left_;
+  int right = this->x_right_;
+  if (this->y_top_ != this->y_bottom_) {
+    int first = this->quotient_;
+    int last = first;
+    this->advance_();
+    if (!this->steep_) {
+      // The boundaries grow along the line, the one with the higher column ends the run.
+      first = std::min(first, this->quotient_);
+      last = std::max(last, this->quotient_) - 1;
+    }
+    int x1 = this->x_start_ + this->sx_ * first;
+    int x2 = this->x_start_ + this->sx_ * last;
+    left = std::max(left, std::min(x1, x2));
+    right = std::min(right, std::max(x1, x2));
+  }
+  x_min = std::min(x_min, left);
+  x_max = std::max(x_max, right);
+}
+
+}  // namespace display
+}  // namespace esphome
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <cstdint>
+
+namespace esphome {
+namespace display {
+
+/// Fixed point scale of sin_fixed() and cos_fixed(), 1.0 == 1 << 14.
+static constexpr int FIXED_TRIG_SHIFT = 14;
+/// Angles for sin_fixed() and cos_fixed() are given in 1/16 degrees.
+static constexpr int32_t FIXED_ANGLE_SCALE = 16;
+
+/// Sine of an angle in 1/16 degrees as a 2.14 fixed point number, looked up and interpolated from a table.
+int32_t sin_fixed(int32_t angle);
+/// Cosine of an angle in 1/16 degrees as a 2.14 fixed point number.
+inline int32_t cos_fixed(int32_t angle) { return sin_fixed(angle + 90 * FIXED_ANGLE_SCALE); }
+
+/** Walks one quadrant of a circle with the midpoint algorithm, one scanline at a time.
+ *
+ * Every call to next() reports the distance of the next row from the center, starting at the center row, together
+ * with the horizontal distances of the outermost and innermost outline pixels on that row. Filled shapes use the
+ * outermost one as the span length, outlines draw everything in between.
+ */
+class CircleScanner {
+ public:
+  explicit CircleScanner(int radius) : dx_(-radius), err_(2 - 2 * radius) {}
+
+  /// Advance to the next row, returns false once the top of the circle has been passed.
+  inline bool next(int *dy, int *outer, int *inner) {
+    if (this->dx_ > 0)
+      return false;
+    *dy = this->dy_;
+    *outer = -this->dx_;
+    // The midpoint algorithm may take several steps along x before it moves to the next row.
+    do {
+      *inner = -this->dx_;
+      int e2 = this->err_;
+      if (e2 < this->dy_) {
+        this->err_ += ++this->dy_ * 2 + 1;
+        if (-this->dx_ == this->dy_ && e2 <= this->dx_) {
+          e2 = 0;
+        }
+      }
+      if (e2 > this->dx_) {
+        this->err_ += ++this->dx_ * 2 + 1;
+      }
+    } while (this->dx_ <= 0 && this->dy_ == *dy);
+    return true;
+  }
+
+ protected:
+  int dx_;
+  int dy_{0};
+  int err_;
+};
+
+/** Collects the spans of one row so that overlapping and adjacent ones are drawn as a single span.
+ *
+ * Shapes built from several parts, like the outlines and the filling of a gauge, touch on most rows. Drawing each
+ * part separately would pay the per-span overhead of the display several times for the same pixels.
+ */
+class RowSpans {
+ public:
+  static constexpr int MAX_SPANS = 8;
+
+  /// Add the pixels from x1 to x2, both inclusive. Nothing is added when x2 is left of x1.
+  void add(int x1, int x2) {
+    if (x1 > x2 || this->count_ == MAX_SPANS)
+      return;
+    // insertion sort by the first pixel, there are only a handful of spans
+    int i = this->count_++;
+    for (; i > 0 && this->spans_[i - 1][0] > x1; i--) {
+      this->spans_[i][0] = this->spans_[i - 1][0];
+      this->spans_[i][1] = this->spans_[i - 1][1];
+    }
+    this->spans_[i][0] = x1;
+    this->spans_[i][1] = x2;
+  }
+
+  /// Call draw(x, width) for every merged span and start over with an empty row.
+  template<typename F> void flush(F &&draw) {
+    for (int i = 0; i < this->count_;) {
+      int x1 = this->spans_[i][0];
+      int x2 = this->spans_[i][1];
+      for (i++; i < this->count_ && this->spans_[i][0] <= x2 + 1; i++) {
+        if (this->spans_[i][1] > x2)
+          x2 = this->spans_[i][1];
+      }
+      draw(x1, x2 - x1 + 1);
+    }
+    this->count_ = 0;
+  }
+
+ protected:
+  int spans_[MAX_SPANS][2];
+  int count_{0};
+};
+
+/** Steps along a straight polygon edge one scanline at a time, using only integer arithmetic.
+ *
+ * The edge covers the same pixels on every row as Display::line() drawn from (x1, y1) to (x2, y2), so a filled shape
+ * built from the edges includes its outline. Which pixels the line takes on a tie depends on the direction it is
+ * drawn in, give the end points in the same order as the outline does.
+ */
+class ScanEdge {
+ public:
+  ScanEdge() = default;
+  ScanEdge(int x1, int y1, int x2, int y2);
+
+  int top() const { return this->y_top_; }
+  int bottom() const { return this->y_bottom_; }
+
+  /// Extend [x_min, x_max] by the pixels the edge covers on the current row and advance to the next row.
+  /// Must be called once for every row from top() to bottom().
+  void step(int &x_min, int &x_max);
+
+ protected:
+  /// Advance the position by one row.
+  void advance_();
+
+  int x_start_{0};
+  int x_left_{0};
+  int x_right_{0};
+  int y_top_{0};
+  int y_bottom_{-1};
+  int sx_{1};           ///< Direction of x from the start of the line to its end
+  bool steep_{false};   ///< One pixel per row, otherwise a run of pixels between two boundaries
+  int quotient_{0};     ///< Columns from x_start_, in the direction of sx_, of the current pixel or boundary
+  int remainder_{0};    ///< Fraction of the current position, in [0, denominator_)
+  int step_{0};         ///< Whole columns per row
+  int step_rem_{0};     ///< Fraction per row
+  int denominator_{1};
+};
+
+}  // namespace display
+}  // namespace esphome
@@ -0,0 +1,87 @@
+import esphome.codegen as cg
+import esphome.config_validation as cv
+from esphome.components import sensor
+from esphome.const import (
+    ENTITY_CATEGORY_DIAGNOSTIC,
+    STATE_CLASS_MEASUREMENT,
+    STATE_CLASS_TOTAL_INCREASING,
+    UNIT_MILLISECOND,
+)
+from . import Display
+
+DEPENDENCIES = ["display"]
+
+CONF_DISPLAY_ID = "display_id"
+CONF_RENDER_TIME = "render_time"
+CONF_PIXELS = "pixels"
+CONF_SPANS = "spans"
+CONF_BYTES_SENT = "bytes_sent"
+CONF_REFRESH_TIME = "refresh_time"
+CONF_SKIPPED_FRAMES = "skipped_frames"
+
+ICON_TIMER = "mdi:timer-outline"
+ICON_DRAW = "mdi:draw"
+ICON_TRANSFER = "mdi:swap-horizontal"
+ICON_SKIP = "mdi:skip-next"
+
+CONFIG_SCHEMA = cv.Schema(
+    {
+        cv.GenerateID(CONF_DISPLAY_ID): cv.use_id(Display),
+        cv.Optional(CONF_RENDER_TIME): sensor.sensor_schema(
+            unit_of_measurement=UNIT_MILLISECOND,
+            icon=ICON_TIMER,
+            accuracy_decimals=1,
+            state_class=STATE_CLASS_MEASUREMENT,
+            entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        ),
+        cv.Optional(CONF_PIXELS): sensor.sensor_schema(
+            icon=ICON_DRAW,
+            accuracy_decimals=0,
+            state_class=STATE_CLASS_MEASUREMENT,
+            entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        ),
+        cv.Optional(CONF_SPANS): sensor.sensor_schema(
+            icon=ICON_DRAW,
+            accuracy_decimals=0,
+            state_class=STATE_CLASS_MEASUREMENT,
+            entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        ),
+        cv.Optional(CONF_BYTES_SENT): sensor.sensor_schema(
+            unit_of_measurement="B",
+            icon=ICON_TRANSFER,
+            accuracy_decimals=0,
+            state_class=STATE_CLASS_MEASUREMENT,
+            entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        ),
+        cv.Optional(CONF_REFRESH_TIME): sensor.sensor_schema(
+            unit_of_measurement=UNIT_MILLISECOND,
+            icon=ICON_TIMER,
+            accuracy_decimals=0,
+            state_class=STATE_CLASS_MEASUREMENT,
+            entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        ),
+        cv.Optional(CONF_SKIPPED_FRAMES): sensor.sensor_schema(
+            icon=ICON_SKIP,
+            accuracy_decimals=0,
+            state_class=STATE_CLASS_TOTAL_INCREASING,
+            entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        ),
+    }
+)
+
+SENSORS = {
+    CONF_RENDER_TIME: "set_render_time_sensor",
+    CONF_PIXELS: "set_pixels_sensor",
+    CONF_SPANS: "set_spans_sensor",
+    CONF_BYTES_SENT: "set_bytes_sent_sensor",
+    CONF_REFRESH_TIME: "set_refresh_time_sensor",
+    CONF_SKIPPED_FRAMES: "set_skipped_frames_sensor",
+}
+
+
+async def to_code(config):
+    parent = await cg.get_variable(config[CONF_DISPLAY_ID])
+    for key, setter in SENSORS.items():
+        if key in config:
+            sens = await sensor.new_sensor(config[key])
+            cg.add(getattr(parent, setter)(sens))
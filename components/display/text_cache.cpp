@@ -0,0 +1,134 @@
+#include "text_cache.h"
+
+#include <algorithm>
+
+#include "display.h"
+
+namespace esphome {
+namespace display {
+
+/// Stands in for the display while a font renders a string, collects what it draws as spans.
+class TextRecorder : public Display {
+ public:
+  TextRecorder(Display *target, std::vector<TextSpan> *spans, size_t max_spans)
+      : target_(target), spans_(spans), max_spans_(max_spans) {}
+
+  /// More spans were drawn than fit, the recording is incomplete.
+  bool is_overflowed() const { return this->overflowed_; }
+
+  void update() override {}
+
+  using Display::draw_pixel_at;
+  void draw_pixel_at(int x, int y, Color color) override { this->fill_row(x, y, 1, color); }
+
+  void fill_row(int x, int y, int width, Color color) override {
+    if (width <= 0 || this->overflowed_)
+      return;
+    // Fonts draw glyphs row by row from left to right, the pixels of a row mostly continue the last span
+    if (!this->spans_->empty()) {
+      TextSpan &last = this->spans_->back();
+      if (last.y == y && last.x + last.width == x && last.color == color) {
+        last.width += width;
+        return;
+      }
+    }
+    if (this->spans_->size() == this->max_spans_) {
+      this->overflowed_ = true;
+      return;
+    }
+    this->spans_->push_back(TextSpan{int16_t(x), int16_t(y), int16_t(width), color});
+  }
+
+  DisplayType get_display_type() override { return this->target_->get_display_type(); }
+
+ protected:
+  int get_width_internal() override { return this->target_->get_width(); }
+  int get_height_internal() override { return this->target_->get_height(); }
+
+  Display *target_;
+  std::vector<TextSpan> *spans_;
+  size_t max_spans_;
+  bool overflowed_{false};
+};
+
+void TextRunCache::set_capacity(size_t capacity) {
+  this->capacity_ = std::min(capacity, MAX_CAPACITY);
+  while (this->runs_.size() > this->capacity_)
+    this->evict_();
+  this->runs_.reserve(this->capacity_);
+  this->sightings_.assign(this->capacity_, Sighting{0, false});
+  this->next_sighting_ = 0;
+}
+
+void TextRunCache::evict_() {
+  auto it = std::min_element(this->runs_.begin(), this->runs_.end(),
+                             [](const TextRun &a, const TextRun &b) { return a.last_used < b.last_used; });
+  this->span_count_ -= it->spans.size();
+  std::swap(*it, this->runs_.back());
+  this->runs_.pop_back();
+}
+
+const TextRun *TextRunCache::get(Display *display, BaseFont *font, Color color, Color background, const char *text) {
+  if (this->capacity_ == 0)
+    return nullptr;
+
+  this->clock_++;
+  for (TextRun &run : this->runs_) {
+    if (run.font == font && run.color == color && run.background == background && run.text == text) {
+      run.last_used = this->clock_;
+      return &run;
+    }
+  }
+
+  // FNV-1a over what tells the strings apart; a collision only keeps a string early
+  uint32_t hash = 2166136261u;
+  auto mix = [&hash](uint32_t value) {
+    for (int i = 0; i < 4; i++, value >>= 8)
+      hash = (hash ^ (value & 0xFF)) * 16777619u;
+  };
+  mix(uint32_t(reinterpret_cast<uintptr_t>(font)));
+  mix(color.raw_32);
+  mix(background.raw_32);
+  for (const char *c = text; *c != '\0'; c++)
+    hash = (hash ^ uint8_t(*c)) * 16777619u;
+
+  // Strings seen for the first time are drawn directly, values that keep changing never get recorded
+  auto seen = std::find_if(this->sightings_.begin(), this->sightings_.end(),
+                           [hash](const Sighting &sighting) { return sighting.hash == hash; });
+  if (seen == this->sightings_.end()) {
+    this->sightings_[this->next_sighting_] = Sighting{hash, false};
+    this->next_sighting_ = (this->next_sighting_ + 1) % this->sightings_.size();
+    return nullptr;
+  }
+  if (seen->oversized)
+    return nullptr;
+
+  std::vector<TextSpan> spans;
+  TextRecorder recorder(display, &spans, MAX_RUN_SPANS);
+  font->print(0, 0, &recorder, color, text, background);
+  if (recorder.is_overflowed()) {
+    seen->oversized = true;
+    return nullptr;
+  }
+  seen->hash = 0;
+  while (!this->runs_.empty() &&
+         (this->runs_.size() >= this->capacity_ || this->span_count_ + spans.size() > MAX_SPANS))
+    this->evict_();
+
+  this->runs_.emplace_back();
+  TextRun *run = &this->runs_.back();
+  run->font = font;
+  run->color = color;
+  run->background = background;
+  run->text = text;
+  run->last_used = this->clock_;
+  int x_offset;
+  font->measure(text, &run->width, &x_offset, &run->baseline, &run->height);
+  spans.shrink_to_fit();
+  run->spans = std::move(spans);
+  this->span_count_ += run->spans.size();
+  return run;
+}
+
+}  // namespace display
+}  // namespace esphome
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "esphome/core/color.h"
+
+namespace esphome {
+namespace display {
+
+class BaseFont;
+class Display;
+
+/// A run of equally colored pixels of a rendered string, relative to the top left corner of the text.
+struct TextSpan {
+  int16_t x;
+  int16_t y;
+  int16_t width;
+  Color color;
+};
+
+/// A string rendered once by its font, kept with its measurements so it can be drawn again as spans.
+struct TextRun {
+  const BaseFont *font;
+  Color color;
+  Color background;
+  std::string text;
+  int width;
+  int baseline;
+  int height;
+  std::vector<TextSpan> spans;
+  uint32_t last_used;
+};
+
+/** Least recently used cache of rendered strings.
+ *
+ * Fonts draw every glyph pixel by pixel and measure the text before that. Labels and values that appear on every
+ * update are rendered once instead, the font writes into a recorder that collects the pixels as horizontal spans.
+ * Drawing the text again only hands those spans to the display, which clips them and writes them as rows.
+ *
+ * A string is only kept once it was drawn twice within the last `capacity` misses, so values that change on every
+ * update are drawn directly and do not push the labels out. The spans of all strings are limited to MAX_SPANS,
+ * a string needing more than MAX_RUN_SPANS is never kept.
+ */
+class TextRunCache {
+ public:
+  static constexpr size_t MAX_CAPACITY = 64;
+  /// Spans kept over all strings, about 10 bytes each.
+  static constexpr size_t MAX_SPANS = 2048;
+  static constexpr size_t MAX_RUN_SPANS = 512;
+
+  /// Number of strings kept, up to MAX_CAPACITY; 0 disables the cache.
+  void set_capacity(size_t capacity);
+  size_t get_capacity() const { return this->capacity_; }
+
+  /** Find a string in the cache, rendering it with the font if it is seen for the second time.
+   *
+   * @param display The display the text is drawn on, the font may ask it for its type
+   * @return nullptr if the cache is disabled or does not keep the string, the caller then draws it directly
+   */
+  const TextRun *get(Display *display, BaseFont *font, Color color, Color background, const char *text);
+
+ protected:
+  /// A string that missed recently, by its hash.
+  struct Sighting {
+    uint32_t hash;
+    bool oversized;  // Recorded once and found to need more than MAX_RUN_SPANS
+  };
+
+  /// Remove the least recently used string.
+  void evict_();
+
+  std::vector<TextRun> runs_;
+  size_t capacity_{0};
+  size_t span_count_{0};
+  uint32_t clock_{0};
+  std::vector<Sighting> sightings_;
+  size_t next_sighting_{0};
+};
+
+}  // namespace display
+}  // namespace esphome
@@ -14,6 +14,7 @@ from esphome.const import (
     CONF_LAMBDA,
     CONF_MODEL,
     CONF_REVERSED,
+    CONF_TRIGGER_ID,
 )
 
 DEPENDENCIES = ['spi']
@@ -24,13 +25,29 @@ IT8951ESensor = it8951e_ns.class_(
 )
 ClearAction = it8951e_ns.class_("ClearAction", automation.Action)
 UpdateSlowAction = it8951e_ns.class_("UpdateSlowAction", automation.Action)
+RefreshCompleteTrigger = it8951e_ns.class_(
+    "RefreshCompleteTrigger", automation.Trigger.template()
+)
 
 it8951eModel = it8951e_ns.enum("it8951eModel")
 
+CONF_GHOSTING_BUDGET = "ghosting_budget"
+CONF_BITMAP_UPLOAD = "bitmap_upload"
+CONF_BAND_HEIGHT = "band_height"
+CONF_ON_REFRESH_COMPLETE = "on_refresh_complete"
+
 MODELS = {
     "M5EPD": it8951eModel.M5EPD
 }
 
+
+def validate_band_height(value):
+    value = cv.int_range(min=4, max=65532)(value)
+    # Refreshed areas start on rows that are a multiple of 4, so must the bands
+    if value % 4 != 0:
+        raise cv.Invalid(f"band_height must be a multiple of 4, got {value}")
+    return value
+
 CONFIG_SCHEMA = cv.All(
     display.FULL_DISPLAY_SCHEMA.extend(
         {
@@ -46,6 +63,16 @@ CONFIG_SCHEMA = cv.All(
             cv.Optional(CONF_MODEL, default="M5EPD"): cv.enum(
                 MODELS, upper=True, space="_"
             ),
+            cv.Optional(CONF_GHOSTING_BUDGET, default=10): cv.uint8_t,
+            cv.Optional(CONF_BITMAP_UPLOAD, default=True): cv.boolean,
+            cv.Optional(CONF_BAND_HEIGHT): validate_band_height,
+            cv.Optional(CONF_ON_REFRESH_COMPLETE): automation.validate_automation(
+                {
+                    cv.GenerateID(CONF_TRIGGER_ID): cv.declare_id(
+                        RefreshCompleteTrigger
+                    ),
+                }
+            ),
         }
     )
     .extend(cv.polling_component_schema("1s"))
@@ -101,3 +128,11 @@ async def to_code(config):
         cg.add(var.set_reversed(config[CONF_REVERSED]))
     if CONF_RESET_DURATION in config:
         cg.add(var.set_reset_duration(config[CONF_RESET_DURATION]))
+    cg.add(var.set_ghosting_budget(config[CONF_GHOSTING_BUDGET]))
+    cg.add(var.set_bitmap_upload(config[CONF_BITMAP_UPLOAD]))
+    if CONF_BAND_HEIGHT in config:
+        cg.add(var.set_band_height(config[CONF_BAND_HEIGHT]))
+
+    for conf in config.get(CONF_ON_REFRESH_COMPLETE, []):
+        trigger = cg.new_Pvariable(conf[CONF_TRIGGER_ID], var)
+        await automation.build_automation(trigger, [], conf)
@@ -9,6 +9,11 @@ namespace it8951e {
 
 static const char *TAG = "it8951e.display";
 
+// Gray levels DU and A2 can show: black and white
+static const uint16_t GRAY_LEVELS_2 = (1 << 0) | (1 << 15);
+// Gray levels DU4 can show: pixel states 0, 10, 20 and 30
+static const uint16_t GRAY_LEVELS_4 = (1 << 0) | (1 << 5) | (1 << 10) | (1 << 15);
+
 
 void IT8951ESensor::write_two_byte16(uint16_t type, uint16_t cmd) {
     this->wait_busy();
@@ -89,6 +94,12 @@ void IT8951ESensor::write_reg(uint16_t addr, uint16_t data) {
     this->disable();
 }
 
+uint16_t IT8951ESensor::read_reg(uint16_t addr) {
+    this->write_command(IT8951_TCON_REG_RD);
+    this->write_word(addr);
+    return this->read_word();
+}
+
 void IT8951ESensor::set_target_memory_addr(uint16_t tar_addrL, uint16_t tar_addrH) {
     this->write_reg(IT8951_LISAR + 2, tar_addrH);
     this->write_reg(IT8951_LISAR, tar_addrL);
@@ -127,18 +138,22 @@ void IT8951ESensor::wait_busy(uint32_t timeout) {
     }
 }
 
+/** @brief Poll the LUT engine status once
+ * @return true while any waveform is still running
+ */
+bool IT8951ESensor::is_lut_busy() {
+    return this->read_reg(IT8951_LUTAFSR) != 0;
+}
+
 void IT8951ESensor::check_busy(uint32_t timeout) {
     uint32_t start_time = millis();
     while (1) {
-        this->write_command(IT8951_TCON_REG_RD);
-        this->write_word(IT8951_LUTAFSR);
-        uint16_t word = this->read_word();
-        if (word == 0) {
+        if (!this->is_lut_busy()) {
             break;
         }
 
         if (millis() - start_time > timeout) {
-            ESP_LOGE(TAG, "SPI busy timeout %i", word);
+            ESP_LOGE(TAG, "SPI busy timeout");
             return;
         }
 
@@ -146,7 +161,7 @@ void IT8951ESensor::check_busy(uint32_t timeout) {
 }
 
 void IT8951ESensor::update_area(uint16_t x, uint16_t y, uint16_t w,
-                                     uint16_t h, update_mode_e mode) {
+                                     uint16_t h, update_mode_e mode, bool bitmap) {
     if (mode == update_mode_e::UPDATE_MODE_NONE) {
         return;
     }
@@ -155,8 +170,6 @@ void IT8951ESensor::update_area(uint16_t x, uint16_t y, uint16_t w,
     x = (x + 3) & 0xFFFC;
     y = (y + 3) & 0xFFFC;
 
-    this->check_busy();
-
     if (x + w > this->get_width_internal()) {
         w = this->get_width_internal() - x;
     }
@@ -170,8 +183,14 @@ void IT8951ESensor::update_area(uint16_t x, uint16_t y, uint16_t w,
     args[2] = w;
     args[3] = h;
     args[4] = mode;
-    args[5] = this->IT8951DevAll[this->model_].devInfo.usImgBufAddrL;
-    args[6] = this->IT8951DevAll[this->model_].devInfo.usImgBufAddrH;
+    if (bitmap) {
+        uint32_t addr = this->get_bitmap_addr_();
+        args[5] = addr & 0xFFFF;
+        args[6] = addr >> 16;
+    } else {
+        args[5] = this->IT8951DevAll[this->model_].devInfo.usImgBufAddrL;
+        args[6] = this->IT8951DevAll[this->model_].devInfo.usImgBufAddrH;
+    }
 
     this->write_args(IT8951_I80_CMD_DPY_BUF_AREA, args, 7);
 }
@@ -184,7 +203,11 @@ void IT8951ESensor::reset(void) {
     delay(100);
 }
 
-uint32_t IT8951ESensor::get_buffer_length_() { return this->get_width_internal() * this->get_height_internal(); }
+// 4bpp: two pixels per byte
+uint32_t IT8951ESensor::get_buffer_length_() {
+    const int rows = this->band_height_ != 0 ? this->band_height_ : this->get_height_internal();
+    return (this->get_width_internal() * rows) >> 1;
+}
 
 void IT8951ESensor::get_device_info(struct IT8951DevInfo_s *info) {
     this->write_command(IT8951_I80_CMD_GET_DEV_INFO);
@@ -231,18 +254,24 @@ void IT8951ESensor::setup() {
         this->get_vcom();
     }
 
-    
-    ExternalRAMAllocator<uint8_t> buffer_allocator(ExternalRAMAllocator<uint8_t>::ALLOW_FAILURE);
-    this->should_write_buffer_ = buffer_allocator.allocate(this->get_buffer_length_());
-    if (this->should_write_buffer_ == nullptr) {
-        ESP_LOGE(TAG, "Init FAILED.");
-        return;
+    if (this->band_height_ >= this->get_height_internal()) {
+        this->band_height_ = 0;
     }
-
-    this->previous_buffer_ = buffer_allocator.allocate(this->get_buffer_length_());
-    if (this->previous_buffer_ == nullptr) {
-        ESP_LOGE(TAG, "Init FAILED do to previous_buffer failed to allocate.");
-        return;
+    if (this->band_height_ != 0) {
+        // The buffer only holds one band, the controller keeps the frame
+        const size_t bands = (this->get_height_internal() + this->band_height_ - 1) / this->band_height_;
+        this->band_hashes_.resize(bands);
+        this->band_levels_.resize(bands);
+        this->band_rows_ = this->band_height_;
+        ESP_LOGCONFIG(TAG, "Drawing in %u bands of %u rows", (unsigned) bands, this->band_height_);
+    } else {
+        ExternalRAMAllocator<uint8_t> buffer_allocator(ExternalRAMAllocator<uint8_t>::ALLOW_FAILURE);
+        this->previous_buffer_ = buffer_allocator.allocate(this->get_buffer_length_());
+        if (this->previous_buffer_ == nullptr) {
+            ESP_LOGE(TAG, "Init FAILED do to previous_buffer failed to allocate.");
+            return;
+        }
+        this->diff_spans_.reserve(this->get_height_internal());
     }
 
     this->init_internal_(this->get_buffer_length_());
@@ -250,302 +279,901 @@ void IT8951ESensor::setup() {
     ESP_LOGCONFIG(TAG, "Init Done.");
 }
 
-/** @brief Write the image at the specified location, Partial update
- * @param x Update X coordinate, >>> Must be a multiple of 4 <<<
- * @param y Update Y coordinate
- * @param w width of gram, >>> Must be a multiple of 4 <<<
- * @param h height of gram
- * @param gram 4bpp gram data
+/** @brief Stream packed gram rows to the controller in a single chip-select burst
+ * @param gram First byte of the first row
+ * @param row_bytes Number of bytes to send for every row
+ * @param rows Number of rows
+ * @param stride Distance in bytes between the start of two consecutive rows
  */
-void IT8951ESensor::write_buffer_to_display(uint16_t x, uint16_t y, uint16_t w,
-                                            uint16_t h, const uint8_t *gram) {
-    this->m_endian_type = IT8951_LDIMG_B_ENDIAN;
-    this->m_pix_bpp     = IT8951_4BPP;
-    if (x > this->get_width() || y > this->get_height()) {
-        ESP_LOGE(TAG, "Pos (%d, %d) out of bounds.", x, y);
+void IT8951ESensor::stream_gram(const uint8_t *gram, uint32_t row_bytes, uint32_t rows, uint32_t stride) {
+    // Contiguous rows can be sent as one long run
+    if (stride == row_bytes) {
+        row_bytes *= rows;
+        rows = 1;
+    }
+    this->stats_.bytes_sent += row_bytes * rows;
+
+    this->wait_busy();
+    this->enable();
+    this->write_byte16(0x0000); // Preamble, sent once for the whole burst
+    this->wait_busy();
+
+    uint8_t *staging = reinterpret_cast<uint8_t *>(this->staging_buffer_);
+    for (uint32_t row = 0; row < rows; row++) {
+        const uint8_t *src = gram + row * stride;
+        uint32_t remaining = row_bytes;
+        while (remaining > 0) {
+            uint32_t chunk = std::min<uint32_t>(remaining, STAGING_BUFFER_SIZE);
+            if (this->reversed_) {
+                this->write_array(src, chunk);
+            } else {
+                // Invert a word at a time on the staging buffer
+                memcpy(staging, src, chunk);
+                uint32_t words = chunk >> 2;
+                for (uint32_t i = 0; i < words; i++) {
+                    this->staging_buffer_[i] = ~this->staging_buffer_[i];
+                }
+                for (uint32_t i = words << 2; i < chunk; i++) {
+                    staging[i] = ~staging[i];
+                }
+                this->write_array(staging, chunk);
+            }
+            src += chunk;
+            remaining -= chunk;
+        }
+        App.feed_wdt();
+    }
+
+    this->disable();
+}
+
+/** @brief Add an area to the dirty regions, merging it with the regions around it
+ * @param x X coordinate in panel coordinates
+ * @param y Y coordinate in panel coordinates
+ * @param w width of the area
+ * @param h height of the area
+ */
+void HOT IT8951ESensor::mark_dirty(int x, int y, int w, int h) {
+    // The controller wants areas aligned to 4 pixels
+    int x1 = std::max(x, 0) & ~0x3;
+    int y1 = std::max(y, 0) & ~0x3;
+    int x2 = std::min((x + w + 3) & ~0x3, this->get_width_internal());
+    int y2 = std::min((y + h + 3) & ~0x3, this->get_height_internal());
+    if (x1 >= x2 || y1 >= y2) {
         return;
     }
 
-    this->set_target_memory_addr(this->IT8951DevAll[this->model_].devInfo.usImgBufAddrL, this->IT8951DevAll[this->model_].devInfo.usImgBufAddrH);
-    this->set_area(x, y, w, h);
+    // Consecutive pixels almost always land in the region touched last
+    if (this->last_dirty_region_ < this->dirty_region_count_) {
+        const display::Rect &last = this->dirty_regions_[this->last_dirty_region_];
+        if (x1 >= last.x && y1 >= last.y && x2 <= last.x2() && y2 <= last.y2()) {
+            return;
+        }
+    }
 
-    uint32_t pos = 0;
-    uint16_t word = 0;
-    for (uint32_t x = 0; x < ((w * h) >> 2); x++) {
-        word = gram[pos] << 8 | gram[pos + 1];
+    display::Rect area(x1, y1, x2 - x1, y2 - y1);
+    for (uint8_t i = 0; i < this->dirty_region_count_; i++) {
+        display::Rect &region = this->dirty_regions_[i];
+        if (area.x <= region.x2() + DIRTY_MERGE_DISTANCE && region.x <= area.x2() + DIRTY_MERGE_DISTANCE &&
+            area.y <= region.y2() + DIRTY_MERGE_DISTANCE && region.y <= area.y2() + DIRTY_MERGE_DISTANCE) {
+            region.extend(area);
+            this->merge_dirty_regions(i);
+            return;
+        }
+    }
 
-        if (!this->reversed_) {
-            word = 0xFFFF - word;
+    if (this->dirty_region_count_ < MAX_DIRTY_REGIONS) {
+        this->last_dirty_region_ = this->dirty_region_count_;
+        this->dirty_regions_[this->dirty_region_count_++] = area;
+        return;
+    }
+
+    // Out of slots, grow the region that needs the fewest extra pixels
+    uint8_t best = 0;
+    int32_t best_growth = INT32_MAX;
+    for (uint8_t i = 0; i < this->dirty_region_count_; i++) {
+        const display::Rect &region = this->dirty_regions_[i];
+        int32_t w_union = std::max(region.x2(), area.x2()) - std::min(region.x, area.x);
+        int32_t h_union = std::max(region.y2(), area.y2()) - std::min(region.y, area.y);
+        int32_t growth = w_union * h_union - int32_t(region.w) * region.h;
+        if (growth < best_growth) {
+            best_growth = growth;
+            best = i;
         }
+    }
+    this->dirty_regions_[best].extend(area);
+    this->merge_dirty_regions(best);
+}
 
-        this->enable();
-        this->write_byte16(0);
-        this->write_byte16(word);
-        this->disable();
-        pos += 2;
+/** @brief Fold every region that came close to the region at index after it grew
+ */
+void IT8951ESensor::merge_dirty_regions(uint8_t index) {
+    bool merged = true;
+    while (merged) {
+        merged = false;
+        display::Rect &target = this->dirty_regions_[index];
+        for (uint8_t i = 0; i < this->dirty_region_count_; i++) {
+            if (i == index) {
+                continue;
+            }
+            const display::Rect &other = this->dirty_regions_[i];
+            if (other.x <= target.x2() + DIRTY_MERGE_DISTANCE && target.x <= other.x2() + DIRTY_MERGE_DISTANCE &&
+                other.y <= target.y2() + DIRTY_MERGE_DISTANCE && target.y <= other.y2() + DIRTY_MERGE_DISTANCE) {
+                target.extend(other);
+                // Drop the merged region by moving the last one into its slot
+                uint8_t last = --this->dirty_region_count_;
+                if (i != last) {
+                    this->dirty_regions_[i] = this->dirty_regions_[last];
+                }
+                if (index == last) {
+                    index = i;
+                }
+                merged = true;
+                break;
+            }
+        }
     }
+    this->last_dirty_region_ = index;
+}
 
-    this->write_command(IT8951_TCON_LD_IMG_END);
-    this->disable();
+void IT8951ESensor::reset_dirty() {
+    this->dirty_region_count_ = 0;
+    this->last_dirty_region_ = 0;
 }
 
+static inline uint32_t load_word(const uint8_t *data) {
+    uint32_t word;
+    memcpy(&word, data, sizeof(word));
+    return word;
+}
 
-void IT8951ESensor::write_buffer_to_display_fast(uint16_t x, uint16_t y, uint16_t w, uint16_t h, const uint8_t *gram) {
-    this->m_endian_type = IT8951_LDIMG_B_ENDIAN;
-    this->m_pix_bpp     = IT8951_4BPP;
-    if (x > this->get_width() || y > this->get_height()) {
-        ESP_LOGE(TAG, "Pos (%d, %d) out of bounds.", x, y);
-        return;
+/// Index of the first byte in [begin, end) where the two rows differ, end if they are equal
+static uint32_t first_difference(const uint8_t *a, const uint8_t *b, uint32_t begin, uint32_t end) {
+    while (begin < end && (begin & 0x3) != 0) {
+        if (a[begin] != b[begin]) {
+            return begin;
+        }
+        begin++;
+    }
+    while (begin + 4 <= end && load_word(a + begin) == load_word(b + begin)) {
+        begin += 4;
     }
+    while (begin < end && a[begin] == b[begin]) {
+        begin++;
+    }
+    return begin;
+}
 
-    this->set_target_memory_addr(this->IT8951DevAll[this->model_].devInfo.usImgBufAddrL, this->IT8951DevAll[this->model_].devInfo.usImgBufAddrH);
-    this->set_area(x, y, w, h);
+/// One past the last byte in [begin, end) where the two rows differ, begin if they are equal
+static uint32_t last_difference(const uint8_t *a, const uint8_t *b, uint32_t begin, uint32_t end) {
+    while (end > begin && (end & 0x3) != 0) {
+        if (a[end - 1] != b[end - 1]) {
+            return end;
+        }
+        end--;
+    }
+    while (end >= begin + 4 && load_word(a + end - 4) == load_word(b + end - 4)) {
+        end -= 4;
+    }
+    while (end > begin && a[end - 1] == b[end - 1]) {
+        end--;
+    }
+    return end;
+}
 
-    uint32_t pos = 0;
-    uint16_t word = 0;
-    for (uint32_t k = 0; k < ((w * h) >> 2); k++) {
-        word = gram[pos] << 8 | gram[pos + 1];
+/** @brief Compare an area of the frame buffer against the frame on the panel, a word at a time
+ * Appends the exact changed pixels of every row to diff_spans_ and the 4-pixel aligned
+ * rectangles bounding them to diff_rects_.
+ * @param area Area to compare, in panel coordinates
+ */
+void IT8951ESensor::diff_region(const display::Rect &area) {
+    const uint32_t stride = this->get_width_internal() >> 1;
+    const uint32_t begin = area.x >> 1;
+    const uint32_t end = (area.x2() + 1) >> 1;
+
+    display::Rect open;
+    for (int y = area.y; y < area.y2(); y++) {
+        const uint8_t *current = this->buffer_ + y * stride;
+        const uint8_t *previous = this->previous_buffer_ + y * stride;
+
+        uint32_t first = first_difference(current, previous, begin, end);
+        if (first == end) {
+            continue;
+        }
+        uint32_t last = last_difference(current, previous, first, end) - 1;
 
-        if (!this->reversed_) {
-            word = 0xFFFF - word;
+        // Even pixels live in the high nibble
+        int16_t x1 = first << 1;
+        if (((current[first] ^ previous[first]) & 0xF0) == 0) {
+            x1++;
+        }
+        int16_t x2 = (last << 1) + 2;
+        if (((current[last] ^ previous[last]) & 0x0F) == 0) {
+            x2--;
         }
+        this->diff_spans_.push_back(DiffSpan{static_cast<uint16_t>(y), static_cast<uint16_t>(x1), static_cast<uint16_t>(x2)});
+
+        if (open.is_set() && y - open.y2() <= DIRTY_MERGE_DISTANCE && x1 <= open.x2() + DIRTY_MERGE_DISTANCE &&
+            open.x <= x2 + DIRTY_MERGE_DISTANCE) {
+            open.extend(display::Rect(x1, y, x2 - x1, 1));
+        } else {
+            if (open.is_set()) {
+                this->add_diff_rect(open);
+            }
+            open = display::Rect(x1, y, x2 - x1, 1);
+        }
+    }
+    if (open.is_set()) {
+        this->add_diff_rect(open);
+    }
+}
 
-        this->enable();
-        this->write_byte16(0);
-        this->write_byte16(word);
-        this->disable();
-        pos += 2;
-        // if((k % 10) == 0) {
-        //     this->disable();
-        //     App.feed_wdt();
-        //     delay(3);
-        //     this->enable();
-        // }
+void IT8951ESensor::add_diff_rect(const display::Rect &rect) {
+    int x1 = rect.x & ~0x3;
+    int y1 = rect.y & ~0x3;
+    int x2 = std::min((rect.x2() + 3) & ~0x3, this->get_width_internal());
+    int y2 = std::min((rect.y2() + 3) & ~0x3, this->get_height_internal());
+    this->diff_rects_.push_back(display::Rect(x1, y1, x2 - x1, y2 - y1));
+}
+
+/** @brief Collect the gray levels used inside a region
+ * @return Bit n is set when level n is present
+ */
+uint16_t IT8951ESensor::get_gray_levels(const uint8_t *buffer, const display::Rect &region) {
+    const uint32_t stride = this->get_width_internal() >> 1;
+    uint16_t levels = 0;
+    for (int y = region.y; y < region.y2(); y++) {
+        const uint8_t *row = buffer + y * stride + (region.x >> 1);
+        for (int i = 0; i < (region.w >> 1); i++) {
+            levels |= (1 << (row[i] >> 4)) | (1 << (row[i] & 0x0F));
+        }
+        // Nothing more to learn once it is known to need all gray levels
+        if (levels & ~GRAY_LEVELS_4) {
+            break;
+        }
     }
+    return levels;
+}
 
-    this->write_command(IT8951_TCON_LD_IMG_END);
-    this->disable();
+/** @brief Pick the fastest waveform that can show the new content of a region
+ * Fast waveforms leave ghosting behind, once a tile used up its budget the region gets a GC16 instead.
+ */
+IT8951ESensor::update_mode_e IT8951ESensor::choose_update_mode(const display::Rect &region) {
+    // Until a refresh went through, the previous buffer and the panel content mean nothing
+    if (!this->previous_buffer_valid_) {
+        return update_mode_e::UPDATE_MODE_GC16;
+    }
+    uint16_t levels = this->get_gray_levels(this->buffer_, region);
+    // The previous content only matters for black and white updates
+    uint16_t previous = levels;
+    if ((levels & ~GRAY_LEVELS_2) == 0) {
+        previous = this->get_gray_levels(this->previous_buffer_, region);
+    }
+    return this->choose_update_mode(region, levels, previous);
 }
 
-void IT8951ESensor::calculate_update_region() {
-    // Reset de coordenadas
-    // this->min_x = this->get_width_internal();
-    // this->min_y = this->get_height_internal();
-    // this->max_x = 0;
-    // this->max_y = 0;
+/** @brief Pick the waveform for a region from the gray levels of its new and previous content
+ */
+IT8951ESensor::update_mode_e IT8951ESensor::choose_update_mode(const display::Rect &region, uint16_t levels,
+                                                               uint16_t previous_levels) {
+    update_mode_e mode;
+    if ((levels & ~GRAY_LEVELS_2) == 0) {
+        // A2 only drives black and white to black and white
+        mode = (previous_levels & ~GRAY_LEVELS_2) == 0 ? update_mode_e::UPDATE_MODE_A2 : update_mode_e::UPDATE_MODE_DU;
+    } else if ((levels & ~GRAY_LEVELS_4) == 0) {
+        mode = update_mode_e::UPDATE_MODE_DU4;
+    } else {
+        mode = update_mode_e::UPDATE_MODE_GL16;
+    }
 
-    int xmin = this->get_width_internal();
-    int ymin = this->get_height_internal();
-    int xmax = 0;
-    int ymax = 0;
+    if (this->ghosting_budget_ == 0) {
+        return mode;
+    }
 
-    //Log get_width_internal() and get_height_internal()
-    ESP_LOGI(TAG, "get_width_internal(): %d", this->get_width_internal());
-    ESP_LOGI(TAG, "get_height_internal(): %d", this->get_height_internal());
+    const int tx1 = region.x / GHOSTING_TILE_SIZE;
+    const int ty1 = region.y / GHOSTING_TILE_SIZE;
+    const int tx2 = std::min((region.x2() - 1) / GHOSTING_TILE_SIZE, GHOSTING_TILES_X - 1);
+    const int ty2 = std::min((region.y2() - 1) / GHOSTING_TILE_SIZE, GHOSTING_TILES_Y - 1);
+    bool exhausted = false;
+    for (int ty = ty1; ty <= ty2; ty++) {
+        for (int tx = tx1; tx <= tx2; tx++) {
+            if (this->ghosting_counters_[ty][tx] >= this->ghosting_budget_) {
+                exhausted = true;
+            }
+        }
+    }
 
-    uint32_t buffer_size = this->get_buffer_length_();
+    if (exhausted) {
+        ESP_LOGD(TAG, "Ghosting budget used up, cleaning region with GC16");
+        mode = update_mode_e::UPDATE_MODE_GC16;
+    }
+    for (int ty = ty1; ty <= ty2; ty++) {
+        for (int tx = tx1; tx <= tx2; tx++) {
+            uint8_t &counter = this->ghosting_counters_[ty][tx];
+            counter = exhausted ? 0 : std::min<uint8_t>(counter + 1, UINT8_MAX);
+        }
+    }
+    return mode;
+}
 
-    for (uint32_t index = 0; index < buffer_size; index++) {
-        if (this->buffer_[index] != this->previous_buffer_[index]) {  // Si el píxel cambió
-            int x = index % this->get_width_internal();
-            int y = index / this->get_width_internal();
+void IT8951ESensor::reset_ghosting() {
+    memset(this->ghosting_counters_, 0, sizeof(this->ghosting_counters_));
+}
 
-            // Actualizar límites de la región modificada
-            if (x < xmin) xmin = x;
-            if (y < ymin) ymin = y;
-            if (x > xmax) xmax = x;
-            if (y > ymax) ymax = y;
+void IT8951ESensor::write_display() {
+    if (this->band_height_ != 0) {
+        // There is no full frame to diff against previous_buffer_, the page is drawn again band by band
+        if (this->refresh_state_ != REFRESH_IDLE) {
+            this->update_requested_ = true;
+        } else {
+            this->write_display_banded(false);
         }
+        return;
+    }
+    if (this->dirty_region_count_ == 0 && this->previous_buffer_valid_) {
+        ESP_LOGV(TAG, "Nothing changed, skipping refresh");
+        this->report_stats_(false);
+        return;
     }
 
-    ESP_LOGI(TAG, "Update area detected: x[%d - %d], y[%d - %d]", xmin, xmax, ymin, ymax);
+    // Clearing and redrawing the same content damages the buffer without changing the panel,
+    // only what differs from the previous frame is sent
+    this->diff_spans_.clear();
+    this->diff_rects_.clear();
+    if (this->previous_buffer_valid_) {
+        for (uint8_t i = 0; i < this->dirty_region_count_; i++) {
+            this->diff_region(this->dirty_regions_[i]);
+        }
+    } else {
+        this->diff_rects_.push_back(display::Rect(0, 0, this->get_width_internal(), this->get_height_internal()));
+    }
+    this->reset_dirty();
 
-    // Si no se detectaron cambios, hacer un refresh completo
-    if (this->min_x > this->max_x || this->min_y > this->max_y) {
-        ESP_LOGI(TAG,"No changes detected, doing full refresh");
-        // this->min_x = 0;
-        // this->min_y = 0;
-        // this->max_x = this->get_width_internal();
-        // this->max_y = this->get_height_internal();
+    if (this->diff_rects_.empty()) {
+        ESP_LOGV(TAG, "Frame unchanged, skipping refresh");
+        this->report_stats_(false);
+        return;
     }
+
+    // Like the banded path: with the panel content unknown the whole panel gets a GC16
+    this->refresh_full_ = !this->previous_buffer_valid_;
+    this->start_refresh();
 }
 
-//create a function that logs all buffer content as a string the input parameters must be uint8_t *buff, uint32_t buff_size
-//this function will be used to log the buffer content for debugging purposes
-void IT8951ESensor::log_buffer(uint8_t *buff, uint32_t buff_size) {
-    if(buff == nullptr) {
-        ESP_LOGE(TAG, "Buffer is null");
+void IT8951ESensor::write_display_slow() {
+    if (this->band_height_ != 0) {
+        if (this->refresh_state_ != REFRESH_IDLE) {
+            this->update_requested_ = true;
+            this->slow_requested_ = true;
+        } else {
+            this->write_display_banded(true);
+        }
         return;
     }
-    //create a string to store the buffer content
-    std::string buffer_content = "";
-    ESP_LOGI(TAG, "Buffer size: %d", buff_size);
-    //iterate over the buffer and append each byte to the string
-    for (uint32_t i = 0; i < 200; i++) {
-    // for (uint32_t i = 0; i < 100; i++) {
-        buffer_content += std::to_string(buff[i]);
-        buffer_content += " ";
-    }
-    //log the buffer content
-    ESP_LOGI(TAG, "Buffer content: %s", buffer_content.c_str());
+    this->diff_spans_.clear();
+    this->diff_rects_.clear();
+    this->diff_rects_.push_back(display::Rect(0, 0, this->get_width_internal(), this->get_height_internal()));
+    this->reset_dirty();
+
+    this->refresh_full_ = true;
+    this->start_refresh();
 }
 
+/// FNV-1a over the words of a band, enough to notice that a band changed
+static uint32_t hash_band(const uint8_t *data, uint32_t length) {
+    uint32_t hash = 2166136261u;
+    uint32_t i = 0;
+    for (; i + 4 <= length; i += 4) {
+        hash = (hash ^ load_word(data + i)) * 16777619u;
+    }
+    for (; i < length; i++) {
+        hash = (hash ^ data[i]) * 16777619u;
+    }
+    return hash;
+}
 
+/** @brief Draw the page band by band, stream the bands that changed and refresh the rows they cover
+ * @param full Upload every band and refresh the whole panel with GC16
+ */
+void IT8951ESensor::write_display_banded(bool full) {
+    const IT8951DevInfo_s &info = this->IT8951DevAll[this->model_].devInfo;
+    const uint32_t stride = this->get_width_internal() >> 1;
+    // Until a refresh went through, the controller memory and the hashes mean nothing
+    full = full || !this->previous_buffer_valid_;
+    if (full) {
+        // The strip only holds the last band, a full refresh has to draw the page again
+        this->invalidate_page_cache();
+    }
+    int y1 = this->get_height_internal();
+    int y2 = 0;
+    uint16_t levels = 0;
+    uint16_t previous_levels = 0;
 
-void IT8951ESensor::write_display() {
-    this->log_buffer(this->buffer_, this->get_buffer_length_());
-    this->log_buffer(this->previous_buffer_, this->get_buffer_length_());
-    //this->calculate_update_region();
+    this->refresh_start_ = millis();
     this->write_command(IT8951_TCON_SYS_RUN);
-    ESP_LOGI(TAG, "write_display: %d %d %d %d ", this->min_x, this->min_y, this->max_x, this->max_y);
-    this->min_x = 80;
-    this->min_y = 50;
-    this->max_x = 720-1;
-    this->max_y = 539-50;
-
-    this->min_x &= ~0x1;
-    this->max_x = (this->max_x + 1) & ~0x1;
-
-    uint16_t update_width = this->max_x - this->min_x;
-    uint16_t update_height = this->max_y - this->min_y;
-    uint32_t update_size = (update_width >> 1) * update_height;  // Dividimos width entre 2 porque cada byte almacena 2 píxeles.
-
-    ESP_LOGI(TAG, "Update region size: width=%d, height=%d, total=%d bytes", update_width, update_height, update_size);
-
-    ExternalRAMAllocator<uint8_t> buffer_allocator(ExternalRAMAllocator<uint8_t>::ALLOW_FAILURE);
-    uint8_t *cropped_buffer = buffer_allocator.allocate(update_size);
-    
-    if (cropped_buffer == nullptr) {
-        ESP_LOGE(TAG, "Failed to allocate cropped buffer.");
+    this->render_bands_(this->band_height_, [&](int y, int rows) {
+        // Dirty regions are meaningless against the previous content of the strip
+        this->reset_dirty();
+        const size_t band = y / this->band_height_;
+        const uint32_t length = rows * stride;
+        const uint32_t hash = hash_band(this->buffer_, length);
+        if (!full && hash == this->band_hashes_[band]) {
+            return;
+        }
+        previous_levels |= full ? 0xFFFF : this->band_levels_[band];
+        this->band_hashes_[band] = hash;
+        this->band_levels_[band] = this->get_gray_levels(this->buffer_, display::Rect(0, 0, this->get_width_internal(), rows));
+
+        this->m_endian_type = IT8951_LDIMG_B_ENDIAN;
+        this->m_pix_bpp = IT8951_4BPP;
+        this->set_target_memory_addr(info.usImgBufAddrL, info.usImgBufAddrH);
+        this->set_area(0, y, this->get_width_internal(), rows);
+        this->stream_gram(this->buffer_, length, 1, length);
+        this->write_command(IT8951_TCON_LD_IMG_END);
+        y1 = std::min(y1, y);
+        y2 = std::max(y2, y + rows);
+    });
+
+    if (y1 >= y2) {
+        ESP_LOGV(TAG, "Frame unchanged, skipping refresh");
+        this->write_command(IT8951_TCON_SLEEP);
+        this->report_stats_(false);
         return;
     }
 
-    for (uint16_t y = 0; y < update_height; y++) {
-        uint32_t src_index = (this->min_y + y) * (this->get_width_internal() >> 1) + (this->min_x >> 1);
-        uint32_t dst_index = y * (update_width >> 1);
-        memcpy(&cropped_buffer[dst_index], &this->buffer_[src_index], update_width >> 1);
+    // Unchanged bands between the changed ones are refreshed as well, their content counts for the waveform
+    for (size_t band = y1 / this->band_height_; band * this->band_height_ < size_t(y2); band++) {
+        levels |= this->band_levels_[band];
+        previous_levels |= this->band_levels_[band];
     }
 
-    ESP_LOGI(TAG, "write_buffer_to_display: x=%d, y=%d, width=%d, height=%d", this->min_x, this->min_y, update_width, update_height);
-    this->write_buffer_to_display_fast(this->min_x, this->min_y, update_width, update_height, cropped_buffer);
-    
-    ESP_LOGI(TAG, "update_area: x=%d, y=%d, width=%d, height=%d", this->min_x, this->min_y, update_width, update_height);
-    this->update_area(this->min_x, this->min_y, update_width, update_height, update_mode_e::UPDATE_MODE_DU4);   // 2 level
+    this->diff_rects_.clear();
+    this->diff_rects_.push_back(display::Rect(0, y1, this->get_width_internal(), y2 - y1));
+    const display::Rect &region = this->diff_rects_.front();
+    this->refresh_full_ = full;
+    this->refresh_bitmap_ = false;
+    this->refresh_mode_ = full ? update_mode_e::UPDATE_MODE_GC16 : this->choose_update_mode(region, levels, previous_levels);
+    ESP_LOGD(TAG, "Updating rows y=%d, height=%d, mode=%d", region.y, region.h, this->refresh_mode_);
+
+    // Everything is uploaded already, go straight to the waveform
+    this->refresh_region_ = 0;
+    this->refresh_state_ = REFRESH_DISPLAY;
+    this->refresh_wait_start_ = millis();
+    this->high_freq_.start();
+}
 
-    // Liberar el buffer temporal
-    buffer_allocator.deallocate(cropped_buffer, update_size);
+/** @brief Hand the regions in diff_rects_ over to the refresh pipeline driven from loop()
+ */
+void IT8951ESensor::start_refresh() {
+    this->refresh_start_ = millis();
+    this->write_command(IT8951_TCON_SYS_RUN);
+    this->refresh_region_ = 0;
+    this->refresh_row_ = 0;
+    this->refresh_state_ = REFRESH_UPLOAD;
+    this->high_freq_.start();
+}
 
-    // Restablecer coordenadas para la próxima actualización
-    this->max_x = 0;
-    this->max_y = 0;
-    this->min_x = this->get_width_internal();
-    this->min_y = this->get_height_internal();
+/** @brief Pack mono 4bpp rows into 1 bit per pixel and stream them to the controller
+ * @param gram First byte of the first row, >>> x must be a multiple of 8 <<<
+ * @param w Number of pixels per row, >>> Must be a multiple of 8 <<<
+ * @param rows Number of rows
+ * @param stride Distance in bytes between two rows of gram
+ */
+void IT8951ESensor::stream_bitmap(const uint8_t *gram, uint16_t w, uint32_t rows, uint32_t stride) {
+    const uint32_t row_bytes = w >> 3;
+    const uint32_t rows_per_chunk = STAGING_BUFFER_SIZE / row_bytes;
+    uint8_t *staging = reinterpret_cast<uint8_t *>(this->staging_buffer_);
+    this->stats_.bytes_sent += row_bytes * rows;
 
-    // Copiar el buffer actual al buffer anterior
-    memcpy(this->previous_buffer_, this->buffer_, this->get_buffer_length_());
-    ESP_LOGI(TAG, "Copied buffer to previous_buffer_");
+    this->wait_busy();
+    this->enable();
+    this->write_byte16(0x0000); // Preamble, sent once for the whole burst
+    this->wait_busy();
 
-    this->write_command(IT8951_TCON_SLEEP);
+    uint32_t row = 0;
+    while (row < rows) {
+        uint32_t chunk_rows = std::min(rows - row, rows_per_chunk);
+        uint8_t *dst = staging;
+        for (uint32_t i = 0; i < chunk_rows; i++, row++) {
+            const uint8_t *src = gram + row * stride;
+            for (uint32_t j = 0; j < row_bytes; j++, src += 4) {
+                // Nibbles are either 0 or 15, the top bit of each is enough. First pixel goes in bit 0.
+                *dst++ = ((src[0] >> 7) & 0x01) | ((src[0] >> 2) & 0x02) | ((src[1] >> 5) & 0x04) | (src[1] & 0x08) |
+                         ((src[2] >> 3) & 0x10) | ((src[2] << 2) & 0x20) | ((src[3] >> 1) & 0x40) | ((src[3] << 4) & 0x80);
+            }
+        }
+        this->write_array(staging, chunk_rows * row_bytes);
+        App.feed_wdt();
+    }
+
+    this->disable();
 }
 
+/** @brief Switch the controller between showing 4bpp image memory and 1bpp bitmaps
+ * Only safe while no waveform is running.
+ */
+void IT8951ESensor::set_bitmap_mode(bool enable) {
+    uint16_t value = this->read_reg(IT8951_UP1SR + 2);
+    this->write_reg(IT8951_UP1SR + 2, enable ? value | (1 << 2) : value & ~(1 << 2));
+    if (enable) {
+        // Set bits show the gray of COLOR_ON, cleared bits the one of COLOR_OFF
+        uint16_t fg = this->reversed_ ? 0xF0 : 0x00;
+        uint16_t bg = this->reversed_ ? 0x00 : 0xF0;
+        this->write_reg(IT8951_BGVR, fg << 8 | bg);
+    }
+    this->bitmap_mode_ = enable;
+}
 
+/** @brief Bitmaps are loaded behind the 4bpp frame so they do not overwrite it
+ */
+uint32_t IT8951ESensor::get_bitmap_addr_() {
+    const IT8951DevInfo_s &info = this->IT8951DevAll[this->model_].devInfo;
+    return (info.usImgBufAddrL | (info.usImgBufAddrH << 16)) + this->get_width_internal() * this->get_height_internal();
+}
 
-void IT8951ESensor::write_display_slow() {
-    this->write_command(IT8951_TCON_SYS_RUN);
-    this->write_buffer_to_display(this->min_x, this->min_y, this->max_x, this->max_y, this->buffer_);
-    this->update_area(this->min_x, this->min_y, this->max_x, this->max_y, update_mode_e::UPDATE_MODE_GC16);
-    this->max_x = 0;
-    this->max_y = 0;
-    this->min_x = 960;
-    this->min_y = 540;
+/** @brief Upload rows of the current region until the time budget of this loop iteration is spent
+ */
+void IT8951ESensor::upload_step() {
+    display::Rect &region = this->diff_rects_[this->refresh_region_];
+    const uint32_t stride = this->get_width_internal() >> 1;
+
+    if (this->refresh_row_ == 0) {
+        this->refresh_bitmap_ = false;
+        if (this->bitmap_upload_ && (this->get_gray_levels(this->buffer_, region) & ~GRAY_LEVELS_2) == 0) {
+            // Bitmaps are loaded as 8bpp bytes, the area has to be a multiple of 32 pixels wide
+            int16_t x1 = region.x & ~0x1F;
+            int16_t x2 = std::min<int16_t>((region.x2() + 0x1F) & ~0x1F, this->get_width_internal());
+            display::Rect area(x1, region.y, x2 - x1, region.h);
+            if (((x2 - x1) & 0x1F) == 0 && (this->get_gray_levels(this->buffer_, area) & ~GRAY_LEVELS_2) == 0) {
+                region = area;
+                this->refresh_bitmap_ = true;
+            }
+        }
+
+        this->refresh_mode_ = this->refresh_full_ ? update_mode_e::UPDATE_MODE_GC16 : this->choose_update_mode(region);
+        ESP_LOGD(TAG, "Updating region x=%d, y=%d, width=%d, height=%d, mode=%d%s", region.x, region.y, region.w,
+                 region.h, this->refresh_mode_, this->refresh_bitmap_ ? ", 1bpp" : "");
+
+        this->m_endian_type = IT8951_LDIMG_B_ENDIAN;
+        if (this->refresh_bitmap_) {
+            uint32_t addr = this->get_bitmap_addr_();
+            this->m_pix_bpp = IT8951_8BPP;
+            this->set_target_memory_addr(addr & 0xFFFF, addr >> 16);
+            this->set_area(region.x >> 3, region.y, region.w >> 3, region.h);
+        } else {
+            // Image memory under earlier bitmap refreshes is out of date, but every area is uploaded
+            // before it is displayed so it never shows
+            this->m_pix_bpp = IT8951_4BPP;
+            this->set_target_memory_addr(this->IT8951DevAll[this->model_].devInfo.usImgBufAddrL, this->IT8951DevAll[this->model_].devInfo.usImgBufAddrH);
+            this->set_area(region.x, region.y, region.w, region.h);
+        }
+    }
+
+    const uint32_t row_bytes = region.w >> 1;
+    const uint32_t start = millis();
+    const int16_t rows_per_chunk = std::max<uint32_t>(1, UPLOAD_CHUNK_SIZE / row_bytes);
+    while (this->refresh_row_ < region.h) {
+        const int16_t rows = std::min<int16_t>(rows_per_chunk, region.h - this->refresh_row_);
+        const uint32_t offset = (region.y + this->refresh_row_) * stride + (region.x >> 1);
+        if (this->refresh_bitmap_) {
+            this->stream_bitmap(this->buffer_ + offset, region.w, rows, stride);
+        } else {
+            this->stream_gram(this->buffer_ + offset, row_bytes, rows, stride);
+        }
+
+        // Keep the previous frame in sync with what the controller now holds
+        for (int16_t row = 0; row < rows; row++) {
+            memcpy(this->previous_buffer_ + offset + row * stride, this->buffer_ + offset + row * stride, row_bytes);
+        }
+        this->refresh_row_ += rows;
+
+        if (millis() - start >= UPLOAD_TIME_BUDGET) {
+            break;
+        }
+    }
+
+    if (this->refresh_row_ < region.h) {
+        return;
+    }
+    this->write_command(IT8951_TCON_LD_IMG_END);
+    this->refresh_state_ = REFRESH_DISPLAY;
+    this->refresh_wait_start_ = millis();
+}
+
+void IT8951ESensor::loop() {
+    switch (this->refresh_state_) {
+    case REFRESH_IDLE:
+        break;
+
+    case REFRESH_UPLOAD:
+        this->upload_step();
+        break;
+
+    case REFRESH_DISPLAY: {
+        // Give running waveforms a moment to finish before starting the next one. Switching between
+        // bitmap and 4bpp sources has to wait until they are all done.
+        const bool switch_mode = this->refresh_bitmap_ != this->bitmap_mode_;
+        const uint32_t timeout = switch_mode ? REFRESH_TIMEOUT : LUT_WAIT_TIMEOUT;
+        if (millis() - this->refresh_wait_start_ < timeout && this->is_lut_busy()) {
+            break;
+        }
+        if (switch_mode) {
+            this->set_bitmap_mode(this->refresh_bitmap_);
+        }
+        const display::Rect &region = this->diff_rects_[this->refresh_region_];
+        this->update_area(region.x, region.y, region.w, region.h, this->refresh_mode_, this->refresh_bitmap_);
+
+        if (++this->refresh_region_ < this->diff_rects_.size()) {
+            this->refresh_row_ = 0;
+            this->refresh_state_ = REFRESH_UPLOAD;
+        } else {
+            this->refresh_state_ = REFRESH_WAIT;
+            this->refresh_wait_start_ = millis();
+            this->last_lut_poll_ = this->refresh_wait_start_;
+        }
+        break;
+    }
+
+    case REFRESH_WAIT: {
+        const uint32_t now = millis();
+        if (now - this->last_lut_poll_ < LUT_POLL_INTERVAL) {
+            break;
+        }
+        this->last_lut_poll_ = now;
+        if (this->is_lut_busy()) {
+            if (now - this->refresh_wait_start_ < REFRESH_TIMEOUT) {
+                break;
+            }
+            ESP_LOGE(TAG, "Refresh timeout");
+        }
+        this->finish_refresh();
+        break;
+    }
+    }
+}
+
+void IT8951ESensor::finish_refresh() {
+    if (this->bitmap_mode_) {
+        this->set_bitmap_mode(false);
+    }
     this->write_command(IT8951_TCON_SLEEP);
+    this->previous_buffer_valid_ = true;
+    if (this->refresh_full_) {
+        this->reset_ghosting();
+    }
+    this->refresh_state_ = REFRESH_IDLE;
+    this->high_freq_.stop();
+    this->stats_.refresh_ms = millis() - this->refresh_start_;
+    this->report_stats_(true);
+
+    this->refresh_complete_callback_.call();
+    if (this->refresh_state_ != REFRESH_IDLE) {
+        return;
+    }
+
+    // Everything requested while busy collapses into one refresh
+    if (this->update_requested_) {
+        bool slow = this->slow_requested_;
+        this->update_requested_ = false;
+        this->slow_requested_ = false;
+        if (slow) {
+            this->update_slow();
+        } else {
+            this->update();
+        }
+    } else if (this->dirty_region_count_ > 0) {
+        this->write_display();
+    }
 }
 
+/** @brief Stop the refresh in progress, the panel content is unknown afterwards
+ */
+void IT8951ESensor::abort_refresh() {
+    if (this->refresh_state_ == REFRESH_UPLOAD && this->refresh_row_ > 0) {
+        this->write_command(IT8951_TCON_LD_IMG_END);
+    }
+    this->refresh_state_ = REFRESH_IDLE;
+    this->previous_buffer_valid_ = false;
+    this->high_freq_.stop();
+    if (this->bitmap_mode_) {
+        this->check_busy(REFRESH_TIMEOUT);
+        this->set_bitmap_mode(false);
+    }
+}
 
 /** @brief Clear graphics buffer
  * @param init Screen initialization, If is 0, clear the buffer without initializing
  */
 void IT8951ESensor::clear(bool init) {
+    if (this->refresh_state_ != REFRESH_IDLE) {
+        this->abort_refresh();
+    }
+
     this->m_endian_type = IT8951_LDIMG_L_ENDIAN;
     this->m_pix_bpp     = IT8951_4BPP;
 
     this->set_target_memory_addr(this->IT8951DevAll[this->model_].devInfo.usImgBufAddrL, this->IT8951DevAll[this->model_].devInfo.usImgBufAddrH);
     this->set_area(0, 0, this->get_width_internal(), this->get_height_internal());
-    uint32_t looping = (this->get_width_internal() * this->get_height_internal()) >> 2;
+    uint32_t remaining = (this->get_width_internal() * this->get_height_internal()) >> 1;
+    this->stats_.bytes_sent += remaining;
 
-    for (uint32_t x = 0; x < looping; x++) {
-        this->enable();
-        this->write_byte16(0x0000);
-        this->write_byte16(0xFFFF);
-        this->disable();
+    // White is 0xFF, sent from the staging buffer in one burst
+    memset(this->staging_buffer_, 0xFF, STAGING_BUFFER_SIZE);
+    this->wait_busy();
+    this->enable();
+    this->write_byte16(0x0000);
+    this->wait_busy();
+    while (remaining > 0) {
+        uint32_t chunk = std::min<uint32_t>(remaining, STAGING_BUFFER_SIZE);
+        this->write_array(reinterpret_cast<uint8_t *>(this->staging_buffer_), chunk);
+        remaining -= chunk;
     }
+    this->disable();
 
     this->write_command(IT8951_TCON_LD_IMG_END);
+    // The controller memory no longer matches the frame buffer
+    this->previous_buffer_valid_ = false;
+    this->invalidate_page_cache();
 
     if (init) {
+        this->check_busy();
         this->update_area(0, 0, this->get_width_internal(), this->get_height_internal(), update_mode_e::UPDATE_MODE_INIT);
+        this->reset_ghosting();
     }
 }
 
 void IT8951ESensor::update() {
-    if (this->is_ready()) {
-        this->do_update_();
-        this->write_display();
+    if (!this->is_ready()) {
+        return;
+    }
+    if (this->refresh_state_ != REFRESH_IDLE) {
+        // The upload reads buffer_ and chose its waveform and format from it, rendering now would mix two
+        // frames. The page is drawn once the running refresh is done.
+        this->update_requested_ = true;
+        return;
+    }
+    if (this->band_height_ != 0) {
+        this->write_display_banded(false);
+        return;
     }
+    this->do_update_();
+    this->write_display();
 }
 
 void IT8951ESensor::update_crazy() {
-    if (this->is_ready()) {
-        this->do_update_();
-        this->write_display();
-    }
+    this->update();
 }
 
 void IT8951ESensor::update_slow() {
-    if (this->is_ready()) {
-        this->do_update_();
-        this->write_display_slow();
+    if (!this->is_ready()) {
+        return;
+    }
+    if (this->refresh_state_ != REFRESH_IDLE) {
+        // Upgrades whatever is pending to a full refresh
+        this->update_requested_ = true;
+        this->slow_requested_ = true;
+        return;
     }
+    if (this->band_height_ != 0) {
+        this->write_display_banded(true);
+        return;
+    }
+    this->do_update_();
+    this->write_display_slow();
 }
 
 void HOT IT8951ESensor::draw_absolute_pixel_internal(int x, int y, Color color) {
-    if (x >= this->get_width_internal() || y >= this->get_height_internal() || x < 0 || y < 0) {
-        // Removed to avoid too much logging
-        // ESP_LOGE(TAG, "Drawing outside the screen size!");
-        return;
+    this->set_pixel(x, y, color.raw_32 & 0x0F);
+}
+
+/// Index of the first byte in [begin, end) that is not value, end if there is none
+static uint32_t first_mismatch(const uint8_t *row, uint8_t value, uint32_t begin, uint32_t end) {
+    const uint32_t pattern = value * 0x01010101u;
+    while (begin < end && (begin & 0x3) != 0) {
+        if (row[begin] != value) {
+            return begin;
+        }
+        begin++;
+    }
+    while (begin + 4 <= end && load_word(row + begin) == pattern) {
+        begin += 4;
     }
+    while (begin < end && row[begin] == value) {
+        begin++;
+    }
+    return begin;
+}
 
-    if (this->buffer_ == nullptr) {
+/// One past the last byte in [begin, end) that is not value, begin if there is none
+static uint32_t last_mismatch(const uint8_t *row, uint8_t value, uint32_t begin, uint32_t end) {
+    const uint32_t pattern = value * 0x01010101u;
+    while (end > begin && (end & 0x3) != 0) {
+        if (row[end - 1] != value) {
+            return end;
+        }
+        end--;
+    }
+    while (end >= begin + 4 && load_word(row + end - 4) == pattern) {
+        end -= 4;
+    }
+    while (end > begin && row[end - 1] == value) {
+        end--;
+    }
+    return end;
+}
+
+/** @brief Fill a clipped run of pixels in one row, whole bytes are written with memset
+ */
+void HOT IT8951ESensor::draw_absolute_row_internal(int x, int y, int width, Color color) {
+    if (this->buffer_ == nullptr || y < this->band_y_ || y >= this->band_y_ + this->band_rows_) {
+        return;
+    }
+    int x2 = std::min(x + width, this->native_width_);
+    x = std::max(x, 0);
+    if (x >= x2) {
         return;
     }
 
-    if (x > this->max_x) {
-        this->max_x = x;
+    const uint8_t nibble = color.raw_32 & 0x0F;
+    // Odd first and last pixels share their byte with a neighbour
+    if (x & 0x1) {
+        this->set_pixel(x++, y, nibble);
+    }
+    if (x2 & 0x1 && x < x2) {
+        this->set_pixel(--x2, y, nibble);
+    }
+    if (x >= x2) {
+        return;
     }
 
-    if (y > this->max_y) {
-        this->max_y = y;
+    const uint8_t value = nibble << 4 | nibble;
+    uint8_t *row = this->buffer_ + (y - this->band_y_) * (this->native_width_ >> 1);
+    uint32_t first = first_mismatch(row, value, x >> 1, x2 >> 1);
+    if (first == uint32_t(x2 >> 1)) {
+        return;
     }
+    uint32_t last = last_mismatch(row, value, first, x2 >> 1);
+    memset(row + first, value, last - first);
+    this->mark_dirty(first << 1, y, (last - first) << 1, 1);
+}
 
-    if (x < this->min_x) {
-        this->min_x = x;
+void HOT IT8951ESensor::draw_absolute_column_internal(int x, int y, int height, Color color) {
+    const uint8_t nibble = color.raw_32 & 0x0F;
+    for (int i = y; i < y + height; i++) {
+        this->set_pixel(x, i, nibble);
     }
+}
 
-    if (y < this->min_y) {
-        this->min_y = y;
+void HOT IT8951ESensor::draw_absolute_pixels_internal(int x, int y, int dx, int dy, int count, const Color *colors) {
+    for (int i = 0; i < count; i++, x += dx, y += dy) {
+        this->set_pixel(x, y, colors[i].raw_32 & 0x0F);
     }
+}
 
-    uint32_t internal_color = color.raw_32 & 0x0F;
-    uint16_t _bytewidth = this->get_width_internal() >> 1;
-    int32_t index = y * _bytewidth + (x >> 1);
+/** @brief Fill the whole buffer with a single memset, only rows whose content changes are marked dirty
+ */
+void IT8951ESensor::fill(Color color) {
+    if (this->buffer_ == nullptr) {
+        return;
+    }
+    if (this->is_clipping()) {
+        display::Display::fill(color);
+        return;
+    }
 
-    if (x & 0x1) {
-        this->buffer_[index] &= 0xF0;
-        this->buffer_[index] |= internal_color;
-    } else {
-        this->buffer_[index] &= 0x0F;
-        this->buffer_[index] |= internal_color << 4;
+    const uint8_t nibble = color.raw_32 & 0x0F;
+    const uint8_t value = nibble << 4 | nibble;
+    const uint32_t stride = this->native_width_ >> 1;
+    for (int y = 0; y < this->band_rows_; y++) {
+        const uint8_t *row = this->buffer_ + y * stride;
+        uint32_t first = first_mismatch(row, value, 0, stride);
+        if (first == stride) {
+            continue;
+        }
+        uint32_t last = last_mismatch(row, value, first, stride);
+        this->mark_dirty(first << 1, this->band_y_ + y, (last - first) << 1, 1);
     }
+    memset(this->buffer_, value, this->get_buffer_length_());
 }
 
 int IT8951ESensor::get_width_internal() {
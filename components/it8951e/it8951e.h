@@ -130,8 +130,16 @@ shown in Figure 1. The use of a white image in the transition from 4-bit to
   void set_reversed(bool reversed) { this->reversed_ = reversed; }
   void set_reset_duration(uint32_t reset_duration) { this->reset_duration_ = reset_duration; }
   void set_model(it8951eModel model) { this->model_ = model; }
+  void set_ghosting_budget(uint8_t ghosting_budget) { this->ghosting_budget_ = ghosting_budget; }
+  void set_bitmap_upload(bool bitmap_upload) { this->bitmap_upload_ = bitmap_upload; }
+  void set_band_height(uint16_t band_height) { this->band_height_ = band_height; }
+
+  void add_on_refresh_complete_callback(std::function<void()> &&callback) {
+    this->refresh_complete_callback_.add(std::move(callback));
+  }
 
   void setup() override;
+  void loop() override;
   void update() override;
   void update_crazy();
   void update_slow();
@@ -141,8 +149,46 @@ shown in Figure 1. The use of a white image in the transition from 4-bit to
 
   void clear(bool init);
 
+  void fill(Color color) override;
+
+  void draw_pixel_at(int x, int y, Color color) override {
+    if (this->transform_pixel_(x, y)) {
+      this->set_pixel(x, y, color.raw_32 & 0x0F);
+    }
+  }
+
  protected:
   void draw_absolute_pixel_internal(int x, int y, Color color) override;
+  void draw_absolute_row_internal(int x, int y, int width, Color color) override;
+  void draw_absolute_column_internal(int x, int y, int height, Color color) override;
+  void draw_absolute_pixels_internal(int x, int y, int dx, int dy, int count, const Color *colors) override;
+
+  /// Write one 4bpp pixel in panel coordinates, inlined into the drawing hot path
+  inline void set_pixel(int x, int y, uint8_t nibble) ESPHOME_ALWAYS_INLINE {
+    if (x >= this->native_width_ || x < 0 || y < this->band_y_ || y >= this->band_y_ + this->band_rows_ ||
+        this->buffer_ == nullptr) {
+      return;
+    }
+
+    uint8_t *pixel = this->buffer_ + (y - this->band_y_) * (this->native_width_ >> 1) + (x >> 1);
+    uint8_t current = *pixel;
+    uint8_t updated = (x & 0x1) ? (current & 0xF0) | nibble : (current & 0x0F) | (nibble << 4);
+
+    // Only pixels that actually change damage the panel
+    if (updated == current) {
+      return;
+    }
+    *pixel = updated;
+
+    // Consecutive pixels almost always land in the region touched last
+    if (this->last_dirty_region_ < this->dirty_region_count_) {
+      const display::Rect &last = this->dirty_regions_[this->last_dirty_region_];
+      if (x >= last.x && y >= last.y && x < last.x2() && y < last.y2()) {
+        return;
+      }
+    }
+    this->mark_dirty(x, y, 1, 1);
+  }
 
   int get_width_internal() override;
 
@@ -163,15 +209,79 @@ shown in Figure 1. The use of a white image in the transition from 4-bit to
     display::DisplayType::DISPLAY_TYPE_GRAYSCALE // .displayType (M5EPD supports 16 gray scale levels)
   };
 
-  uint8_t *should_write_buffer_{nullptr};
+  // Pixel data is streamed through this buffer, sized to suit a DMA transfer
+  static constexpr uint32_t STAGING_BUFFER_SIZE = 1024;
+  uint32_t staging_buffer_[STAGING_BUFFER_SIZE / 4];
+
+  // Damaged areas of the panel since the last refresh, in panel coordinates and 4-pixel aligned
+  static constexpr uint8_t MAX_DIRTY_REGIONS = 8;
+  // Regions closer than this are merged, a few extra pixels are cheaper than another refresh command
+  static constexpr int16_t DIRTY_MERGE_DISTANCE = 16;
+  display::Rect dirty_regions_[MAX_DIRTY_REGIONS];
+  uint8_t dirty_region_count_{0};
+  uint8_t last_dirty_region_{0};
+
+  // Changed pixels [x1, x2) of one row, as found by the frame diff
+  struct DiffSpan {
+    uint16_t y;
+    uint16_t x1;
+    uint16_t x2;
+  };
+  std::vector<DiffSpan> diff_spans_;
+  std::vector<display::Rect> diff_rects_;
+
+  // Fast refreshes each tile of the panel received since its last GC16
+  static constexpr int16_t GHOSTING_TILE_SIZE = 60;
+  static constexpr uint8_t GHOSTING_TILES_X = 16;
+  static constexpr uint8_t GHOSTING_TILES_Y = 9;
+  uint8_t ghosting_counters_[GHOSTING_TILES_Y][GHOSTING_TILES_X]{};
+  uint8_t ghosting_budget_{10};
+
+  // Refreshes run from loop() so the rest of the node keeps going while the panel updates
+  enum RefreshState : uint8_t {
+    REFRESH_IDLE,
+    REFRESH_UPLOAD,   // Sending the rows of diff_rects_[refresh_region_]
+    REFRESH_DISPLAY,  // Waiting to start the waveform of the uploaded region
+    REFRESH_WAIT,     // Waiting for all waveforms to finish
+  };
+  static constexpr uint32_t UPLOAD_CHUNK_SIZE = 8192;
+  static constexpr uint32_t UPLOAD_TIME_BUDGET = 8;
+  static constexpr uint32_t LUT_WAIT_TIMEOUT = 30;
+  static constexpr uint32_t LUT_POLL_INTERVAL = 10;
+  static constexpr uint32_t REFRESH_TIMEOUT = 5000;
+  RefreshState refresh_state_{REFRESH_IDLE};
+  size_t refresh_region_{0};
+  int16_t refresh_row_{0};
+  update_mode_e refresh_mode_{update_mode_e::UPDATE_MODE_NONE};
+  bool refresh_full_{false};
+  uint32_t refresh_wait_start_{0};
+  /// Start of the transfer of the refresh in progress, for the refresh time in the stats
+  uint32_t refresh_start_{0};
+  uint32_t last_lut_poll_{0};
+  HighFrequencyLoopRequester high_freq_;
+
+  // update() calls while a refresh is running
+  bool update_requested_{false};
+  bool slow_requested_{false};
+  CallbackManager<void()> refresh_complete_callback_;
+
+  // Black and white regions go out as 1bpp bitmaps, an eighth of the 4bpp payload
+  bool bitmap_upload_{true};
+  bool refresh_bitmap_{false};
+  bool bitmap_mode_{false};
+
+  // Without a full frame buffer the page is drawn a band of rows at a time and each band is streamed to the
+  // image memory of the controller. A hash per band tells which ones changed since the last refresh.
+  uint16_t band_height_{0};
+  std::vector<uint32_t> band_hashes_;
+  std::vector<uint16_t> band_levels_;
+
   void get_device_info(struct IT8951DevInfo_s *info);
 
-  uint32_t max_x = 0;
-  uint32_t max_y = 0;
-  uint32_t min_x = 960;
-  uint32_t min_y = 540;
   uint16_t m_endian_type, m_pix_bpp;
   uint8_t *previous_buffer_{nullptr};
+  // The content of the panel is unknown until the first frame went out
+  bool previous_buffer_valid_{false};
 
   GPIOPin *reset_pin_{nullptr};
   GPIOPin *busy_pin_{nullptr};
@@ -184,6 +294,7 @@ shown in Figure 1. The use of a white image in the transition from 4-bit to
 
   void wait_busy(uint32_t timeout = 30);
   void check_busy(uint32_t timeout = 30);
+  bool is_lut_busy();
 
   uint16_t get_vcom();
   void set_vcom(uint16_t vcom);
@@ -196,21 +307,42 @@ shown in Figure 1. The use of a white image in the transition from 4-bit to
   void write_command(uint16_t cmd);
   void write_word(uint16_t cmd);
   void write_reg(uint16_t addr, uint16_t data);
+  uint16_t read_reg(uint16_t addr);
   void set_target_memory_addr(uint16_t tar_addrL, uint16_t tar_addrH);
   void write_args(uint16_t cmd, uint16_t *args, uint16_t length);
 
   void set_area(uint16_t x, uint16_t y, uint16_t w, uint16_t h);
   void update_area(uint16_t x, uint16_t y, uint16_t w,
-                    uint16_t h, update_mode_e mode);
-
-  void log_buffer(uint8_t *buff, uint32_t buff_size);
-  void calculate_update_region();
-  void write_buffer_to_display_fast(uint16_t x, uint16_t y, uint16_t w,
-    uint16_t h, const uint8_t *gram);
-  void write_buffer_to_display(uint16_t x, uint16_t y, uint16_t w,
-                                uint16_t h, const uint8_t *gram);
+                    uint16_t h, update_mode_e mode, bool bitmap = false);
+
+  void mark_dirty(int x, int y, int w, int h);
+  void merge_dirty_regions(uint8_t index);
+  void reset_dirty();
+  void diff_region(const display::Rect &area);
+  uint16_t get_gray_levels(const uint8_t *buffer, const display::Rect &region);
+  update_mode_e choose_update_mode(const display::Rect &region);
+  update_mode_e choose_update_mode(const display::Rect &region, uint16_t levels, uint16_t previous_levels);
+  void reset_ghosting();
+  void add_diff_rect(const display::Rect &rect);
+
+  void stream_gram(const uint8_t *gram, uint32_t row_bytes, uint32_t rows, uint32_t stride);
+  void stream_bitmap(const uint8_t *gram, uint16_t w, uint32_t rows, uint32_t stride);
+  void set_bitmap_mode(bool enable);
+  uint32_t get_bitmap_addr_();
   void write_display();
   void write_display_slow();
+  void write_display_banded(bool full);
+  void start_refresh();
+  void upload_step();
+  void finish_refresh();
+  void abort_refresh();
+};
+
+class RefreshCompleteTrigger : public Trigger<> {
+ public:
+  explicit RefreshCompleteTrigger(IT8951ESensor *parent) {
+    parent->add_on_refresh_complete_callback([this]() { this->trigger(); });
+  }
 };
 
 template<typename... Ts> class ClearAction : public Action<Ts...>, public Parented<IT8951ESensor> {
@@ -2,7 +2,15 @@ import esphome.codegen as cg
 import esphome.config_validation as cv
 from esphome import automation, pins
 from esphome.components import uart
-from esphome.const import CONF_ID, CONF_TRIGGER_ID, CONF_CHANNEL, CONF_MESSAGE
+from esphome.const import (
+    CONF_ACCURACY_DECIMALS,
+    CONF_CHANNEL,
+    CONF_ID,
+    CONF_KEY,
+    CONF_MESSAGE,
+    CONF_TRIGGER_ID,
+    CONF_VALUE,
+)
 import base64
 
 DEPENDENCIES = ["uart"]
@@ -11,6 +19,18 @@ CODEOWNERS = ["@ton"]
 CONF_POWER_PIN = "power_pin"
 CONF_BOOT_TIMEOUT = "boot_timeout"
 CONF_ACK_TIMEOUT = "ack_timeout"
+CONF_MAX_RETRIES = "max_retries"
+CONF_MAX_IN_FLIGHT = "max_in_flight"
+CONF_QUEUE_SIZE = "queue_size"
+CONF_NODE_TABLE_SIZE = "node_table_size"
+CONF_RESTORE_NODES = "restore_nodes"
+CONF_MAX_NODE_AGE = "max_node_age"
+CONF_REASSEMBLY_SLOTS = "reassembly_slots"
+CONF_REASSEMBLY_TIMEOUT = "reassembly_timeout"
+CONF_COMPRESS = "compress"
+CONF_KEY_FRAME_INTERVAL = "key_frame_interval"
+CONF_READINGS = "readings"
+CONF_ON_READINGS = "on_readings"
 CONF_DESTINATION = "destination"
 CONF_ENABLE_ON_BOOT = "enable_on_boot"
 CONF_ON_READY = "on_ready"
@@ -23,12 +43,16 @@ meshtastic_ns = cg.esphome_ns.namespace("meshtastic")
 MeshtasticComponent = meshtastic_ns.class_(
     "MeshtasticComponent", cg.Component, uart.UARTDevice
 )
+Reading = meshtastic_ns.struct("Reading")
 
 # Triggers
 ReadyTrigger = meshtastic_ns.class_("ReadyTrigger", automation.Trigger.template())
 MessageTrigger = meshtastic_ns.class_(
     "MessageTrigger", automation.Trigger.template(cg.std_string)
 )
+ReadingsTrigger = meshtastic_ns.class_(
+    "ReadingsTrigger", automation.Trigger.template(cg.std_vector.template(Reading))
+)
 SendSuccessTrigger = meshtastic_ns.class_(
     "SendSuccessTrigger", automation.Trigger.template()
 )
@@ -38,6 +62,8 @@ SendFailedTrigger = meshtastic_ns.class_(
 
 # Actions
 SendTextAction = meshtastic_ns.class_("SendTextAction", automation.Action)
+SendDataAction = meshtastic_ns.class_("SendDataAction", automation.Action)
+SendReadingsAction = meshtastic_ns.class_("SendReadingsAction", automation.Action)
 SendNodeInfoAction = meshtastic_ns.class_("SendNodeInfoAction", automation.Action)
 PowerOnAction = meshtastic_ns.class_("PowerOnAction", automation.Action)
 PowerOffAction = meshtastic_ns.class_("PowerOffAction", automation.Action)
@@ -312,6 +338,17 @@ CONFIG_SCHEMA = (
             cv.Optional(
                 CONF_ACK_TIMEOUT, default="30s"
             ): cv.positive_time_period_milliseconds,
+            cv.Optional(CONF_MAX_RETRIES, default=0): cv.int_range(min=0, max=10),
+            cv.Optional(CONF_MAX_IN_FLIGHT, default=4): cv.int_range(min=1, max=16),
+            cv.Optional(CONF_QUEUE_SIZE, default=8): cv.int_range(min=1, max=64),
+            cv.Optional(CONF_NODE_TABLE_SIZE, default=32): cv.int_range(min=0, max=250),
+            cv.Optional(CONF_RESTORE_NODES, default=False): cv.boolean,
+            cv.Optional(CONF_MAX_NODE_AGE): cv.positive_time_period_seconds,
+            cv.Optional(CONF_REASSEMBLY_SLOTS, default=2): cv.int_range(min=0, max=8),
+            cv.Optional(
+                CONF_REASSEMBLY_TIMEOUT, default="60s"
+            ): cv.positive_time_period_milliseconds,
+            cv.Optional(CONF_KEY_FRAME_INTERVAL, default=10): cv.int_range(min=1, max=255),
             cv.Optional(CONF_DESTINATION, default=0xFFFFFFFF): cv.hex_uint32_t,
             cv.Optional(CONF_CHANNEL, default=0): cv.uint8_t,
             cv.Optional(CONF_ENABLE_ON_BOOT, default=True): cv.boolean,
@@ -322,6 +359,9 @@ CONFIG_SCHEMA = (
             cv.Optional(CONF_ON_MESSAGE): automation.validate_automation(
                 {cv.GenerateID(CONF_TRIGGER_ID): cv.declare_id(MessageTrigger)}
             ),
+            cv.Optional(CONF_ON_READINGS): automation.validate_automation(
+                {cv.GenerateID(CONF_TRIGGER_ID): cv.declare_id(ReadingsTrigger)}
+            ),
             cv.Optional(CONF_ON_SEND_SUCCESS): automation.validate_automation(
                 {cv.GenerateID(CONF_TRIGGER_ID): cv.declare_id(SendSuccessTrigger)}
             ),
@@ -346,6 +386,16 @@ async def to_code(config):
 
     cg.add(var.set_boot_timeout(config[CONF_BOOT_TIMEOUT]))
     cg.add(var.set_ack_timeout(config[CONF_ACK_TIMEOUT]))
+    cg.add(var.set_max_retries(config[CONF_MAX_RETRIES]))
+    cg.add(var.set_max_in_flight(config[CONF_MAX_IN_FLIGHT]))
+    cg.add(var.set_queue_size(config[CONF_QUEUE_SIZE]))
+    cg.add(var.set_node_table_size(config[CONF_NODE_TABLE_SIZE]))
+    cg.add(var.set_restore_nodes(config[CONF_RESTORE_NODES]))
+    if CONF_MAX_NODE_AGE in config:
+        cg.add(var.set_max_node_age(config[CONF_MAX_NODE_AGE]))
+    cg.add(var.set_reassembly_slots(config[CONF_REASSEMBLY_SLOTS]))
+    cg.add(var.set_reassembly_timeout(config[CONF_REASSEMBLY_TIMEOUT]))
+    cg.add(var.set_key_frame_interval(config[CONF_KEY_FRAME_INTERVAL]))
     cg.add(var.set_default_destination(config[CONF_DESTINATION]))
     cg.add(var.set_default_channel(config[CONF_CHANNEL]))
     cg.add(var.set_enable_on_boot(config[CONF_ENABLE_ON_BOOT]))
@@ -421,6 +471,12 @@ async def to_code(config):
         trigger = cg.new_Pvariable(conf[CONF_TRIGGER_ID], var)
         await automation.build_automation(trigger, [(cg.std_string, "x")], conf)
 
+    for conf in config.get(CONF_ON_READINGS, []):
+        trigger = cg.new_Pvariable(conf[CONF_TRIGGER_ID], var)
+        await automation.build_automation(
+            trigger, [(cg.std_vector.template(Reading), "x")], conf
+        )
+
     for conf in config.get(CONF_ON_SEND_SUCCESS, []):
         trigger = cg.new_Pvariable(conf[CONF_TRIGGER_ID], var)
         await automation.build_automation(trigger, [], conf)
@@ -441,6 +497,31 @@ SEND_TEXT_SCHEMA = cv.Schema(
     }
 )
 
+SEND_DATA_SCHEMA = SEND_TEXT_SCHEMA.extend(
+    {
+        cv.Optional(CONF_COMPRESS, default=False): cv.templatable(cv.boolean),
+    }
+)
+
+SEND_READINGS_SCHEMA = cv.Schema(
+    {
+        cv.GenerateID(): cv.use_id(MeshtasticComponent),
+        cv.Required(CONF_READINGS): cv.ensure_list(
+            cv.Schema(
+                {
+                    cv.Required(CONF_KEY): cv.int_range(min=0, max=65535),
+                    cv.Required(CONF_VALUE): cv.templatable(cv.float_),
+                    cv.Optional(CONF_ACCURACY_DECIMALS, default=0): cv.int_range(
+                        min=0, max=7
+                    ),
+                }
+            )
+        ),
+        cv.Optional(CONF_DESTINATION): cv.templatable(cv.hex_uint32_t),
+        cv.Optional(CONF_CHANNEL): cv.templatable(cv.uint8_t),
+    }
+)
+
 POWER_ON_SCHEMA = cv.Schema(
     {
         cv.GenerateID(): cv.use_id(MeshtasticComponent),
@@ -471,6 +552,34 @@ async def send_text_to_code(config, action_id, template_arg, args):
     return var
 
 
+@automation.register_action(
+    "meshtastic.send_data", SendDataAction, SEND_DATA_SCHEMA
+)
+async def send_data_to_code(config, action_id, template_arg, args):
+    var = await send_text_to_code(config, action_id, template_arg, args)
+    tmpl = await cg.templatable(config[CONF_COMPRESS], args, bool)
+    cg.add(var.set_compress(tmpl))
+    return var
+
+
+@automation.register_action(
+    "meshtastic.send_readings", SendReadingsAction, SEND_READINGS_SCHEMA
+)
+async def send_readings_to_code(config, action_id, template_arg, args):
+    parent = await cg.get_variable(config[CONF_ID])
+    var = cg.new_Pvariable(action_id, template_arg, parent)
+    for reading in config[CONF_READINGS]:
+        tmpl = await cg.templatable(reading[CONF_VALUE], args, float)
+        cg.add(var.add_reading(reading[CONF_KEY], reading[CONF_ACCURACY_DECIMALS], tmpl))
+    if CONF_DESTINATION in config:
+        tmpl = await cg.templatable(config[CONF_DESTINATION], args, cg.uint32)
+        cg.add(var.set_destination(tmpl))
+    if CONF_CHANNEL in config:
+        tmpl = await cg.templatable(config[CONF_CHANNEL], args, cg.uint8)
+        cg.add(var.set_channel(tmpl))
+    return var
+
+
 @automation.register_action("meshtastic.power_on", PowerOnAction, POWER_ON_SCHEMA)
 async def power_on_to_code(config, action_id, template_arg, args):
     parent = await cg.get_variable(config[CONF_ID])
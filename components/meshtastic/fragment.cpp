@@ -0,0 +1,100 @@
+#include "fragment.h"
+
+#include <cstring>
+
+namespace esphome {
+namespace meshtastic {
+
+void FragmentHeader::write(uint8_t *out) const {
+  out[0] = this->transfer_id & 0xFF;
+  out[1] = this->transfer_id >> 8;
+  out[2] = this->index;
+  out[3] = this->count;
+  out[4] = this->flags;
+}
+
+bool FragmentHeader::read(const uint8_t *data, size_t len) {
+  if (len < SIZE || (data[4] & VERSION_MASK) != VERSION)
+    return false;
+  this->transfer_id = data[0] | (data[1] << 8);
+  this->index = data[2];
+  this->count = data[3];
+  this->flags = data[4];
+  return this->count != 0 && this->count <= MAX_FRAGMENTS && this->index < this->count;
+}
+
+bool Reassembler::add(uint32_t from, const FragmentHeader &header, const uint8_t *data, size_t len, uint32_t now,
+                      std::string *payload, uint8_t *flags) {
+  // Every fragment but the last is full, which puts each one at a fixed offset
+  bool last = header.index == header.count - 1;
+  if (len > FRAGMENT_DATA_SIZE || (!last && len != FRAGMENT_DATA_SIZE))
+    return false;
+
+  Slot *slot = this->find_slot_(from, header.transfer_id, now);
+  if (slot == nullptr)
+    return false;
+  if (slot->active && (slot->count != header.count || slot->flags != header.flags))
+    slot->active = false;  // Same id reused for another payload, start over
+  if (!slot->active) {
+    slot->active = true;
+    slot->from = from;
+    slot->transfer_id = header.transfer_id;
+    slot->count = header.count;
+    slot->flags = header.flags;
+    slot->received = 0;
+    slot->length = 0;
+    slot->data.resize(header.count * FRAGMENT_DATA_SIZE);
+  }
+  slot->updated_at = now;
+
+  uint32_t bit = 1UL << header.index;
+  if (slot->received & bit)
+    return false;  // Retransmitted by the mesh
+  slot->received |= bit;
+  memcpy(&slot->data[header.index * FRAGMENT_DATA_SIZE], data, len);
+  if (last)
+    slot->length = header.index * FRAGMENT_DATA_SIZE + len;
+
+  uint32_t all = header.count >= 32 ? 0xFFFFFFFFUL : (1UL << header.count) - 1;
+  if (slot->received != all)
+    return false;
+
+  slot->data.resize(slot->length);
+  *payload = std::move(slot->data);
+  *flags = slot->flags;
+  slot->data = std::string();
+  slot->active = false;
+  return true;
+}
+
+void Reassembler::expire(uint32_t now) {
+  for (Slot &slot : this->slots_) {
+    if (slot.active && now - slot.updated_at > this->timeout_) {
+      slot.active = false;
+      slot.data = std::string();  // Give the memory back
+    }
+  }
+}
+
+Reassembler::Slot *Reassembler::find_slot_(uint32_t from, uint16_t transfer_id, uint32_t now) {
+  Slot *free_slot = nullptr;
+  Slot *oldest = nullptr;
+  for (Slot &slot : this->slots_) {
+    if (!slot.active) {
+      if (free_slot == nullptr)
+        free_slot = &slot;
+    } else if (slot.from == from && slot.transfer_id == transfer_id) {
+      return &slot;
+    } else if (oldest == nullptr || now - slot.updated_at > now - oldest->updated_at) {
+      oldest = &slot;
+    }
+  }
+  if (free_slot != nullptr)
+    return free_slot;
+  if (oldest != nullptr)
+    oldest->active = false;
+  return oldest;
+}
+
+}  // namespace meshtastic
+}  // namespace esphome
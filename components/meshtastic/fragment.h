@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace esphome {
+namespace meshtastic {
+
+/** Payloads larger than one packet travel as numbered fragments on the private port.
+ *
+ * Each fragment carries a header of transfer id (16 bit little endian, chosen by the sender), fragment index,
+ * fragment count and flags, followed by FRAGMENT_DATA_SIZE bytes of the payload, fewer in the last fragment.
+ */
+struct FragmentHeader {
+  uint16_t transfer_id;
+  uint8_t index;
+  uint8_t count;
+  uint8_t flags;
+
+  static constexpr size_t SIZE = 5;
+  /// The upper nibble of flags tells the header version, fragments of another version are ignored.
+  static constexpr uint8_t VERSION = 0x10;
+  static constexpr uint8_t VERSION_MASK = 0xF0;
+  /// The reassembled payload is LZSS compressed.
+  static constexpr uint8_t FLAG_COMPRESSED = 0x01;
+
+  void write(uint8_t *out) const;
+  /// Reads and validates a header, false if the bytes are not a fragment.
+  bool read(const uint8_t *data, size_t len);
+};
+
+/// Meshtastic Data payloads are at most 233 bytes.
+static const size_t FRAGMENT_DATA_SIZE = 233 - FragmentHeader::SIZE;
+static const uint8_t MAX_FRAGMENTS = 32;
+static const size_t MAX_TRANSFER_SIZE = MAX_FRAGMENTS * FRAGMENT_DATA_SIZE;
+
+/** Puts fragments back together, holding a bounded number of transfers at a time.
+ *
+ * A transfer is identified by the sending node and its transfer id. When all slots are busy the transfer that made
+ * the least recent progress gives way, and one that gets no fragment for the timeout is dropped.
+ */
+class Reassembler {
+ public:
+  /// Clears all transfers in progress.
+  void set_slots(size_t slots) { this->slots_.assign(slots, Slot{}); }
+  void set_timeout(uint32_t ms) { this->timeout_ = ms; }
+  size_t get_slots() const { return this->slots_.size(); }
+  uint32_t get_timeout() const { return this->timeout_; }
+
+  /** Adds one fragment.
+   *
+   * @param data The fragment after its header
+   * @return true if this completed the transfer, its payload (still compressed if header flags say so) and flags
+   *         are then moved into `payload` and `flags`
+   */
+  bool add(uint32_t from, const FragmentHeader &header, const uint8_t *data, size_t len, uint32_t now,
+           std::string *payload, uint8_t *flags);
+  /// Drops transfers that got no fragment for the timeout.
+  void expire(uint32_t now);
+
+ protected:
+  struct Slot {
+    bool active{false};
+    uint32_t from{0};
+    uint16_t transfer_id{0};
+    uint8_t count{0};
+    uint8_t flags{0};
+    uint32_t received{0};  // Bit per fragment index
+    uint32_t updated_at{0};
+    size_t length{0};
+    std::string data;
+  };
+
+  Slot *find_slot_(uint32_t from, uint16_t transfer_id, uint32_t now);
+
+  std::vector<Slot> slots_;
+  uint32_t timeout_{60000};
+};
+
+}  // namespace meshtastic
+}  // namespace esphome
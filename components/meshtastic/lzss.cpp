@@ -0,0 +1,144 @@
+#include "lzss.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace esphome {
+namespace meshtastic {
+
+static const size_t WINDOW_SIZE = 4096;
+static const size_t MIN_MATCH = 3;
+static const size_t MAX_MATCH = MIN_MATCH + 15;
+static const size_t HASH_BITS = 10;
+static const uint16_t NO_POS = 0xFFFF;
+
+static size_t hash3(const uint8_t *p) {
+  uint32_t v = p[0] | (p[1] << 8) | (p[2] << 16);
+  return static_cast<uint32_t>(v * 2654435761UL) >> (32 - HASH_BITS);
+}
+
+bool lzss_compress(const uint8_t *data, size_t len, std::string *out) {
+  // Positions are kept as uint16_t, longer inputs are not worth compressing for the mesh anyway
+  if (len < MIN_MATCH || len >= NO_POS)
+    return false;
+
+  out->clear();
+  out->reserve(len);
+  for (size_t n = len; true; n >>= 7) {
+    if (n <= 0x7F) {
+      out->push_back(static_cast<char>(n));
+      break;
+    }
+    out->push_back(static_cast<char>((n & 0x7F) | 0x80));
+  }
+
+  // Most recent position of each 3 byte hash, with a chain to earlier ones inside the window
+  std::vector<uint16_t> head(1 << HASH_BITS, NO_POS);
+  std::vector<uint16_t> prev(len, NO_POS);
+  auto insert = [&](size_t pos) {
+    if (pos + MIN_MATCH > len)
+      return;
+    size_t h = hash3(data + pos);
+    prev[pos] = head[h];
+    head[h] = pos;
+  };
+
+  size_t flag_pos = 0;
+  uint8_t flag_bit = 8;
+  size_t pos = 0;
+  while (pos < len) {
+    if (flag_bit == 8) {
+      flag_pos = out->size();
+      out->push_back(0);
+      flag_bit = 0;
+    }
+
+    size_t best_len = 0;
+    size_t best_dist = 0;
+    if (pos + MIN_MATCH <= len) {
+      size_t limit = std::min(MAX_MATCH, len - pos);
+      // A short chain walk finds most matches, payloads are small enough that this stays cheap
+      uint16_t candidate = head[hash3(data + pos)];
+      for (int depth = 0; candidate != NO_POS && depth < 16; depth++, candidate = prev[candidate]) {
+        size_t dist = pos - candidate;
+        if (dist > WINDOW_SIZE)
+          break;
+        size_t n = 0;
+        while (n < limit && data[candidate + n] == data[pos + n])
+          n++;
+        if (n > best_len) {
+          best_len = n;
+          best_dist = dist;
+          if (n == limit)
+            break;
+        }
+      }
+    }
+
+    if (best_len >= MIN_MATCH) {
+      size_t code = ((best_dist - 1) << 4) | (best_len - MIN_MATCH);
+      out->push_back(static_cast<char>(code & 0xFF));
+      out->push_back(static_cast<char>(code >> 8));
+      (*out)[flag_pos] |= 1 << flag_bit;
+      for (size_t i = 0; i < best_len; i++)
+        insert(pos + i);
+      pos += best_len;
+    } else {
+      out->push_back(static_cast<char>(data[pos]));
+      insert(pos);
+      pos++;
+    }
+    flag_bit++;
+
+    if (out->size() >= len)
+      return false;
+  }
+  return true;
+}
+
+bool lzss_decompress(const uint8_t *data, size_t len, size_t max_len, std::string *out) {
+  size_t pos = 0;
+  size_t expected = 0;
+  for (int shift = 0;; shift += 7) {
+    if (pos >= len || shift > 28)
+      return false;
+    uint8_t b = data[pos++];
+    expected |= static_cast<size_t>(b & 0x7F) << shift;
+    if (!(b & 0x80))
+      break;
+  }
+  if (expected > max_len)
+    return false;
+
+  out->clear();
+  out->reserve(expected);
+  while (out->size() < expected) {
+    if (pos >= len)
+      return false;
+    uint8_t flags = data[pos++];
+    for (int bit = 0; bit < 8 && out->size() < expected; bit++) {
+      if (flags & (1 << bit)) {
+        if (pos + 2 > len)
+          return false;
+        size_t code = data[pos] | (data[pos + 1] << 8);
+        pos += 2;
+        size_t dist = (code >> 4) + 1;
+        size_t n = (code & 0x0F) + MIN_MATCH;
+        if (dist > out->size() || out->size() + n > expected)
+          return false;
+        // Byte by byte, a match may overlap the bytes it produces
+        size_t from = out->size() - dist;
+        for (size_t i = 0; i < n; i++)
+          out->push_back((*out)[from + i]);
+      } else {
+        if (pos >= len)
+          return false;
+        out->push_back(static_cast<char>(data[pos++]));
+      }
+    }
+  }
+  return pos == len;
+}
+
+}  // namespace meshtastic
+}  // namespace esphome
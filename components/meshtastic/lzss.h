@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace esphome {
+namespace meshtastic {
+
+/** LZSS compression for payloads sent over the mesh.
+ *
+ * The output starts with the uncompressed length as a varint. Then come groups of up to eight items, each preceded
+ * by a flag byte whose bits (least significant first) tell whether the item is a literal byte (0) or a two byte
+ * back reference (1) of 3 to 18 bytes at a distance of 1 to 4096. It is far simpler than deflate and needs no
+ * library, yet text like logs and JSON shrinks by a third or more, which is what counts at LoRa data rates.
+ */
+
+/// Compresses `len` bytes into `out`. Returns false if the result would not be smaller than the input.
+bool lzss_compress(const uint8_t *data, size_t len, std::string *out);
+/// Decompresses into `out`. Returns false if the data is malformed or would expand past `max_len` bytes.
+bool lzss_decompress(const uint8_t *data, size_t len, size_t max_len, std::string *out);
+
+}  // namespace meshtastic
+}  // namespace esphome
@@ -1,6 +1,10 @@
 #include "meshtastic.h"
+#include "lzss.h"
 #include "esphome/core/log.h"
 
+#include <algorithm>
+#include <memory>
+
 #ifdef USE_ESP_IDF
 #include <esp_random.h>
 #endif
@@ -14,24 +18,40 @@ static const char *const TAG = "meshtastic";
 static const uint8_t START1 = 0x94;
 static const uint8_t START2 = 0xC3;
 
-// Protobuf wire types
-static const uint8_t WT_VARINT = 0;
-static const uint8_t WT_64BIT = 1;
-static const uint8_t WT_LENGTH = 2;
-static const uint8_t WT_32BIT = 5;
-
 // Meshtastic PortNum values
 static const uint32_t PORTNUM_TEXT_MESSAGE = 1;
 static const uint32_t PORTNUM_NODEINFO_APP = 4;
 static const uint32_t PORTNUM_ROUTING = 5;
 static const uint32_t PORTNUM_ADMIN = 6;
+static const uint32_t PORTNUM_TELEMETRY = 67;
+static const uint32_t PORTNUM_PRIVATE = 256;
+static const uint32_t PORTNUM_READINGS = 257;
+
+// Largest Data payload of one packet
+static const size_t MAX_DATA_PAYLOAD = 233;
 
 // Routing::Error
 static const uint32_t ROUTING_ERROR_NONE = 0;
 
+// AdminMessage fields carrying configuration
+static const uint32_t ADMIN_SET_CHANNEL = 33;
+static const uint32_t ADMIN_SET_CONFIG = 34;
+static const uint32_t ADMIN_SET_MODULE_CONFIG = 35;
+
+// Radio TX queue pacing: without a QueueStatus saying there is room, one packet is sent per interval, doubling while
+// the radio keeps reporting a full queue. Firmware that sends no QueueStatus at all is paced at the first interval.
+static const uint32_t RADIO_QUEUE_PROBE_INTERVAL = 200;
+static const uint32_t RADIO_QUEUE_MAX_PROBE_INTERVAL = 5000;
+
 // ---- Component lifecycle ----
 
 void MeshtasticComponent::setup() {
+  this->mark_config_differs_();
+  // Transfer ids must not repeat those of fragments a receiver may still hold from before a reboot
+  this->transfer_id_counter_ = esp_random();
+  this->nodes_.set_capacity(this->node_table_size_);
+  if (this->restore_nodes_)
+    this->load_nodes_();
   if (this->power_pin_ != nullptr) {
     this->power_pin_->setup();
     this->power_pin_->digital_write(false);
@@ -100,10 +120,21 @@ void MeshtasticComponent::loop() {
       if (this->state_ != State::APPLYING_CONFIG)
         break;
 
+      // The radio turned the last admin message away with a full TX queue: send it again once there is room, the
+      // phases only move on after it was taken
+      if (this->admin_packet_held_) {
+        if (this->radio_queue_ready_(now)) {
+          this->transmit_admin_();
+          this->state_start_ = now;
+        }
+        break;
+      }
+
       // Phase 0: sending settings batch (begin_edit + set_config/set_module + commit_edit)
       if (this->config_phase_ == 0) {
-        // Send messages with 200ms spacing
-        if (now - this->state_start_ > 200) {
+        // The next message goes out once the radio took the previous one, or after the probe interval
+        if ((this->admin_packet_queued_ || now - this->state_start_ > RADIO_QUEUE_PROBE_INTERVAL) &&
+            this->radio_queue_ready_(now)) {
           if (this->config_msg_index_ < this->config_admin_msgs_.size()) {
             this->send_next_config_msg_();
             this->state_start_ = now;
@@ -119,9 +150,10 @@ void MeshtasticComponent::loop() {
       else if (this->config_phase_ == 1) {
         // commit_edit saves settings to flash without needing a reboot.
         // If the device does reboot (some firmware versions), the reboot
-        // handler will detect it and re-init. Otherwise, proceed after 2s.
-        if (now - this->state_start_ > 2000) {
-          if (this->has_channel_config_) {
+        // handler will detect it and re-init. Otherwise, proceed once the
+        // radio reports the commit as handled, or after 2s.
+        if (this->admin_packet_queued_ || now - this->state_start_ > 2000) {
+          if (this->has_channel_config_ && this->channel_differs_) {
             ESP_LOGI(TAG, "Settings committed, sending channel config...");
             this->config_phase_ = 2;
             this->state_start_ = now;
@@ -134,7 +166,7 @@ void MeshtasticComponent::loop() {
       }
       // Phase 2: sending channel config
       else if (this->config_phase_ == 2) {
-        if (now - this->state_start_ > 500) {
+        if ((this->admin_packet_queued_ || now - this->state_start_ > 500) && this->radio_queue_ready_(now)) {
           if (this->has_channel_config_) {
             ESP_LOGI(TAG, "Sending channel configuration...");
             this->send_admin_message_(this->channel_admin_msg_.data, this->channel_admin_msg_.len);
@@ -145,12 +177,13 @@ void MeshtasticComponent::loop() {
       }
       // Phase 3: send reboot to persist all config changes
       else if (this->config_phase_ == 3) {
-        if (now - this->state_start_ > 500) {
+        if ((this->admin_packet_queued_ || now - this->state_start_ > 500) && this->radio_queue_ready_(now)) {
           ESP_LOGI(TAG, "Sending reboot to apply configuration...");
           // AdminMessage { reboot_seconds = 2 } -> field 97, varint
           uint8_t reboot_msg[4];
-          size_t rlen = this->encode_field_varint_(reboot_msg, 97, 2);
-          this->send_admin_message_(reboot_msg, rlen);
+          ProtoWriter reboot(reboot_msg, sizeof(reboot_msg));
+          reboot.write_varint(97, 2);
+          this->send_admin_message_(reboot.data(), reboot.size());
           this->config_phase_ = 4;
           this->state_start_ = now;
         }
@@ -170,20 +203,15 @@ void MeshtasticComponent::loop() {
       break;
 
     case State::READY:
-      this->process_serial_();
-      break;
-
     case State::SENDING:
       this->process_serial_();
-      // process_serial_ may have changed state (ACK received -> READY)
-      if (this->state_ != State::SENDING)
+      // process_serial_ may have changed state (device reboot -> INITIALIZING)
+      if (this->state_ != State::READY && this->state_ != State::SENDING)
         break;
-      if (now - this->state_start_ > this->ack_timeout_) {
-        ESP_LOGW(TAG, "ACK timeout for packet 0x%08X", this->pending_packet_id_);
-        this->pending_packet_id_ = 0;
-        this->state_ = State::READY;
-        this->on_send_failed_callbacks_.call();
-      }
+      this->process_outbound_(now);
+      this->reassembler_.expire(now);
+      if (this->nodes_dirty_ && now - this->nodes_saved_at_ > NODE_SAVE_INTERVAL)
+        this->save_nodes_();
       break;
   }
 }
@@ -195,6 +223,16 @@ void MeshtasticComponent::dump_config() {
   }
   ESP_LOGCONFIG(TAG, "  Boot Timeout: %ums", this->boot_timeout_);
   ESP_LOGCONFIG(TAG, "  ACK Timeout: %ums", this->ack_timeout_);
+  ESP_LOGCONFIG(TAG, "  Max Retries: %u", this->max_retries_);
+  ESP_LOGCONFIG(TAG, "  Max In Flight: %u", this->max_in_flight_);
+  ESP_LOGCONFIG(TAG, "  Queue Size: %u", this->queue_size_);
+  ESP_LOGCONFIG(TAG, "  Node Table: %u nodes (restore=%s)", this->nodes_.get_capacity(),
+                this->restore_nodes_ ? "yes" : "no");
+  if (this->max_node_age_ != 0)
+    ESP_LOGCONFIG(TAG, "  Max Node Age: %us", this->max_node_age_);
+  ESP_LOGCONFIG(TAG, "  Reassembly: %u transfers, %ums timeout", this->reassembler_.get_slots(),
+                this->reassembler_.get_timeout());
+  ESP_LOGCONFIG(TAG, "  Readings Key Frame Interval: %u", this->readings_encoder_.get_key_frame_interval());
   ESP_LOGCONFIG(TAG, "  Default Destination: 0x%08X", this->default_destination_);
   ESP_LOGCONFIG(TAG, "  Default Channel: %u", this->default_channel_);
   if (!this->config_admin_msgs_.empty()) {
@@ -205,6 +243,12 @@ void MeshtasticComponent::dump_config() {
   }
 }
 
+void MeshtasticComponent::on_safe_shutdown() {
+  // Deep sleep and reboots end here, keep what was learned about the mesh
+  if (this->nodes_dirty_)
+    this->save_nodes_();
+}
+
 // ---- Public API ----
 
 void MeshtasticComponent::power_on() {
@@ -222,12 +266,12 @@ void MeshtasticComponent::power_on() {
   this->state_ = State::POWERING_ON;
   this->state_start_ = millis();
   this->boot_start_ = this->state_start_;
-  this->rx_state_ = RX_WAIT_START1;
-  this->rx_pos_ = 0;
+  this->rx_start_ = 0;
+  this->rx_len_ = 0;
   this->my_node_num_ = 0;
   this->my_long_name_.clear();
   this->my_short_name_.clear();
-  this->pending_packet_id_ = 0;
+  this->drop_outbound_();
   // Reset config state
   this->config_msg_index_ = 0;
   this->config_phase_ = 0;
@@ -239,64 +283,179 @@ void MeshtasticComponent::power_off() {
     return;
   }
   ESP_LOGI(TAG, "Powering OFF Meshtastic device");
+  if (this->nodes_dirty_)
+    this->save_nodes_();
   this->power_pin_->digital_write(false);
   this->state_ = State::OFF;
-  this->pending_packet_id_ = 0;
+  this->drop_outbound_();
   this->my_node_num_ = 0;
   this->my_long_name_.clear();
   this->my_short_name_.clear();
 }
 
-bool MeshtasticComponent::send_text(const std::string &message, uint32_t destination, uint8_t channel) {
+bool MeshtasticComponent::can_send_(uint32_t destination, const char *what) {
   if (this->state_ != State::READY && this->state_ != State::SENDING) {
-    ESP_LOGW(TAG, "Cannot send text, not ready (state=%d)", static_cast<int>(this->state_));
+    ESP_LOGW(TAG, "Cannot send %s, not ready (state=%d)", what, static_cast<int>(this->state_));
     return false;
   }
 
-  if (message.length() > 233) {
-    ESP_LOGW(TAG, "Message too long (%u bytes, max 233)", message.length());
+  // Ages are only known once the radio told us the time, until then nothing is refused for its age
+  uint32_t age = this->get_node_age(destination);
+  if (destination != 0xFFFFFFFF && this->max_node_age_ != 0 && this->get_mesh_time() != 0 &&
+      age > this->max_node_age_) {
+    // Fail now instead of waiting out the ACK timeout for a node that is most likely gone
+    if (age == UINT32_MAX) {
+      ESP_LOGW(TAG, "Not sending to 0x%08X, node never heard", destination);
+    } else {
+      ESP_LOGW(TAG, "Not sending to 0x%08X, last heard %us ago", destination, age);
+    }
     return false;
   }
+  return true;
+}
 
-  uint32_t packet_id = this->generate_packet_id_();
+bool MeshtasticComponent::send_text(const std::string &message, uint32_t destination, uint8_t channel,
+                                    SendCallback &&callback) {
+  if (message.length() > MAX_DATA_PAYLOAD) {
+    ESP_LOGW(TAG, "Message too long (%u bytes, max %u)", message.length(), MAX_DATA_PAYLOAD);
+    return false;
+  }
+  if (!this->can_send_(destination, "text"))
+    return false;
 
-  // Encode Data sub-message: portnum=TEXT_MESSAGE(1), payload=message bytes
-  uint8_t data_buf[256];
-  size_t data_len = 0;
-  data_len += this->encode_field_varint_(data_buf + data_len, 1, PORTNUM_TEXT_MESSAGE);
-  data_len += this->encode_field_bytes_(data_buf + data_len, 2,
-                                        reinterpret_cast<const uint8_t *>(message.c_str()), message.length());
-
-  // Encode MeshPacket sub-message
-  uint8_t pkt_buf[300];
-  size_t pkt_len = 0;
-  pkt_len += this->encode_field_fixed32_(pkt_buf + pkt_len, 2, destination);   // to
-  pkt_len += this->encode_field_varint_(pkt_buf + pkt_len, 3, channel);        // channel
-  pkt_len += this->encode_field_bytes_(pkt_buf + pkt_len, 4, data_buf, data_len);  // decoded (Data)
-  pkt_len += this->encode_field_fixed32_(pkt_buf + pkt_len, 6, packet_id);     // id
-  pkt_len += this->encode_field_varint_(pkt_buf + pkt_len, 9, 3);             // hop_limit
-  pkt_len += this->encode_field_varint_(pkt_buf + pkt_len, 10, 1);            // want_ack = true
-  pkt_len += this->encode_field_varint_(pkt_buf + pkt_len, 11, 70);           // priority = RELIABLE
-
-  // Encode ToRadio: packet (field 1, length-delimited)
-  uint8_t toradio_buf[320];
-  size_t toradio_len = 0;
-  toradio_len += this->encode_field_bytes_(toradio_buf + toradio_len, 1, pkt_buf, pkt_len);
-
-  this->send_framed_(toradio_buf, toradio_len);
-
-  ESP_LOGI(TAG, "Sent text (id=0x%08X dest=0x%08X ch=%u len=%u): %s",
-           packet_id, destination, channel, message.length(), message.c_str());
-
-  this->pending_packet_id_ = packet_id;
-  this->pending_destination_ = destination;
-  this->state_ = State::SENDING;
-  this->state_start_ = millis();
+  if (this->outbound_.size() >= this->queue_size_) {
+    ESP_LOGW(TAG, "Outbound queue full (%u messages), dropping text", this->outbound_.size());
+    return false;
+  }
+
+  OutboundPacket packet;
+  packet.payload = message;
+  packet.destination = destination;
+  packet.portnum = PORTNUM_TEXT_MESSAGE;
+  packet.channel = channel;
+  packet.callback = std::move(callback);
+  this->outbound_.push_back(std::move(packet));
+
+  // Send right away if an in-flight slot is free
+  this->process_outbound_(millis());
+  return true;
+}
+
+bool MeshtasticComponent::send_data(const std::string &payload, uint32_t destination, uint8_t channel, bool compress,
+                                    SendCallback &&callback) {
+  if (!this->can_send_(destination, "data"))
+    return false;
+
+  // The receiver bounds the decompressed size by the same limit; checked first, compressing costs memory
+  if (payload.size() > MAX_TRANSFER_SIZE || payload.empty()) {
+    ESP_LOGW(TAG, "Cannot send %u bytes of data (1 to %u)", payload.size(), MAX_TRANSFER_SIZE);
+    return false;
+  }
+
+  uint8_t flags = FragmentHeader::VERSION;
+  std::string compressed;
+  if (compress && lzss_compress(reinterpret_cast<const uint8_t *>(payload.data()), payload.size(), &compressed)) {
+    ESP_LOGD(TAG, "Compressed %u bytes to %u", payload.size(), compressed.size());
+    flags |= FragmentHeader::FLAG_COMPRESSED;
+  }
+  const std::string &body = (flags & FragmentHeader::FLAG_COMPRESSED) ? compressed : payload;
+
+  size_t count = (body.size() + FRAGMENT_DATA_SIZE - 1) / FRAGMENT_DATA_SIZE;
+  if (this->outbound_.size() + count > this->queue_size_) {
+    ESP_LOGW(TAG, "Outbound queue has no room for %u fragments (%u of %u used)", count, this->outbound_.size(),
+             this->queue_size_);
+    return false;
+  }
+
+  if (++this->transfer_id_counter_ == 0)
+    this->transfer_id_counter_++;
+  uint16_t transfer_id = this->transfer_id_counter_;
+
+  // One callback for the whole transfer, shared by its fragments
+  struct Transfer {
+    size_t remaining;
+    SendCallback callback;
+  };
+  auto transfer = std::make_shared<Transfer>(Transfer{count, std::move(callback)});
+  SendCallback on_fragment = [this, transfer, transfer_id](bool success) {
+    if (transfer->remaining == 0)
+      return;  // Already failed
+    if (success && --transfer->remaining != 0)
+      return;
+    if (!success) {
+      transfer->remaining = 0;
+      this->cancel_transfer_(transfer_id);
+    }
+    ESP_LOGI(TAG, "Transfer 0x%04X %s", transfer_id, success ? "delivered" : "failed");
+    if (transfer->callback)
+      transfer->callback(success);
+    if (success) {
+      this->on_send_success_callbacks_.call();
+    } else {
+      this->on_send_failed_callbacks_.call();
+    }
+  };
+
+  for (size_t i = 0; i < count; i++) {
+    size_t offset = i * FRAGMENT_DATA_SIZE;
+    size_t len = std::min(FRAGMENT_DATA_SIZE, body.size() - offset);
+    FragmentHeader header{transfer_id, static_cast<uint8_t>(i), static_cast<uint8_t>(count), flags};
+    OutboundPacket packet;
+    packet.payload.resize(FragmentHeader::SIZE);
+    header.write(reinterpret_cast<uint8_t *>(&packet.payload[0]));
+    packet.payload.append(body, offset, len);
+    packet.destination = destination;
+    packet.portnum = PORTNUM_PRIVATE;
+    packet.channel = channel;
+    packet.transfer_id = transfer_id;
+    packet.callback = on_fragment;
+    this->outbound_.push_back(std::move(packet));
+  }
+  ESP_LOGD(TAG, "Queued transfer 0x%04X: %u bytes in %u fragments", transfer_id, body.size(), count);
+
+  this->process_outbound_(millis());
+  return true;
+}
+
+bool MeshtasticComponent::send_readings(const std::vector<Reading> &readings, uint32_t destination, uint8_t channel,
+                                        SendCallback &&callback) {
+  if (!this->can_send_(destination, "readings"))
+    return false;
+  if (this->outbound_.size() >= this->queue_size_) {
+    ESP_LOGW(TAG, "Outbound queue full (%u messages), dropping readings", this->outbound_.size());
+    return false;
+  }
+
+  // A key frame is the one that has to fit, a delta frame that does not is sent as key frame instead
+  uint8_t frame[MAX_DATA_PAYLOAD];
+  ReadingsEncoder key_encoder;
+  size_t len = key_encoder.encode(readings, frame, sizeof(frame));
+  if (len == 0) {
+    ESP_LOGW(TAG, "%u readings do not fit in one packet", readings.size());
+    return false;
+  }
+
+  OutboundPacket packet;
+  packet.readings = readings;
+  packet.destination = destination;
+  packet.portnum = PORTNUM_READINGS;
+  packet.channel = channel;
+  // Later frames are differences to this one, if it got lost the next one has to stand on its own
+  packet.callback = [this, callback = std::move(callback)](bool success) {
+    if (!success)
+      this->readings_encoder_.reset();
+    if (callback)
+      callback(success);
+  };
+  this->outbound_.push_back(std::move(packet));
+  ESP_LOGD(TAG, "Queued %u readings", readings.size());
+
+  this->process_outbound_(millis());
   return true;
 }
 
 bool MeshtasticComponent::send_nodeinfo() {
-  if (this->state_ != State::READY) {
+  if (this->state_ != State::READY && this->state_ != State::SENDING) {
     ESP_LOGW(TAG, "Cannot send nodeinfo, not ready (state=%d)", static_cast<int>(this->state_));
     return false;
   }
@@ -305,47 +464,32 @@ bool MeshtasticComponent::send_nodeinfo() {
     return false;
   }
 
-  // Build User protobuf
-  // field 1: id (string) "!XXXXXXXX", field 2: long_name, field 3: short_name
+  // User: id (string) "!XXXXXXXX", long_name, short_name
   char id_str[12];
   snprintf(id_str, sizeof(id_str), "!%08x", this->my_node_num_);
-
-  uint8_t user_buf[128];
-  size_t user_len = 0;
-  user_len += this->encode_field_bytes_(user_buf + user_len, 1,
-    reinterpret_cast<const uint8_t *>(id_str), strlen(id_str));
-  if (!this->my_long_name_.empty()) {
-    user_len += this->encode_field_bytes_(user_buf + user_len, 2,
-      reinterpret_cast<const uint8_t *>(this->my_long_name_.c_str()), this->my_long_name_.length());
-  }
-  if (!this->my_short_name_.empty()) {
-    user_len += this->encode_field_bytes_(user_buf + user_len, 3,
-      reinterpret_cast<const uint8_t *>(this->my_short_name_.c_str()), this->my_short_name_.length());
-  }
-
-  // Encode Data: portnum=NODEINFO_APP(4), payload=User bytes
-  uint8_t data_buf[192];
-  size_t data_len = 0;
-  data_len += this->encode_field_varint_(data_buf + data_len, 1, PORTNUM_NODEINFO_APP);
-  data_len += this->encode_field_bytes_(data_buf + data_len, 2, user_buf, user_len);
-
-  // Encode MeshPacket: broadcast
   uint32_t packet_id = this->generate_packet_id_();
-  uint8_t pkt_buf[256];
-  size_t pkt_len = 0;
-  pkt_len += this->encode_field_fixed32_(pkt_buf + pkt_len, 2, 0xFFFFFFFF);  // to (broadcast)
-  pkt_len += this->encode_field_varint_(pkt_buf + pkt_len, 3, 0);             // channel 0
-  pkt_len += this->encode_field_bytes_(pkt_buf + pkt_len, 4, data_buf, data_len);
-  pkt_len += this->encode_field_fixed32_(pkt_buf + pkt_len, 6, packet_id);
-  pkt_len += this->encode_field_varint_(pkt_buf + pkt_len, 9, 3);             // hop_limit
-  pkt_len += this->encode_field_varint_(pkt_buf + pkt_len, 11, 70);           // priority = RELIABLE
-
-  // ToRadio: packet (field 1)
-  uint8_t toradio_buf[280];
-  size_t toradio_len = 0;
-  toradio_len += this->encode_field_bytes_(toradio_buf + toradio_len, 1, pkt_buf, pkt_len);
-
-  this->send_framed_(toradio_buf, toradio_len);
+
+  // ToRadio { packet = MeshPacket { to=broadcast, channel=0, decoded=Data { NODEINFO_APP, User } } }
+  this->send_to_radio_([&](auto &to_radio) {
+    to_radio.write_message(1, [&](auto &pkt) {
+      pkt.write_fixed32(2, 0xFFFFFFFF);  // to (broadcast)
+      pkt.write_varint(3, 0);            // channel 0
+      pkt.write_message(4, [&](auto &data) {
+        data.write_varint(1, PORTNUM_NODEINFO_APP);
+        data.write_message(2, [&](auto &user) {
+          user.write_bytes(1, reinterpret_cast<const uint8_t *>(id_str), strlen(id_str));
+          if (!this->my_long_name_.empty())
+            user.write_string(2, this->my_long_name_);
+          if (!this->my_short_name_.empty())
+            user.write_string(3, this->my_short_name_);
+        });
+      });
+      pkt.write_fixed32(6, packet_id);
+      pkt.write_varint(9, 3);    // hop_limit
+      pkt.write_varint(11, 70);  // priority = RELIABLE
+    });
+  });
+  this->note_radio_send_(millis());
 
   ESP_LOGI(TAG, "Sent nodeinfo broadcast (id=0x%08X, long=%s, short=%s)",
            packet_id, this->my_long_name_.c_str(), this->my_short_name_.c_str());
@@ -355,33 +499,39 @@ bool MeshtasticComponent::send_nodeinfo() {
 // ---- Admin config helpers ----
 
 void MeshtasticComponent::send_admin_message_(const uint8_t *admin_payload, size_t admin_len) {
-  // Wrap admin payload in: Data { portnum=ADMIN(6), payload=admin_payload }
-  uint8_t data_buf[256];
-  size_t data_len = 0;
-  data_len += this->encode_field_varint_(data_buf + data_len, 1, PORTNUM_ADMIN);
-  data_len += this->encode_field_bytes_(data_buf + data_len, 2, admin_payload, admin_len);
-
-  // MeshPacket { to=my_node_num, channel=0, decoded=data, id=..., hop_limit=3, want_ack=true }
-  uint8_t pkt_buf[300];
-  size_t pkt_len = 0;
-  pkt_len += this->encode_field_fixed32_(pkt_buf + pkt_len, 2, this->my_node_num_);  // to self
-  pkt_len += this->encode_field_varint_(pkt_buf + pkt_len, 3, 0);                     // channel 0
-  pkt_len += this->encode_field_bytes_(pkt_buf + pkt_len, 4, data_buf, data_len);
-  uint32_t pkt_id = this->generate_packet_id_();
-  pkt_len += this->encode_field_fixed32_(pkt_buf + pkt_len, 6, pkt_id);
-  pkt_len += this->encode_field_varint_(pkt_buf + pkt_len, 9, 3);   // hop_limit
-  pkt_len += this->encode_field_varint_(pkt_buf + pkt_len, 10, 1);  // want_ack
-
-  // ToRadio { packet (field 1) = pkt }
-  uint8_t toradio_buf[320];
-  size_t toradio_len = 0;
-  toradio_len += this->encode_field_bytes_(toradio_buf + toradio_len, 1, pkt_buf, pkt_len);
-
-  this->send_framed_(toradio_buf, toradio_len);
-  ESP_LOGD(TAG, "Sent admin message (%u bytes, pkt_id=0x%08X)", admin_len, pkt_id);
+  // ToRadio { packet = MeshPacket { to=my_node_num, channel=0, decoded=Data { ADMIN, admin_payload }, id,
+  //                                 hop_limit=3, want_ack=true } }
+  // Kept until the radio takes it, a message turned away for lack of room goes out again with the same id
+  this->admin_payload_.assign(reinterpret_cast<const char *>(admin_payload), admin_len);
+  this->admin_packet_id_ = this->generate_packet_id_();
+  this->transmit_admin_();
+}
+
+void MeshtasticComponent::transmit_admin_() {
+  this->send_to_radio_([&](auto &to_radio) {
+    to_radio.write_message(1, [&](auto &pkt) {
+      pkt.write_fixed32(2, this->my_node_num_);  // to self
+      pkt.write_varint(3, 0);                    // channel 0
+      pkt.write_message(4, [&](auto &data) {
+        data.write_varint(1, PORTNUM_ADMIN);
+        data.write_string(2, this->admin_payload_);
+      });
+      pkt.write_fixed32(6, this->admin_packet_id_);
+      pkt.write_varint(9, 3);   // hop_limit
+      pkt.write_varint(10, 1);  // want_ack
+    });
+  });
+  this->note_radio_send_(millis());
+  this->admin_packet_queued_ = false;
+  this->admin_packet_held_ = false;
+  ESP_LOGD(TAG, "Sent admin message (%u bytes, pkt_id=0x%08X)", this->admin_payload_.size(), this->admin_packet_id_);
 }
 
 void MeshtasticComponent::send_next_config_msg_() {
+  // Sections the radio already has are left out of the batch
+  while (this->config_msg_index_ < this->config_admin_msgs_.size() &&
+         !this->config_msg_differs_[this->config_msg_index_])
+    this->config_msg_index_++;
   if (this->config_msg_index_ >= this->config_admin_msgs_.size())
     return;
 
@@ -402,6 +552,8 @@ void MeshtasticComponent::apply_config() {
     return;
   }
   ESP_LOGI(TAG, "Applying admin configuration on demand...");
+  // On demand the whole configuration is sent, whatever the last dump said
+  this->mark_config_differs_();
   this->config_msg_index_ = 0;
   this->config_phase_ = 0;
   this->config_applied_ = false;
@@ -409,6 +561,169 @@ void MeshtasticComponent::apply_config() {
   this->state_start_ = millis();
 }
 
+// ---- Config diff ----
+
+bool MeshtasticComponent::unwrap_admin_section_(const AdminMsg &msg, uint32_t *admin_field, uint32_t *section_field,
+                                                const uint8_t **data, size_t *len) {
+  // AdminMessage { set_config/set_module_config = Config { <section> = ... } } or { set_channel = Channel }
+  size_t pos = 0;
+  uint32_t tag = this->decode_varint_(msg.data, &pos, msg.len);
+  *admin_field = tag >> 3;
+  if ((tag & 0x07) != WT_LENGTH)
+    return false;
+  if (*admin_field != ADMIN_SET_CONFIG && *admin_field != ADMIN_SET_MODULE_CONFIG && *admin_field != ADMIN_SET_CHANNEL)
+    return false;
+  size_t outer_len = this->decode_varint_(msg.data, &pos, msg.len);
+  if (pos + outer_len > msg.len)
+    return false;
+  if (*admin_field == ADMIN_SET_CHANNEL) {
+    *section_field = 0;
+    *data = msg.data + pos;
+    *len = outer_len;
+    return true;
+  }
+  size_t end = pos + outer_len;
+  uint32_t inner_tag = this->decode_varint_(msg.data, &pos, end);
+  if ((inner_tag & 0x07) != WT_LENGTH)
+    return false;
+  *section_field = inner_tag >> 3;
+  *len = this->decode_varint_(msg.data, &pos, end);
+  *data = msg.data + pos;
+  return pos + *len <= end;
+}
+
+bool MeshtasticComponent::find_field_(const uint8_t *buf, size_t len, uint32_t field_num, uint8_t *wire_type,
+                                      size_t *value_pos) {
+  // Protobuf lets a later occurrence override an earlier one, so the last match wins
+  bool found = false;
+  size_t pos = 0;
+  while (pos < len) {
+    uint32_t tag = this->decode_varint_(buf, &pos, len);
+    if ((tag >> 3) == field_num) {
+      found = true;
+      *wire_type = tag & 0x07;
+      *value_pos = pos;
+    }
+    if (!this->skip_field_(buf, &pos, len, tag & 0x07))
+      break;
+  }
+  return found;
+}
+
+bool MeshtasticComponent::proto_fields_match_(const uint8_t *wanted, size_t wanted_len, const uint8_t *actual,
+                                              size_t actual_len, uint32_t nested_field) {
+  size_t pos = 0;
+  while (pos < wanted_len) {
+    uint32_t tag = this->decode_varint_(wanted, &pos, wanted_len);
+    uint32_t field_num = tag >> 3;
+    uint8_t wire_type = tag & 0x07;
+    uint8_t actual_type = 0;
+    size_t actual_pos = 0;
+    // The radio leaves fields at their default out of the dump, a missing field reads as zero or empty
+    bool present = this->find_field_(actual, actual_len, field_num, &actual_type, &actual_pos);
+    if (present && actual_type != wire_type)
+      return false;
+
+    if (wire_type == WT_VARINT) {
+      uint32_t value = this->decode_varint_(wanted, &pos, wanted_len);
+      uint32_t actual_value = present ? this->decode_varint_(actual, &actual_pos, actual_len) : 0;
+      if (value != actual_value)
+        return false;
+    } else if (wire_type == WT_32BIT) {
+      if (pos + 4 > wanted_len || (present && actual_pos + 4 > actual_len))
+        return false;
+      uint32_t value = this->decode_fixed32_(wanted, &pos);
+      uint32_t actual_value = present ? this->decode_fixed32_(actual, &actual_pos) : 0;
+      if (value != actual_value)
+        return false;
+    } else if (wire_type == WT_LENGTH) {
+      size_t value_len = this->decode_varint_(wanted, &pos, wanted_len);
+      size_t actual_value_len = present ? this->decode_varint_(actual, &actual_pos, actual_len) : 0;
+      if (pos + value_len > wanted_len || (present && actual_pos + actual_value_len > actual_len))
+        return false;
+      if (field_num == nested_field) {
+        // A sub-message: the radio reports all of its fields, compare only the ones we set
+        if (!this->proto_fields_match_(wanted + pos, value_len, actual + actual_pos, actual_value_len, 0))
+          return false;
+      } else if (value_len != actual_value_len || memcmp(wanted + pos, actual + actual_pos, value_len) != 0) {
+        return false;
+      }
+      pos += value_len;
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+void MeshtasticComponent::compare_config_section_(uint32_t admin_field, const uint8_t *buf, size_t len) {
+  if (admin_field == ADMIN_SET_CHANNEL) {
+    if (!this->has_channel_config_)
+      return;
+    uint32_t wanted_field, section_field;
+    const uint8_t *wanted;
+    size_t wanted_len;
+    if (!this->unwrap_admin_section_(this->channel_admin_msg_, &wanted_field, &section_field, &wanted, &wanted_len))
+      return;
+    // The dump has one frame per channel slot, only the one with our index counts
+    uint8_t wt;
+    size_t index_pos;
+    uint32_t wanted_index = 0, index = 0;
+    if (this->find_field_(wanted, wanted_len, 1, &wt, &index_pos) && wt == WT_VARINT)
+      wanted_index = this->decode_varint_(wanted, &index_pos, wanted_len);
+    if (this->find_field_(buf, len, 1, &wt, &index_pos) && wt == WT_VARINT)
+      index = this->decode_varint_(buf, &index_pos, len);
+    if (index != wanted_index)
+      return;
+    // Channel.settings (field 2) is compared field by field
+    this->channel_differs_ = !this->proto_fields_match_(wanted, wanted_len, buf, len, 2);
+    ESP_LOGD(TAG, "Channel %u %s", index, this->channel_differs_ ? "differs" : "matches");
+    return;
+  }
+
+  // Config and ModuleConfig frames hold one section each, a length-delimited field
+  size_t pos = 0;
+  uint32_t tag = this->decode_varint_(buf, &pos, len);
+  if ((tag & 0x07) != WT_LENGTH)
+    return;
+  uint32_t section = tag >> 3;
+  size_t section_len = this->decode_varint_(buf, &pos, len);
+  if (pos + section_len > len)
+    return;
+
+  for (size_t i = 0; i < this->config_admin_msgs_.size(); i++) {
+    uint32_t wanted_field, section_field;
+    const uint8_t *wanted;
+    size_t wanted_len;
+    if (!this->unwrap_admin_section_(this->config_admin_msgs_[i], &wanted_field, &section_field, &wanted,
+                                     &wanted_len))
+      continue;
+    if (wanted_field != admin_field || section_field != section)
+      continue;
+    this->config_msg_differs_[i] = !this->proto_fields_match_(wanted, wanted_len, buf + pos, section_len, 0);
+    ESP_LOGD(TAG, "%s section %u %s", admin_field == ADMIN_SET_CONFIG ? "Config" : "ModuleConfig", section,
+             this->config_msg_differs_[i] ? "differs" : "matches");
+  }
+}
+
+void MeshtasticComponent::mark_config_differs_() {
+  this->config_msg_differs_.assign(this->config_admin_msgs_.size(), true);
+  this->channel_differs_ = true;
+}
+
+bool MeshtasticComponent::settings_differ_() {
+  // begin_edit / commit_edit are not sections, they only go out when a section does
+  for (size_t i = 0; i < this->config_admin_msgs_.size(); i++) {
+    uint32_t admin_field, section_field;
+    const uint8_t *data;
+    size_t len;
+    if (this->config_msg_differs_[i] &&
+        this->unwrap_admin_section_(this->config_admin_msgs_[i], &admin_field, &section_field, &data, &len))
+      return true;
+  }
+  return false;
+}
+
 // ---- Debug config logging ----
 
 // Field name lookup for human-readable output
@@ -515,13 +830,17 @@ void MeshtasticComponent::dump_radio_config() {
   // Using nonce=0 so config_complete_id won't match and won't trigger state changes.
   ESP_LOGI(TAG, "=== Requesting radio config dump ===");
   this->dump_config_active_ = true;
-  uint8_t buf[10];
-  size_t len = this->encode_field_varint_(buf, 3, 0xDEAD);  // dummy nonce
-  this->send_framed_(buf, len);
+  this->send_to_radio_([](auto &to_radio) { to_radio.write_varint(3, 0xDEAD); });  // dummy nonce
 }
 
 // ---- Internal methods ----
 
+void MeshtasticComponent::log_stats_() {
+  ESP_LOGD(TAG, "Stats: config %ums (%u frames), ACK latency %ums, %u delivered, %u failed, %u frames received",
+           this->stats_.config_ms, this->stats_.config_frames, this->stats_.ack_latency_ms, this->stats_.delivered,
+           this->stats_.failed, this->stats_.frames_received);
+}
+
 void MeshtasticComponent::publish_state_() {
 #ifdef USE_BINARY_SENSOR
   if (this->ready_sensor_)
@@ -557,59 +876,77 @@ void MeshtasticComponent::send_want_config_() {
   // Generate a random nonzero nonce
   this->config_nonce_ = static_cast<uint32_t>(esp_random()) | 1;
   ESP_LOGD(TAG, "Requesting config (nonce=0x%08X)", this->config_nonce_);
+  // Sections count as differing until the dump shows the radio has them
+  this->mark_config_differs_();
+  // A new session, nothing is known about the radio's TX queue until it reports
+  this->radio_queue_free_ = 1;
+  this->radio_queue_unreported_ = 0;
+  this->radio_queue_probe_interval_ = RADIO_QUEUE_PROBE_INTERVAL;
+  this->admin_packet_id_ = 0;
+  this->admin_packet_queued_ = false;
+  this->admin_packet_held_ = false;
+
+  this->config_requested_at_ = millis();
+  this->config_frames_start_ = this->stats_.frames_received;
 
   // ToRadio { want_config_id = nonce }  =>  field 3, varint
-  uint8_t buf[10];
-  size_t len = this->encode_field_varint_(buf, 3, this->config_nonce_);
-  this->send_framed_(buf, len);
+  this->send_to_radio_([this](auto &to_radio) { to_radio.write_varint(3, this->config_nonce_); });
 }
 
 void MeshtasticComponent::process_serial_() {
-  while (this->available()) {
-    uint8_t byte;
-    this->read_byte(&byte);
-
-    switch (this->rx_state_) {
-      case RX_WAIT_START1:
-        if (byte == START1) {
-          this->rx_state_ = RX_WAIT_START2;
-        }
-        break;
+  int available;
+  while ((available = this->available()) > 0) {
+    size_t count = std::min<size_t>(available, sizeof(this->rx_buf_) - this->rx_len_);
+    if (!this->read_array(this->rx_buf_ + this->rx_len_, count))
+      break;
+    this->rx_len_ += count;
+    this->parse_frames_();
+  }
+}
 
-      case RX_WAIT_START2:
-        if (byte == START2) {
-          this->rx_state_ = RX_WAIT_LEN_MSB;
-        } else {
-          this->rx_state_ = RX_WAIT_START1;
-        }
-        break;
+void MeshtasticComponent::parse_frames_() {
+  // rx_start_ is a member so a handler that resets the receive buffer (power_on) ends this loop
+  while (this->rx_start_ < this->rx_len_) {
+    const uint8_t *begin = this->rx_buf_ + this->rx_start_;
+    size_t remaining = this->rx_len_ - this->rx_start_;
 
-      case RX_WAIT_LEN_MSB:
-        this->rx_payload_len_ = static_cast<uint16_t>(byte) << 8;
-        this->rx_state_ = RX_WAIT_LEN_LSB;
-        break;
+    // Skip anything before a start marker, e.g. debug output the radio prints on the same UART
+    auto *marker = static_cast<const uint8_t *>(memchr(begin, START1, remaining));
+    if (marker == nullptr) {
+      this->rx_start_ = this->rx_len_;
+      break;
+    }
+    this->rx_start_ += marker - begin;
+    remaining = this->rx_len_ - this->rx_start_;
+    if (remaining < FRAME_HEADER_SIZE) {
+      // Check what is there already, a lone START1 in text should not hold back the scan
+      if (remaining >= 2 && marker[1] != START2) {
+        this->rx_start_++;
+        continue;
+      }
+      break;
+    }
+    uint16_t payload_len = encode_uint16(marker[2], marker[3]);
+    if (marker[1] != START2 || payload_len == 0 || payload_len > MAX_PAYLOAD) {
+      if (marker[1] == START2 && payload_len > MAX_PAYLOAD)
+        ESP_LOGW(TAG, "Frame too large (%u bytes), discarding", payload_len);
+      // Not a frame header, resynchronise on the next START1
+      this->rx_start_++;
+      continue;
+    }
+    if (remaining < FRAME_HEADER_SIZE + payload_len)
+      break;  // Wait for the rest of the frame
 
-      case RX_WAIT_LEN_LSB:
-        this->rx_payload_len_ |= byte;
-        if (this->rx_payload_len_ > MAX_PAYLOAD || this->rx_payload_len_ == 0) {
-          if (this->rx_payload_len_ > MAX_PAYLOAD) {
-            ESP_LOGW(TAG, "Frame too large (%u bytes), discarding", this->rx_payload_len_);
-          }
-          this->rx_state_ = RX_WAIT_START1;
-        } else {
-          this->rx_pos_ = 0;
-          this->rx_state_ = RX_WAIT_PAYLOAD;
-        }
-        break;
+    this->rx_start_ += FRAME_HEADER_SIZE + payload_len;
+    this->stats_.frames_received++;
+    this->handle_from_radio_(marker + FRAME_HEADER_SIZE, payload_len);
+  }
 
-      case RX_WAIT_PAYLOAD:
-        this->rx_buf_[this->rx_pos_++] = byte;
-        if (this->rx_pos_ >= this->rx_payload_len_) {
-          this->handle_from_radio_(this->rx_buf_, this->rx_payload_len_);
-          this->rx_state_ = RX_WAIT_START1;
-        }
-        break;
-    }
+  // Keep the incomplete frame at the front so a whole frame always fits behind it
+  if (this->rx_start_ > 0) {
+    memmove(this->rx_buf_, this->rx_buf_ + this->rx_start_, this->rx_len_ - this->rx_start_);
+    this->rx_len_ -= this->rx_start_;
+    this->rx_start_ = 0;
   }
 }
 
@@ -678,8 +1015,15 @@ void MeshtasticComponent::handle_from_radio_(const uint8_t *buf, size_t len) {
           uint32_t node_num = 0;
           const uint8_t *user_data = nullptr;
           size_t user_len = 0;
-
-          // Parse NodeInfo: num (field 1, varint), user (field 2, length-delimited)
+          const uint8_t *metrics_data = nullptr;
+          size_t metrics_len = 0;
+          float snr = 0;
+          bool has_snr = false;
+          uint32_t last_heard = 0;
+          uint32_t hops_away = NodeEntry::HOPS_UNKNOWN;
+
+          // Parse NodeInfo: num (1), user (2), snr (4, float), last_heard (5, fixed32), device_metrics (6),
+          // hops_away (9)
           while (pos < end) {
             uint32_t sub_tag = this->decode_varint_(buf, &pos, end);
             uint8_t sub_wt = sub_tag & 0x07;
@@ -690,10 +1034,48 @@ void MeshtasticComponent::handle_from_radio_(const uint8_t *buf, size_t len) {
               user_len = this->decode_varint_(buf, &pos, end);
               user_data = buf + pos;
               pos += user_len;
+            } else if (sub_fn == 4 && sub_wt == WT_32BIT) {
+              uint32_t bits = this->decode_fixed32_(buf, &pos);
+              memcpy(&snr, &bits, sizeof(snr));
+              has_snr = true;
+            } else if (sub_fn == 5 && sub_wt == WT_32BIT) {
+              last_heard = this->decode_fixed32_(buf, &pos);
+            } else if (sub_fn == 6 && sub_wt == WT_LENGTH) {
+              metrics_len = this->decode_varint_(buf, &pos, end);
+              metrics_data = buf + pos;
+              pos += metrics_len;
+            } else if (sub_fn == 9 && sub_wt == WT_VARINT) {
+              hops_away = this->decode_varint_(buf, &pos, end);
             } else {
               this->skip_field_(buf, &pos, end, sub_wt);
             }
           }
+          if (pos > end)
+            break;
+
+          // The radio lists its nodes most recently heard first, they only fill free slots of the table
+          NodeEntry *node = nullptr;
+          if (node_num != 0 && node_num != this->my_node_num_)
+            node = this->nodes_.find_or_append(node_num);
+          // Until a packet carries rx_time, the newest last_heard of the dump is the best guess at the mesh time
+          if (last_heard > this->get_mesh_time()) {
+            this->mesh_time_ = last_heard;
+            this->mesh_time_at_ = millis();
+          }
+          if (node != nullptr) {
+            if (last_heard > node->last_heard) {
+              node->last_heard = last_heard;
+              if (has_snr)
+                node->snr = snr_to_quarter_db(snr);
+              if (hops_away != NodeEntry::HOPS_UNKNOWN)
+                node->hops = std::min<uint32_t>(hops_away, NodeEntry::HOPS_UNKNOWN - 1);
+            }
+            if (user_data != nullptr)
+              this->parse_short_name_(user_data, user_len, node);
+            if (metrics_data != nullptr)
+              this->parse_device_metrics_(metrics_data, metrics_len, node);
+            this->nodes_dirty_ = true;
+          }
 
           // If this is our own node, extract long_name and short_name from User
           if (node_num == this->my_node_num_ && this->my_node_num_ != 0 && user_data != nullptr) {
@@ -728,6 +1110,8 @@ void MeshtasticComponent::handle_from_radio_(const uint8_t *buf, size_t len) {
       case 5: {  // config (Config, length-delimited)
         if (wire_type == WT_LENGTH) {
           uint32_t sub_len = this->decode_varint_(buf, &pos, len);
+          if (pos + sub_len <= len)
+            this->compare_config_section_(ADMIN_SET_CONFIG, buf + pos, sub_len);
           if (this->dump_config_active_) {
             size_t end = pos + sub_len;
             static const char *const CFG_NAMES[] = {
@@ -763,6 +1147,8 @@ void MeshtasticComponent::handle_from_radio_(const uint8_t *buf, size_t len) {
       case 6: {  // module_config (ModuleConfig, length-delimited)
         if (wire_type == WT_LENGTH) {
           uint32_t sub_len = this->decode_varint_(buf, &pos, len);
+          if (pos + sub_len <= len)
+            this->compare_config_section_(ADMIN_SET_MODULE_CONFIG, buf + pos, sub_len);
           if (this->dump_config_active_) {
             size_t end = pos + sub_len;
             static const char *const MOD_NAMES[] = {
@@ -806,13 +1192,25 @@ void MeshtasticComponent::handle_from_radio_(const uint8_t *buf, size_t len) {
             ESP_LOGI(TAG, "=== End radio config dump ===");
           }
           if (complete_id == this->config_nonce_ && this->state_ == State::CONFIGURING) {
+            this->stats_.config_ms = millis() - this->config_requested_at_;
+            this->stats_.config_frames = this->stats_.frames_received - this->config_frames_start_;
+            this->log_stats_();
             // If we have admin config to apply and haven't applied it yet, go to APPLYING_CONFIG
-            if (!this->config_admin_msgs_.empty() && !this->config_applied_ && this->configure_on_boot_) {
+            bool settings_differ = this->settings_differ_();
+            bool channel_differs = this->has_channel_config_ && this->channel_differs_;
+            if (!this->config_admin_msgs_.empty() && !this->config_applied_ && this->configure_on_boot_ &&
+                !settings_differ && !channel_differs) {
+              ESP_LOGI(TAG, "Config complete - radio configuration already matches, device ready");
+              this->config_applied_ = true;
+              this->state_ = State::READY;
+              this->on_ready_callbacks_.call();
+            } else if (!this->config_admin_msgs_.empty() && !this->config_applied_ && this->configure_on_boot_) {
               ESP_LOGI(TAG, "Config complete - applying admin configuration...");
               this->state_ = State::APPLYING_CONFIG;
               this->state_start_ = millis();
               this->config_msg_index_ = 0;
-              this->config_phase_ = 0;
+              // Only the channel differs: no settings batch, go straight to the channel
+              this->config_phase_ = settings_differ ? 0 : 2;
             } else {
               ESP_LOGI(TAG, "Config complete - device ready");
               this->state_ = State::READY;
@@ -823,7 +1221,7 @@ void MeshtasticComponent::handle_from_radio_(const uint8_t *buf, size_t len) {
           else if (complete_id != 0 && this->state_ == State::APPLYING_CONFIG) {
             if (this->config_phase_ == 1) {
               ESP_LOGI(TAG, "Device rebooted and ready after settings commit");
-              if (this->has_channel_config_) {
+              if (this->has_channel_config_ && this->channel_differs_) {
                 this->config_phase_ = 2;
                 this->state_start_ = millis();
               } else {
@@ -855,10 +1253,7 @@ void MeshtasticComponent::handle_from_radio_(const uint8_t *buf, size_t len) {
               // Stay in APPLYING_CONFIG at current phase
               // Re-send wake + want_config to get config_complete_id
               this->send_wake_bytes_();
-              this->config_nonce_ = static_cast<uint32_t>(esp_random()) | 1;
-              uint8_t cfg_buf[10];
-              size_t cfg_len = this->encode_field_varint_(cfg_buf, 3, this->config_nonce_);
-              this->send_framed_(cfg_buf, cfg_len);
+              this->send_want_config_();
             } else {
               ESP_LOGW(TAG, "Device reboot detected, re-initializing");
               this->state_ = State::INITIALIZING;
@@ -873,6 +1268,8 @@ void MeshtasticComponent::handle_from_radio_(const uint8_t *buf, size_t len) {
       case 9: {  // channel (Channel, length-delimited)
         if (wire_type == WT_LENGTH) {
           uint32_t sub_len = this->decode_varint_(buf, &pos, len);
+          if (pos + sub_len <= len)
+            this->compare_config_section_(ADMIN_SET_CHANNEL, buf + pos, sub_len);
           if (this->dump_config_active_) {
             size_t end = pos + sub_len;
             uint32_t ch_index = 0, ch_role = 0;
@@ -915,6 +1312,8 @@ void MeshtasticComponent::handle_from_radio_(const uint8_t *buf, size_t len) {
           uint32_t sub_len = this->decode_varint_(buf, &pos, len);
           size_t end = pos + sub_len;
           int32_t res = 0;
+          uint32_t free = 0;
+          uint32_t maxlen = 0;
           uint32_t mesh_packet_id = 0;
           while (pos < end) {
             uint32_t sub_tag = this->decode_varint_(buf, &pos, end);
@@ -922,19 +1321,36 @@ void MeshtasticComponent::handle_from_radio_(const uint8_t *buf, size_t len) {
             uint32_t sub_fn = sub_tag >> 3;
             if (sub_fn == 1 && sub_wt == WT_VARINT) {
               res = static_cast<int32_t>(this->decode_varint_(buf, &pos, end));
+            } else if (sub_fn == 2 && sub_wt == WT_VARINT) {
+              free = this->decode_varint_(buf, &pos, end);
+            } else if (sub_fn == 3 && sub_wt == WT_VARINT) {
+              maxlen = this->decode_varint_(buf, &pos, end);
             } else if (sub_fn == 4 && sub_wt == WT_VARINT) {
               mesh_packet_id = this->decode_varint_(buf, &pos, end);
             } else {
               this->skip_field_(buf, &pos, end, sub_wt);
             }
           }
-          ESP_LOGD(TAG, "QueueStatus: res=%d packet_id=0x%08X (pending=0x%08X)", res, mesh_packet_id, this->pending_packet_id_);
-          if (mesh_packet_id != 0 && mesh_packet_id == this->pending_packet_id_) {
-            if (res != 0) {
+          ESP_LOGD(TAG, "QueueStatus: res=%d free=%u/%u packet_id=0x%08X (in flight=%u)", res, free, maxlen,
+                   mesh_packet_id, this->in_flight_count_);
+          this->update_radio_queue_(res, free);
+          if (mesh_packet_id != 0 && mesh_packet_id == this->admin_packet_id_) {
+            if (res == 0) {
+              this->admin_packet_queued_ = true;
+            } else if (free == 0) {
+              ESP_LOGD(TAG, "Radio TX queue full, holding admin message 0x%08X", mesh_packet_id);
+              this->admin_packet_held_ = true;
+            } else {
+              ESP_LOGW(TAG, "Admin message not taken (res=%d)", res);
+            }
+          } else if (mesh_packet_id != 0) {
+            if (res != 0 && free == 0) {
+              // Rejected because the TX queue is full, not because of the packet: send it again once there is room
+              ESP_LOGD(TAG, "Radio TX queue full, holding packet 0x%08X", mesh_packet_id);
+              this->requeue_outbound_(mesh_packet_id);
+            } else if (res != 0) {
               ESP_LOGW(TAG, "Message queue failed (res=%d)", res);
-              this->pending_packet_id_ = 0;
-              this->state_ = State::READY;
-              this->on_send_failed_callbacks_.call();
+              this->finish_outbound_(mesh_packet_id, false);
             } else {
               ESP_LOGD(TAG, "Message queued, waiting for routing confirmation...");
             }
@@ -960,6 +1376,13 @@ void MeshtasticComponent::handle_mesh_packet_(const uint8_t *buf, size_t len) {
   uint8_t channel = 0;
   const uint8_t *decoded_data = nullptr;
   size_t decoded_len = 0;
+  uint32_t rx_time = 0;
+  float rx_snr = 0;
+  bool has_snr = false;
+  int32_t rx_rssi = 0;
+  uint32_t hop_limit = 0;
+  uint32_t hop_start = 0;
+  uint32_t packet_id = 0;
 
   // First pass: extract MeshPacket fields
   while (pos < len) {
@@ -1002,11 +1425,91 @@ void MeshtasticComponent::handle_mesh_packet_(const uint8_t *buf, size_t len) {
         }
         break;
 
+      case 6:  // id (fixed32)
+        if (wire_type == WT_32BIT) {
+          packet_id = this->decode_fixed32_(buf, &pos);
+        } else {
+          this->skip_field_(buf, &pos, len, wire_type);
+        }
+        break;
+
+      case 7:  // rx_time (fixed32)
+        if (wire_type == WT_32BIT) {
+          rx_time = this->decode_fixed32_(buf, &pos);
+        } else {
+          this->skip_field_(buf, &pos, len, wire_type);
+        }
+        break;
+
+      case 8:  // rx_snr (float)
+        if (wire_type == WT_32BIT) {
+          uint32_t bits = this->decode_fixed32_(buf, &pos);
+          memcpy(&rx_snr, &bits, sizeof(rx_snr));
+          has_snr = true;
+        } else {
+          this->skip_field_(buf, &pos, len, wire_type);
+        }
+        break;
+
+      case 9:  // hop_limit (varint)
+        if (wire_type == WT_VARINT) {
+          hop_limit = this->decode_varint_(buf, &pos, len);
+        } else {
+          this->skip_field_(buf, &pos, len, wire_type);
+        }
+        break;
+
+      case 12:  // rx_rssi (int32)
+        if (wire_type == WT_VARINT) {
+          rx_rssi = static_cast<int32_t>(this->decode_varint_(buf, &pos, len));
+        } else {
+          this->skip_field_(buf, &pos, len, wire_type);
+        }
+        break;
+
+      case 15:  // hop_start (varint)
+        if (wire_type == WT_VARINT) {
+          hop_start = this->decode_varint_(buf, &pos, len);
+        } else {
+          this->skip_field_(buf, &pos, len, wire_type);
+        }
+        break;
+
       default:
         this->skip_field_(buf, &pos, len, wire_type);
         break;
     }
   }
+  if (pos > len || (decoded_data != nullptr && decoded_data + decoded_len > buf + len))
+    return;
+
+  // The mesh may hand over the same packet more than once, drop the copies before doing any work
+  if (this->recent_packets_.check_and_add(from, packet_id)) {
+    ESP_LOGD(TAG, "Duplicate packet 0x%08X from 0x%08X dropped", packet_id, from);
+    return;
+  }
+
+  if (rx_time != 0) {
+    this->mesh_time_ = rx_time;
+    this->mesh_time_at_ = millis();
+  }
+
+  // Anything received from another node tells us it is alive and how well we hear it
+  NodeEntry *node = nullptr;
+  if (from != 0 && from != this->my_node_num_)
+    node = this->nodes_.touch(from);
+  if (node != nullptr) {
+    uint32_t now = this->get_mesh_time();
+    if (now != 0)
+      node->last_heard = now;
+    if (has_snr)
+      node->snr = snr_to_quarter_db(rx_snr);
+    if (rx_rssi != 0)
+      node->rssi = std::clamp<int32_t>(rx_rssi, INT16_MIN, INT16_MAX);
+    if (hop_start != 0 && hop_start >= hop_limit)
+      node->hops = hop_start - hop_limit;
+    this->nodes_dirty_ = true;
+  }
 
   ESP_LOGD(TAG, "MeshPacket from=0x%08X to=0x%08X ch=%u decoded=%s (len=%u)",
            from, to, channel, decoded_data ? "yes" : "no/encrypted", decoded_len);
@@ -1060,21 +1563,56 @@ void MeshtasticComponent::handle_mesh_packet_(const uint8_t *buf, size_t len) {
     }
   }
 
-  ESP_LOGD(TAG, "  Data: portnum=%u request_id=0x%08X payload_len=%u (pending=0x%08X)",
-           portnum, request_id, payload_len, this->pending_packet_id_);
+  ESP_LOGD(TAG, "  Data: portnum=%u request_id=0x%08X payload_len=%u", portnum, request_id, payload_len);
+
+  MeshMessage message{};
+  message.from = from;
+  message.to = to;
+  message.id = packet_id;
+  message.portnum = portnum;
+  message.channel = channel;
+  message.payload = payload;
+  message.payload_len = payload_len;
+  message.hops = hop_start != 0 && hop_start >= hop_limit ? hop_start - hop_limit : NodeEntry::HOPS_UNKNOWN;
+  message.snr = has_snr ? rx_snr : NAN;
+  message.rssi = std::clamp<int32_t>(rx_rssi, INT16_MIN, INT16_MAX);
 
   // Handle TEXT_MESSAGE_APP
   if (portnum == PORTNUM_TEXT_MESSAGE && payload != nullptr && payload_len > 0) {
-    std::string text(reinterpret_cast<const char *>(payload), payload_len);
-    ESP_LOGI(TAG, "Received text from 0x%08X (ch=%u): %s", from, channel, text.c_str());
-    this->last_from_node_ = from;
-    this->last_channel_ = channel;
-    this->on_message_callbacks_.call(std::move(text));
+    ESP_LOGI(TAG, "Received text from 0x%08X (ch=%u): %.*s", from, channel, static_cast<int>(payload_len), payload);
+    this->deliver_message_(message);
+    return;
+  }
+
+  if (portnum == PORTNUM_PRIVATE && payload != nullptr) {
+    this->handle_fragment_(message);
+    return;
+  }
+
+  if (portnum == PORTNUM_READINGS && payload != nullptr) {
+    this->handle_readings_(message);
+    return;
+  }
+
+  // TELEMETRY_APP: Telemetry { time (1), device_metrics (2) }, keep the battery level of the sender
+  if (portnum == PORTNUM_TELEMETRY && node != nullptr && payload != nullptr) {
+    size_t tpos = 0;
+    while (tpos < payload_len) {
+      uint32_t ttag = this->decode_varint_(payload, &tpos, payload_len);
+      if (ttag >> 3 == 2 && (ttag & 0x07) == WT_LENGTH) {
+        size_t metrics_len = this->decode_varint_(payload, &tpos, payload_len);
+        if (tpos + metrics_len <= payload_len)
+          this->parse_device_metrics_(payload + tpos, metrics_len, node);
+        tpos += metrics_len;
+      } else if (!this->skip_field_(payload, &tpos, payload_len, ttag & 0x07)) {
+        break;
+      }
+    }
     return;
   }
 
   // Handle ROUTING_APP (ACK/NAK)
-  if (portnum == PORTNUM_ROUTING && request_id != 0 && request_id == this->pending_packet_id_) {
+  if (portnum == PORTNUM_ROUTING && request_id != 0) {
     // Parse Routing message to get error_reason
     uint32_t error_reason = 0;
     if (payload != nullptr && payload_len > 0) {
@@ -1091,73 +1629,372 @@ void MeshtasticComponent::handle_mesh_packet_(const uint8_t *buf, size_t len) {
       }
     }
 
-    this->pending_packet_id_ = 0;
-    this->state_ = State::READY;
-
     if (error_reason == ROUTING_ERROR_NONE) {
-      ESP_LOGI(TAG, "ACK received - message delivered successfully");
-      this->on_send_success_callbacks_.call();
+      ESP_LOGD(TAG, "ACK received for packet 0x%08X", request_id);
     } else {
-      ESP_LOGW(TAG, "NAK received (error=%u) - message delivery failed", error_reason);
-      this->on_send_failed_callbacks_.call();
+      ESP_LOGW(TAG, "NAK received for packet 0x%08X (error=%u)", request_id, error_reason);
     }
+    this->finish_outbound_(request_id, error_reason == ROUTING_ERROR_NONE);
   }
 }
 
-void MeshtasticComponent::send_framed_(const uint8_t *data, size_t len) {
-  uint8_t header[4];
-  header[0] = START1;
-  header[1] = START2;
-  header[2] = (len >> 8) & 0xFF;
-  header[3] = len & 0xFF;
-  this->write_array(header, 4);
-  this->write_array(data, len);
-  this->flush();
+void MeshtasticComponent::deliver_message_(const MeshMessage &message) {
+  this->last_from_node_ = message.from;
+  this->last_channel_ = message.channel;
+  this->on_mesh_message_callbacks_.call(message);
+  // Only on_message needs its own copy of the payload
+  if (this->on_message_callbacks_.size() > 0)
+    this->on_message_callbacks_.call(message.payload_str());
 }
 
-uint32_t MeshtasticComponent::generate_packet_id_() {
-  this->packet_id_counter_++;
-  uint32_t random_part = esp_random() & 0x003FFFFF;  // 22 bits random
-  return (random_part << 10) | (this->packet_id_counter_ & 0x3FF);
+void MeshtasticComponent::handle_fragment_(const MeshMessage &packet) {
+  uint32_t from = packet.from;
+  const uint8_t *data = packet.payload;
+  size_t len = packet.payload_len;
+  FragmentHeader header;
+  if (!header.read(data, len)) {
+    ESP_LOGD(TAG, "Ignoring private port packet from 0x%08X, not a fragment", from);
+    return;
+  }
+  std::string payload;
+  uint8_t flags;
+  if (!this->reassembler_.add(from, header, data + FragmentHeader::SIZE, len - FragmentHeader::SIZE, millis(),
+                              &payload, &flags)) {
+    ESP_LOGV(TAG, "Fragment %u/%u of transfer 0x%04X from 0x%08X", header.index + 1, header.count,
+             header.transfer_id, from);
+    return;
+  }
+
+  if (flags & FragmentHeader::FLAG_COMPRESSED) {
+    std::string inflated;
+    if (!lzss_decompress(reinterpret_cast<const uint8_t *>(payload.data()), payload.size(), MAX_TRANSFER_SIZE,
+                         &inflated)) {
+      ESP_LOGW(TAG, "Transfer 0x%04X from 0x%08X does not decompress, dropped", header.transfer_id, from);
+      return;
+    }
+    payload = std::move(inflated);
+  }
+
+  ESP_LOGI(TAG, "Received %u bytes of data from 0x%08X (ch=%u)", payload.size(), from, packet.channel);
+  // Delivered with the metadata of the fragment that completed it
+  MeshMessage message = packet;
+  message.payload = reinterpret_cast<const uint8_t *>(payload.data());
+  message.payload_len = payload.size();
+  this->deliver_message_(message);
 }
 
-// ---- Protobuf encoding ----
+void MeshtasticComponent::handle_readings_(const MeshMessage &packet) {
+  std::vector<Reading> readings;
+  if (!this->readings_decoder_.decode(packet.from, packet.payload, packet.payload_len, &readings)) {
+    ESP_LOGD(TAG, "Readings from 0x%08X not decoded, malformed or a frame was missed", packet.from);
+    return;
+  }
+  ESP_LOGI(TAG, "Received %u readings from 0x%08X (ch=%u)", readings.size(), packet.from, packet.channel);
+  this->last_from_node_ = packet.from;
+  this->last_channel_ = packet.channel;
+  this->on_readings_callbacks_.call(readings);
+}
 
-size_t MeshtasticComponent::encode_varint_(uint8_t *buf, uint32_t value) {
-  size_t i = 0;
-  while (value > 0x7F) {
-    buf[i++] = (value & 0x7F) | 0x80;
-    value >>= 7;
+// ---- Node table ----
+
+int8_t MeshtasticComponent::snr_to_quarter_db(float snr) {
+  return static_cast<int8_t>(std::clamp(snr * 4.0f, float(INT8_MIN + 1), float(INT8_MAX)));
+}
+
+void MeshtasticComponent::parse_short_name_(const uint8_t *user, size_t len, NodeEntry *node) {
+  // User { id (1), long_name (2), short_name (3), ... }
+  size_t pos = 0;
+  while (pos < len) {
+    uint32_t tag = this->decode_varint_(user, &pos, len);
+    if (tag >> 3 == 3 && (tag & 0x07) == WT_LENGTH) {
+      size_t name_len = this->decode_varint_(user, &pos, len);
+      if (pos + name_len > len)
+        return;
+      size_t n = std::min(name_len, sizeof(node->short_name) - 1);
+      memcpy(node->short_name, user + pos, n);
+      node->short_name[n] = '\0';
+      pos += name_len;
+    } else if (!this->skip_field_(user, &pos, len, tag & 0x07)) {
+      return;
+    }
+  }
+}
+
+void MeshtasticComponent::parse_device_metrics_(const uint8_t *metrics, size_t len, NodeEntry *node) {
+  // DeviceMetrics { battery_level (1), voltage (2), ... }
+  size_t pos = 0;
+  while (pos < len) {
+    uint32_t tag = this->decode_varint_(metrics, &pos, len);
+    if (tag >> 3 == 1 && (tag & 0x07) == WT_VARINT) {
+      node->battery = std::min<uint32_t>(this->decode_varint_(metrics, &pos, len), NodeEntry::BATTERY_UNKNOWN - 1);
+    } else if (!this->skip_field_(metrics, &pos, len, tag & 0x07)) {
+      return;
+    }
+  }
+}
+
+uint32_t MeshtasticComponent::get_mesh_time() const {
+  if (this->mesh_time_ == 0)
+    return 0;
+  return this->mesh_time_ + (millis() - this->mesh_time_at_) / 1000;
+}
+
+uint32_t MeshtasticComponent::get_node_age(uint32_t num) const {
+  const NodeEntry *node = this->nodes_.get(num);
+  uint32_t now = this->get_mesh_time();
+  if (node == nullptr || node->last_heard == 0 || now == 0)
+    return UINT32_MAX;
+  return now > node->last_heard ? now - node->last_heard : 0;
+}
+
+void MeshtasticComponent::load_nodes_() {
+  this->nodes_pref_ = global_preferences->make_preference<NodeRestoreState>(fnv1_hash("meshtastic.nodes"));
+  NodeRestoreState state{};
+  if (!this->nodes_pref_.load(&state))
+    return;
+  size_t count = std::min<size_t>(state.count, NODE_RESTORE_COUNT);
+  // Saved most recent first, touch the oldest first so the order comes back the same
+  for (size_t i = count; i-- > 0;) {
+    NodeEntry *node = this->nodes_.touch(state.nodes[i].num);
+    if (node != nullptr)
+      *node = state.nodes[i];
+  }
+  ESP_LOGD(TAG, "Restored %u nodes", this->nodes_.size());
+}
+
+void MeshtasticComponent::save_nodes_() {
+  this->nodes_dirty_ = false;
+  this->nodes_saved_at_ = millis();
+  if (!this->restore_nodes_)
+    return;
+  NodeRestoreState state{};
+  this->nodes_.for_each([&state](const NodeEntry &node) {
+    if (state.count < NODE_RESTORE_COUNT)
+      state.nodes[state.count++] = node;
+  });
+  this->nodes_pref_.save(&state);
+}
+
+// ---- Outbound queue ----
+
+void MeshtasticComponent::process_outbound_(uint32_t now) {
+  // Time out packets whose ACK did not arrive; a retry keeps its place ahead of the messages queued after it
+  for (size_t i = 0; i < this->outbound_.size();) {
+    OutboundPacket &packet = this->outbound_[i];
+    if (!packet.in_flight || now - packet.sent_at <= this->ack_timeout_) {
+      i++;
+      continue;
+    }
+    if (packet.attempts <= this->max_retries_) {
+      ESP_LOGW(TAG, "ACK timeout for packet 0x%08X, retrying (%u/%u)", packet.packet_id, packet.attempts,
+               this->max_retries_);
+      packet.in_flight = false;
+      this->in_flight_count_--;
+      i++;
+    } else {
+      ESP_LOGW(TAG, "ACK timeout for packet 0x%08X", packet.packet_id);
+      // Callbacks may queue or drop messages, start over on the changed queue
+      this->finish_outbound_(packet.packet_id, false);
+      i = 0;
+    }
+  }
+
+  for (OutboundPacket &packet : this->outbound_) {
+    if (this->in_flight_count_ >= this->max_in_flight_ || !this->radio_queue_ready_(now))
+      break;
+    if (!packet.in_flight && this->encode_readings_(packet))
+      this->transmit_(packet);
+  }
+
+  if (this->state_ == State::READY || this->state_ == State::SENDING)
+    this->state_ = this->outbound_.empty() ? State::READY : State::SENDING;
+}
+
+void MeshtasticComponent::transmit_(OutboundPacket &packet) {
+  // Retries keep the id like the firmware's own retransmissions: receivers drop the copy if an earlier attempt got
+  // through after all, and its late ACK still settles the packet
+  if (packet.packet_id == 0)
+    packet.packet_id = this->generate_packet_id_();
+  uint32_t packet_id = packet.packet_id;
+
+  // ToRadio { packet = MeshPacket { to, channel, decoded=Data { portnum, payload }, id, hop_limit=3, want_ack,
+  //                                 priority=RELIABLE } }
+  this->send_to_radio_([&](auto &to_radio) {
+    to_radio.write_message(1, [&](auto &pkt) {
+      pkt.write_fixed32(2, packet.destination);  // to
+      pkt.write_varint(3, packet.channel);       // channel
+      pkt.write_message(4, [&](auto &data) {     // decoded (Data)
+        data.write_varint(1, packet.portnum);
+        data.write_string(2, packet.payload);
+      });
+      pkt.write_fixed32(6, packet_id);  // id
+      pkt.write_varint(9, 3);           // hop_limit
+      pkt.write_varint(10, 1);          // want_ack = true
+      pkt.write_varint(11, 70);         // priority = RELIABLE
+    });
+  });
+
+  if (packet.portnum == PORTNUM_READINGS) {
+    ESP_LOGD(TAG, "Sent readings (id=0x%08X dest=0x%08X ch=%u len=%u attempt=%u)", packet_id, packet.destination,
+             packet.channel, packet.payload.length(), packet.attempts + 1);
+  } else if (packet.transfer_id != 0) {
+    ESP_LOGD(TAG, "Sent fragment %u/%u of transfer 0x%04X (id=0x%08X attempt=%u)", uint8_t(packet.payload[2]) + 1,
+             uint8_t(packet.payload[3]), packet.transfer_id, packet_id, packet.attempts + 1);
+  } else {
+    ESP_LOGI(TAG, "Sent text (id=0x%08X dest=0x%08X ch=%u len=%u attempt=%u): %s", packet_id, packet.destination,
+             packet.channel, packet.payload.length(), packet.attempts + 1, packet.payload.c_str());
+  }
+
+  packet.sent_at = millis();
+  packet.attempts++;
+  packet.in_flight = true;
+  this->in_flight_count_++;
+  this->note_radio_send_(packet.sent_at);
+}
+
+bool MeshtasticComponent::encode_readings_(OutboundPacket &packet) {
+  if (packet.portnum != PORTNUM_READINGS || !packet.payload.empty())
+    return true;  // Not readings, or encoded already and waiting for a retry
+  // The frame is a difference to the one before, which must have settled: held back frames would otherwise be
+  // encoded against values the receiver may never see, or arrive out of order
+  for (const OutboundPacket &other : this->outbound_) {
+    if (&other != &packet && other.portnum == PORTNUM_READINGS && !other.payload.empty())
+      return false;
+  }
+  uint8_t frame[MAX_DATA_PAYLOAD];
+  size_t len = this->readings_encoder_.encode(packet.readings, frame, sizeof(frame));
+  if (len == 0) {
+    this->readings_encoder_.reset();
+    len = this->readings_encoder_.encode(packet.readings, frame, sizeof(frame));
+  }
+  packet.payload.assign(reinterpret_cast<const char *>(frame), len);
+  packet.readings.clear();
+  return true;
+}
+
+void MeshtasticComponent::requeue_outbound_(uint32_t packet_id) {
+  for (OutboundPacket &packet : this->outbound_) {
+    if (packet.in_flight && packet.packet_id == packet_id) {
+      // The radio never queued it, so the attempt does not count against max_retries
+      packet.in_flight = false;
+      packet.attempts--;
+      this->in_flight_count_--;
+      return;
+    }
+  }
+}
+
+bool MeshtasticComponent::radio_queue_ready_(uint32_t now) const {
+  if (this->radio_queue_free_ > this->radio_queue_unreported_)
+    return true;
+  // The radio only reports its queue in reply to a packet, so when it looks full send one to find out
+  return now - this->radio_queue_sent_at_ > this->radio_queue_probe_interval_;
+}
+
+void MeshtasticComponent::note_radio_send_(uint32_t now) {
+  this->radio_queue_sent_at_ = now;
+  if (this->radio_queue_unreported_ < UINT8_MAX)
+    this->radio_queue_unreported_++;
+}
+
+void MeshtasticComponent::update_radio_queue_(int32_t res, uint32_t free) {
+  // Each QueueStatus answers one packet, the ones sent after it are not part of the reported free count
+  if (this->radio_queue_unreported_ > 0)
+    this->radio_queue_unreported_--;
+  this->radio_queue_free_ = std::min<uint32_t>(free, UINT8_MAX);
+  if (free > 0) {
+    this->radio_queue_probe_interval_ = RADIO_QUEUE_PROBE_INTERVAL;
+  } else if (res != 0) {
+    this->radio_queue_probe_interval_ =
+        std::min(this->radio_queue_probe_interval_ * 2, RADIO_QUEUE_MAX_PROBE_INTERVAL);
+  }
+}
+
+void MeshtasticComponent::finish_outbound_(uint32_t packet_id, bool success) {
+  // A packet waiting for its retry still matches, an ACK for the attempt that timed out delivered it all the same
+  auto it = std::find_if(this->outbound_.begin(), this->outbound_.end(), [packet_id](const OutboundPacket &p) {
+    return p.packet_id != 0 && p.packet_id == packet_id;
+  });
+  if (it == this->outbound_.end())
+    return;  // Not ours
+
+  // Take the packet off the queue first, its callbacks may queue new messages
+  SendCallback callback = std::move(it->callback);
+  uint16_t transfer_id = it->transfer_id;
+  uint32_t sent_at = it->sent_at;
+  if (it->in_flight)
+    this->in_flight_count_--;
+  this->outbound_.erase(it);
+  if (this->state_ == State::SENDING && this->outbound_.empty())
+    this->state_ = State::READY;
+
+  if (success) {
+    this->stats_.delivered++;
+    this->stats_.ack_latency_ms = millis() - sent_at;
+  } else {
+    this->stats_.failed++;
+  }
+  this->log_stats_();
+
+  if (transfer_id != 0) {
+    // Fragments report to their transfer, which fires on_send_success / on_send_failed once
+    callback(success);
+  } else if (success) {
+    ESP_LOGI(TAG, "ACK received - message delivered successfully");
+    if (callback)
+      callback(true);
+    this->on_send_success_callbacks_.call();
+  } else {
+    ESP_LOGW(TAG, "Message delivery failed (packet 0x%08X)", packet_id);
+    if (callback)
+      callback(false);
+    this->on_send_failed_callbacks_.call();
   }
-  buf[i++] = value & 0x7F;
-  return i;
 }
 
-size_t MeshtasticComponent::encode_field_varint_(uint8_t *buf, uint32_t field_num, uint32_t value) {
-  size_t len = 0;
-  len += this->encode_varint_(buf + len, (field_num << 3) | WT_VARINT);
-  len += this->encode_varint_(buf + len, value);
-  return len;
+void MeshtasticComponent::cancel_transfer_(uint16_t transfer_id) {
+  // The rest of a failed transfer is of no use to the receiver, do not spend airtime on it
+  for (auto it = this->outbound_.begin(); it != this->outbound_.end();) {
+    if (it->transfer_id != transfer_id) {
+      ++it;
+      continue;
+    }
+    if (it->in_flight)
+      this->in_flight_count_--;
+    it = this->outbound_.erase(it);
+  }
+  if (this->state_ == State::SENDING && this->outbound_.empty())
+    this->state_ = State::READY;
 }
 
-size_t MeshtasticComponent::encode_field_fixed32_(uint8_t *buf, uint32_t field_num, uint32_t value) {
-  size_t len = 0;
-  len += this->encode_varint_(buf + len, (field_num << 3) | WT_32BIT);
-  buf[len++] = value & 0xFF;
-  buf[len++] = (value >> 8) & 0xFF;
-  buf[len++] = (value >> 16) & 0xFF;
-  buf[len++] = (value >> 24) & 0xFF;
-  return len;
+void MeshtasticComponent::drop_outbound_() {
+  if (!this->outbound_.empty())
+    ESP_LOGW(TAG, "Dropping %u queued messages", this->outbound_.size());
+  this->outbound_.clear();
+  this->in_flight_count_ = 0;
+  // A dropped readings frame may have been the one the next delta builds on
+  this->readings_encoder_.reset();
 }
 
-size_t MeshtasticComponent::encode_field_bytes_(uint8_t *buf, uint32_t field_num, const uint8_t *data,
-                                                size_t data_len) {
-  size_t len = 0;
-  len += this->encode_varint_(buf + len, (field_num << 3) | WT_LENGTH);
-  len += this->encode_varint_(buf + len, data_len);
-  memcpy(buf + len, data, data_len);
-  len += data_len;
-  return len;
+void MeshtasticComponent::send_frame_(const ProtoWriter &writer) {
+  if (writer.overflow()) {
+    ESP_LOGW(TAG, "ToRadio message larger than %u bytes, not sent", MAX_PAYLOAD);
+    return;
+  }
+  // The writer encoded the message right behind the header space, the whole frame goes out in one write
+  size_t len = writer.size();
+  this->tx_buf_[0] = START1;
+  this->tx_buf_[1] = START2;
+  this->tx_buf_[2] = (len >> 8) & 0xFF;
+  this->tx_buf_[3] = len & 0xFF;
+  this->write_array(this->tx_buf_, FRAME_HEADER_SIZE + len);
+  this->flush();
+}
+
+uint32_t MeshtasticComponent::generate_packet_id_() {
+  this->packet_id_counter_++;
+  uint32_t random_part = esp_random() & 0x003FFFFF;  // 22 bits random
+  return (random_part << 10) | (this->packet_id_counter_ & 0x3FF);
 }
 
 // ---- Protobuf decoding ----
@@ -1167,12 +2004,14 @@ uint32_t MeshtasticComponent::decode_varint_(const uint8_t *buf, size_t *pos, si
   uint32_t shift = 0;
   while (*pos < len) {
     uint8_t byte = buf[(*pos)++];
-    result |= static_cast<uint32_t>(byte & 0x7F) << shift;
+    // Negative int32 fields are sign extended to 10 bytes, keep the low 32 bits and consume the rest
+    if (shift < 32)
+      result |= static_cast<uint32_t>(byte & 0x7F) << shift;
     if (!(byte & 0x80))
       break;
     shift += 7;
-    if (shift >= 35)
-      break;  // overflow guard
+    if (shift >= 70)
+      break;  // overflow guard, a varint has at most 10 bytes
   }
   return result;
 }
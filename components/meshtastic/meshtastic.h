@@ -3,15 +3,23 @@
 #include "esphome/core/component.h"
 #include "esphome/core/automation.h"
 #include "esphome/core/hal.h"
+#include "esphome/core/preferences.h"
 #include "esphome/components/uart/uart.h"
+#include "fragment.h"
+#include "node_table.h"
+#include "proto_writer.h"
+#include "readings.h"
+#include "recent_packets.h"
 #ifdef USE_BINARY_SENSOR
 #include "esphome/components/binary_sensor/binary_sensor.h"
 #endif
 #ifdef USE_TEXT_SENSOR
 #include "esphome/components/text_sensor/text_sensor.h"
 #endif
+#include <cmath>
 #include <string>
 #include <cstring>
+#include <functional>
 #include <vector>
 
 namespace esphome {
@@ -32,17 +40,90 @@ struct AdminMsg {
   size_t len;
 };
 
+/// Nodes kept across reboots when restore_nodes is enabled, most recently heard first.
+static const uint8_t NODE_RESTORE_COUNT = 16;
+struct NodeRestoreState {
+  uint8_t count;
+  NodeEntry nodes[NODE_RESTORE_COUNT];
+} __attribute__((packed));
+
+/** A text message or reassembled data payload with what is known about the packet that brought it.
+ *
+ * The payload is not copied, it points into the receive buffer and is only valid during the callback.
+ */
+struct MeshMessage {
+  uint32_t from;
+  uint32_t to;
+  uint32_t id;
+  uint32_t portnum;
+  uint8_t channel;
+  const uint8_t *payload;
+  size_t payload_len;
+  /// Hops the packet took, NodeEntry::HOPS_UNKNOWN if unknown.
+  uint8_t hops;
+  /// SNR in dB, NAN if unknown.
+  float snr;
+  /// RSSI in dBm, 0 if unknown.
+  int16_t rssi;
+
+  std::string payload_str() const { return std::string(reinterpret_cast<const char *>(payload), payload_len); }
+};
+
+/// What talking to the radio costs, measured by the host benchmark against a simulated radio and logged on change.
+struct MeshStats {
+  uint32_t config_ms{0};        ///< Time from want_config until config_complete, the radio's whole dump ingested
+  uint32_t config_frames{0};    ///< FromRadio frames in that dump
+  uint32_t frames_received{0};  ///< FromRadio frames since boot
+  uint32_t ack_latency_ms{0};   ///< Time from sending the last delivered packet until its ACK
+  uint32_t delivered{0};        ///< Packets ACKed since boot, fragments counted one by one
+  uint32_t failed{0};           ///< Packets NAKed, timed out or rejected by the radio since boot
+};
+
+/// Called once per queued message: true on ACK, false on NAK, timeout after all retries or a failed enqueue.
+using SendCallback = std::function<void(bool)>;
+
+/// A message waiting in the outbound queue, or sent and waiting for its routing ACK.
+struct OutboundPacket {
+  std::string payload;
+  uint32_t destination;
+  uint32_t portnum;
+  uint8_t channel;
+  uint8_t attempts{0};
+  bool in_flight{false};
+  /// Assigned on the first attempt and kept for the retries.
+  uint32_t packet_id{0};
+  uint32_t sent_at{0};
+  /// Nonzero for a fragment of a payload sent with send_data().
+  uint16_t transfer_id{0};
+  /// Readings queued with send_readings(), encoded into the payload when the packet is first sent.
+  std::vector<Reading> readings;
+  SendCallback callback;
+};
+
 class MeshtasticComponent : public Component, public uart::UARTDevice {
  public:
   void setup() override;
   void loop() override;
   void dump_config() override;
+  void on_safe_shutdown() override;
   float get_setup_priority() const override { return setup_priority::AFTER_WIFI; }
 
   // Configuration setters
   void set_power_pin(GPIOPin *pin) { power_pin_ = pin; }
   void set_boot_timeout(uint32_t ms) { boot_timeout_ = ms; }
   void set_ack_timeout(uint32_t ms) { ack_timeout_ = ms; }
+  void set_max_retries(uint8_t n) { max_retries_ = n; }
+  void set_max_in_flight(uint8_t n) { max_in_flight_ = n; }
+  void set_queue_size(uint8_t n) { queue_size_ = n; }
+  void set_node_table_size(uint8_t n) { node_table_size_ = n; }
+  void set_restore_nodes(bool v) { restore_nodes_ = v; }
+  /** Refuse unicasts to nodes not heard for this long. Once the mesh time is known, nodes never heard at all are
+   * refused too; before that (a radio without a clock that has not reported one yet) nothing is refused.
+   */
+  void set_max_node_age(uint32_t seconds) { max_node_age_ = seconds; }
+  void set_reassembly_slots(uint8_t n) { reassembler_.set_slots(n); }
+  void set_reassembly_timeout(uint32_t ms) { reassembler_.set_timeout(ms); }
+  void set_key_frame_interval(uint8_t frames) { readings_encoder_.set_key_frame_interval(frames); }
   void set_default_destination(uint32_t dest) { default_destination_ = dest; }
   void set_default_channel(uint8_t ch) { default_channel_ = ch; }
   void set_enable_on_boot(bool en) { enable_on_boot_ = en; }
@@ -66,7 +147,31 @@ class MeshtasticComponent : public Component, public uart::UARTDevice {
   // Public API
   void power_on();
   void power_off();
-  bool send_text(const std::string &message, uint32_t destination, uint8_t channel);
+  /** Queue a text message, it is sent as soon as fewer than max_in_flight messages are waiting for their ACK.
+   *
+   * @param callback Optional, told whether this message was delivered
+   * @return false if the radio is not ready, the message is too long or the queue is full
+   */
+  bool send_text(const std::string &message, uint32_t destination, uint8_t channel, SendCallback &&callback = {});
+  /** Queue a payload of up to MAX_TRANSFER_SIZE bytes as fragments on the private port.
+   *
+   * Nodes running this component put the fragments back together and pass the payload to on_message. All fragments
+   * must fit in the queue at once.
+   *
+   * @param compress LZSS compress the payload first, it is sent as is if that does not make it smaller
+   * @param callback Optional, true once every fragment was delivered, false as soon as one failed
+   */
+  bool send_data(const std::string &payload, uint32_t destination, uint8_t channel, bool compress = false,
+                 SendCallback &&callback = {});
+  /** Queue sensor readings as one binary packet on the readings port, received by on_readings.
+   *
+   * Values are sent as differences to the previous batch, so all batches should go to the same destination. A batch
+   * is only encoded and sent once the one before it was ACKed or failed, so frames never overtake each other.
+   *
+   * @return false if the radio is not ready, the readings do not fit in one packet or the queue is full
+   */
+  bool send_readings(const std::vector<Reading> &readings, uint32_t destination, uint8_t channel,
+                     SendCallback &&callback = {});
   bool send_nodeinfo();
   void apply_config();
   void dump_radio_config();
@@ -81,10 +186,30 @@ class MeshtasticComponent : public Component, public uart::UARTDevice {
   uint8_t get_last_channel() const { return last_channel_; }
   uint32_t get_default_destination() const { return default_destination_; }
   uint8_t get_default_channel() const { return default_channel_; }
+  /// Messages queued or waiting for their ACK.
+  size_t get_pending_count() const { return outbound_.size(); }
+  const MeshStats &get_stats() const { return stats_; }
+
+  // Node table
+  const NodeTable &get_nodes() const { return nodes_; }
+  const NodeEntry *get_node(uint32_t num) const { return nodes_.get(num); }
+  /// Current Unix time as reported by the radio with received packets or node last_heard times, 0 until known.
+  uint32_t get_mesh_time() const;
+  /// Seconds since the radio last heard a node, UINT32_MAX if it never did or the time is unknown.
+  uint32_t get_node_age(uint32_t num) const;
 
   // Callback registration
   void add_on_ready_callback(std::function<void()> &&cb) { on_ready_callbacks_.add(std::move(cb)); }
-  void add_on_message_callback(std::function<void(std::string)> &&cb) { on_message_callbacks_.add(std::move(cb)); }
+  void add_on_message_callback(std::function<void(const std::string &)> &&cb) {
+    on_message_callbacks_.add(std::move(cb));
+  }
+  /// Like on_message, with the sender and signal metadata and without copying the payload.
+  void add_on_mesh_message_callback(std::function<void(const MeshMessage &)> &&cb) {
+    on_mesh_message_callbacks_.add(std::move(cb));
+  }
+  void add_on_readings_callback(std::function<void(const std::vector<Reading> &)> &&cb) {
+    on_readings_callbacks_.add(std::move(cb));
+  }
   void add_on_send_success_callback(std::function<void()> &&cb) { on_send_success_callbacks_.add(std::move(cb)); }
   void add_on_send_failed_callback(std::function<void()> &&cb) { on_send_failed_callbacks_.add(std::move(cb)); }
 
@@ -92,25 +217,63 @@ class MeshtasticComponent : public Component, public uart::UARTDevice {
   void send_wake_bytes_();
   void send_want_config_();
   void process_serial_();
+  void parse_frames_();
   void handle_from_radio_(const uint8_t *buf, size_t len);
   void handle_mesh_packet_(const uint8_t *buf, size_t len);
-  void send_framed_(const uint8_t *data, size_t len);
+  /// Encode a ToRadio message directly into the frame buffer and send it as one frame.
+  template<typename F> void send_to_radio_(F &&fields) {
+    ProtoWriter writer(this->tx_buf_ + FRAME_HEADER_SIZE, MAX_PAYLOAD);
+    fields(writer);
+    this->send_frame_(writer);
+  }
+  void send_frame_(const ProtoWriter &writer);
+  void process_outbound_(uint32_t now);
+  void transmit_(OutboundPacket &packet);
+  void finish_outbound_(uint32_t packet_id, bool success);
+  void requeue_outbound_(uint32_t packet_id);
+  bool encode_readings_(OutboundPacket &packet);
+  /// Whether a message may be queued for `destination` right now, logs why not.
+  bool can_send_(uint32_t destination, const char *what);
+  void cancel_transfer_(uint16_t transfer_id);
+  void deliver_message_(const MeshMessage &message);
+  void handle_fragment_(const MeshMessage &packet);
+  void handle_readings_(const MeshMessage &packet);
+  void drop_outbound_();
+
+  // Flow control against the radio's TX queue
+  bool radio_queue_ready_(uint32_t now) const;
+  void note_radio_send_(uint32_t now);
+  void update_radio_queue_(int32_t res, uint32_t free);
+
+  // Node table helpers
+  static int8_t snr_to_quarter_db(float snr);
+  void parse_short_name_(const uint8_t *user, size_t len, NodeEntry *node);
+  void parse_device_metrics_(const uint8_t *metrics, size_t len, NodeEntry *node);
+  void load_nodes_();
+  void save_nodes_();
   uint32_t generate_packet_id_();
   void publish_state_();
+  void log_stats_();
 
   // Admin config helpers
   void send_admin_message_(const uint8_t *admin_payload, size_t admin_len);
+  void transmit_admin_();
   void send_next_config_msg_();
 
+  // Config diff against the radio's want_config dump
+  bool unwrap_admin_section_(const AdminMsg &msg, uint32_t *admin_field, uint32_t *section_field,
+                             const uint8_t **data, size_t *len);
+  bool find_field_(const uint8_t *buf, size_t len, uint32_t field_num, uint8_t *wire_type, size_t *value_pos);
+  /// Whether every field set in `wanted` has the same value in `actual`, recursing into `nested_field`.
+  bool proto_fields_match_(const uint8_t *wanted, size_t wanted_len, const uint8_t *actual, size_t actual_len,
+                           uint32_t nested_field);
+  void compare_config_section_(uint32_t admin_field, const uint8_t *buf, size_t len);
+  void mark_config_differs_();
+  bool settings_differ_();
+
   // Debug config logging
   void log_proto_fields_(const char *label, const uint8_t *buf, size_t len);
 
-  // Protobuf encoding helpers
-  size_t encode_varint_(uint8_t *buf, uint32_t value);
-  size_t encode_field_varint_(uint8_t *buf, uint32_t field_num, uint32_t value);
-  size_t encode_field_fixed32_(uint8_t *buf, uint32_t field_num, uint32_t value);
-  size_t encode_field_bytes_(uint8_t *buf, uint32_t field_num, const uint8_t *data, size_t data_len);
-
   // Protobuf decoding helpers
   uint32_t decode_varint_(const uint8_t *buf, size_t *pos, size_t len);
   uint32_t decode_fixed32_(const uint8_t *buf, size_t *pos);
@@ -119,6 +282,12 @@ class MeshtasticComponent : public Component, public uart::UARTDevice {
   GPIOPin *power_pin_{nullptr};
   uint32_t boot_timeout_{30000};
   uint32_t ack_timeout_{30000};
+  uint8_t max_retries_{0};
+  uint8_t max_in_flight_{4};
+  uint8_t queue_size_{8};
+  uint8_t node_table_size_{32};
+  bool restore_nodes_{false};
+  uint32_t max_node_age_{0};
   uint32_t default_destination_{0xFFFFFFFF};
   uint8_t default_channel_{0};
   bool enable_on_boot_{true};
@@ -131,8 +300,34 @@ class MeshtasticComponent : public Component, public uart::UARTDevice {
   uint32_t my_node_num_{0};
   std::string my_long_name_;
   std::string my_short_name_;
-  uint32_t pending_packet_id_{0};
-  uint32_t pending_destination_{0};
+  // Queued messages in send order, the first max_in_flight_ of them may be in flight
+  std::vector<OutboundPacket> outbound_;
+  uint8_t in_flight_count_{0};
+  uint16_t transfer_id_counter_{0};
+  Reassembler reassembler_;
+  ReadingsEncoder readings_encoder_;
+  ReadingsDecoder readings_decoder_;
+  RecentPackets recent_packets_;
+  // Radio TX queue as of the last QueueStatus; packets sent since then are assumed to take a slot each
+  uint8_t radio_queue_free_{1};
+  uint8_t radio_queue_unreported_{0};
+  uint32_t radio_queue_sent_at_{0};
+  uint32_t radio_queue_probe_interval_{200};
+  // Last admin message sent and whether the radio has reported taking it, or turned it away for lack of room
+  std::string admin_payload_;
+  uint32_t admin_packet_id_{0};
+  bool admin_packet_queued_{false};
+  bool admin_packet_held_{false};
+
+  NodeTable nodes_;
+  // Unix time of the last packet that carried rx_time and the millis() it arrived at
+  uint32_t mesh_time_{0};
+  uint32_t mesh_time_at_{0};
+  ESPPreferenceObject nodes_pref_;
+  bool nodes_dirty_{false};
+  uint32_t nodes_saved_at_{0};
+  // Node changes are written at most this often, global_preferences batches the flash writes anyway
+  static constexpr uint32_t NODE_SAVE_INTERVAL = 300000;
   uint32_t last_from_node_{0};
   uint8_t last_channel_{0};
   uint16_t packet_id_counter_{0};
@@ -143,24 +338,28 @@ class MeshtasticComponent : public Component, public uart::UARTDevice {
   bool has_channel_config_{false};
   size_t config_msg_index_{0};
   bool config_applied_{false};
+  // Per admin message / for the channel: false once the radio reported the same values
+  std::vector<bool> config_msg_differs_;
+  bool channel_differs_{true};
   // Phase: 0 = settings batch, 1 = waiting reboot after commit, 2 = channel
   uint8_t config_phase_{0};
   bool dump_config_active_{false};
 
-  // Serial receive state machine
+  // Serial framing: 0x94 0xC3, 16 bit big endian length, protobuf payload
   static const uint16_t MAX_PAYLOAD = 512;
-  uint8_t rx_buf_[MAX_PAYLOAD];
-  size_t rx_pos_{0};
-  enum RxState : uint8_t {
-    RX_WAIT_START1,
-    RX_WAIT_START2,
-    RX_WAIT_LEN_MSB,
-    RX_WAIT_LEN_LSB,
-    RX_WAIT_PAYLOAD,
-  } rx_state_{RX_WAIT_START1};
-  uint16_t rx_payload_len_{0};
+  static const uint8_t FRAME_HEADER_SIZE = 4;
+  uint8_t tx_buf_[FRAME_HEADER_SIZE + MAX_PAYLOAD];
+
+  // Serial receive buffer, bytes [rx_start_, rx_len_) are not parsed yet. Room for two frames lets one complete
+  // frame follow a partial one without wrapping, so frames are always decoded in place.
+  uint8_t rx_buf_[2 * (FRAME_HEADER_SIZE + MAX_PAYLOAD)];
+  size_t rx_start_{0};
+  size_t rx_len_{0};
 
   State last_published_state_{State::OFF};
+  MeshStats stats_;
+  uint32_t config_requested_at_{0};
+  uint32_t config_frames_start_{0};
 
 #ifdef USE_BINARY_SENSOR
   binary_sensor::BinarySensor *ready_sensor_{nullptr};
@@ -170,7 +369,9 @@ class MeshtasticComponent : public Component, public uart::UARTDevice {
 #endif
 
   CallbackManager<void()> on_ready_callbacks_;
-  CallbackManager<void(std::string)> on_message_callbacks_;
+  CallbackManager<void(const std::string &)> on_message_callbacks_;
+  CallbackManager<void(const MeshMessage &)> on_mesh_message_callbacks_;
+  CallbackManager<void(const std::vector<Reading> &)> on_readings_callbacks_;
   CallbackManager<void()> on_send_success_callbacks_;
   CallbackManager<void()> on_send_failed_callbacks_;
 };
@@ -191,6 +392,13 @@ class MessageTrigger : public Trigger<std::string> {
   }
 };
 
+class ReadingsTrigger : public Trigger<std::vector<Reading>> {
+ public:
+  explicit ReadingsTrigger(MeshtasticComponent *parent) {
+    parent->add_on_readings_callback([this](const std::vector<Reading> &readings) { this->trigger(readings); });
+  }
+};
+
 class SendSuccessTrigger : public Trigger<> {
  public:
   explicit SendSuccessTrigger(MeshtasticComponent *parent) {
@@ -226,6 +434,64 @@ template<typename... Ts> class SendTextAction : public Action<Ts...> {
   MeshtasticComponent *parent_;
 };
 
+template<typename... Ts> class SendDataAction : public Action<Ts...> {
+ public:
+  explicit SendDataAction(MeshtasticComponent *parent) : parent_(parent) {}
+
+  TEMPLATABLE_VALUE(std::string, message)
+  TEMPLATABLE_VALUE(uint32_t, destination)
+  TEMPLATABLE_VALUE(uint8_t, channel)
+  TEMPLATABLE_VALUE(bool, compress)
+
+  void play(Ts... x) override {
+    auto payload = this->message_.value(x...);
+    uint32_t dest = this->destination_.has_value() ? this->destination_.value(x...) : parent_->get_default_destination();
+    uint8_t ch = this->channel_.has_value() ? this->channel_.value(x...) : parent_->get_default_channel();
+    parent_->send_data(payload, dest, ch, this->compress_.value(x...));
+  }
+
+ protected:
+  MeshtasticComponent *parent_;
+};
+
+template<typename... Ts> class SendReadingsAction : public Action<Ts...> {
+ public:
+  explicit SendReadingsAction(MeshtasticComponent *parent) : parent_(parent) {}
+
+  TEMPLATABLE_VALUE(uint32_t, destination)
+  TEMPLATABLE_VALUE(uint8_t, channel)
+
+  void add_reading(uint16_t id, uint8_t decimals, TemplatableValue<float, Ts...> state) {
+    this->readings_.push_back({id, decimals, state});
+  }
+
+  void play(Ts... x) override {
+    std::vector<Reading> readings;
+    readings.reserve(this->readings_.size());
+    for (auto &reading : this->readings_) {
+      float state = reading.state.value(x...);
+      // Sensors without a state yet are left out, the receiver keeps their last value
+      if (!std::isnan(state))
+        readings.push_back(Reading::from_state(reading.id, reading.decimals, state));
+    }
+    if (readings.empty())
+      return;
+    uint32_t dest = this->destination_.has_value() ? this->destination_.value(x...) : parent_->get_default_destination();
+    uint8_t ch = this->channel_.has_value() ? this->channel_.value(x...) : parent_->get_default_channel();
+    parent_->send_readings(readings, dest, ch);
+  }
+
+ protected:
+  struct ReadingSource {
+    uint16_t id;
+    uint8_t decimals;
+    TemplatableValue<float, Ts...> state;
+  };
+
+  MeshtasticComponent *parent_;
+  std::vector<ReadingSource> readings_;
+};
+
 template<typename... Ts> class PowerOnAction : public Action<Ts...> {
  public:
   explicit PowerOnAction(MeshtasticComponent *parent) : parent_(parent) {}
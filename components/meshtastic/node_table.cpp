@@ -0,0 +1,154 @@
+#include "node_table.h"
+
+#include <climits>
+#include <cstring>
+
+namespace esphome {
+namespace meshtastic {
+
+void NodeTable::set_capacity(size_t capacity) {
+  if (capacity > MAX_CAPACITY)
+    capacity = MAX_CAPACITY;
+  size_t slots = 1;
+  uint8_t shift = 32;
+  while (slots < capacity * 2) {
+    slots <<= 1;
+    shift--;
+  }
+  this->entries_.assign(capacity, NodeEntry{});
+  this->prev_.assign(capacity, NONE);
+  this->next_.assign(capacity, NONE);
+  this->slots_.assign(capacity == 0 ? 0 : slots, NONE);
+  this->slot_shift_ = shift;
+  this->head_ = NONE;
+  this->tail_ = NONE;
+  this->count_ = 0;
+}
+
+size_t NodeTable::slot_of_(uint32_t num) const {
+  // Node numbers are derived from MAC addresses and may differ only in a few bits anywhere. The top bits of a
+  // multiplicative hash depend on all bits of the number, the low ones only on its low bits
+  return uint32_t(num * 2654435761u) >> this->slot_shift_;
+}
+
+uint8_t NodeTable::find_(uint32_t num) const {
+  if (this->slots_.empty())
+    return NONE;
+  for (size_t slot = this->slot_of_(num);; slot = (slot + 1) & (this->slots_.size() - 1)) {
+    uint8_t index = this->slots_[slot];
+    if (index == NONE || this->entries_[index].num == num)
+      return index;
+  }
+}
+
+const NodeEntry *NodeTable::get(uint32_t num) const {
+  uint8_t index = this->find_(num);
+  return index == NONE ? nullptr : &this->entries_[index];
+}
+
+NodeEntry *NodeTable::touch(uint32_t num) {
+  if (this->entries_.empty())
+    return nullptr;
+
+  uint8_t index = this->find_(num);
+  if (index != NONE) {
+    this->unlink_(index);
+    this->push_front_(index);
+    return &this->entries_[index];
+  }
+
+  if (this->count_ < this->entries_.size()) {
+    index = this->count_++;
+  } else {
+    // Full: reuse the least recently heard entry
+    index = this->tail_;
+    this->remove_from_index_(this->entries_[index].num);
+    this->unlink_(index);
+  }
+  NodeEntry *entry = this->insert_(index, num);
+  this->push_front_(index);
+  return entry;
+}
+
+NodeEntry *NodeTable::find_or_append(uint32_t num) {
+  uint8_t index = this->find_(num);
+  if (index != NONE)
+    return &this->entries_[index];
+  if (this->count_ >= this->entries_.size())
+    return nullptr;
+
+  index = this->count_++;
+  NodeEntry *entry = this->insert_(index, num);
+  // Append at the back of the use order
+  this->prev_[index] = this->tail_;
+  this->next_[index] = NONE;
+  if (this->tail_ != NONE)
+    this->next_[this->tail_] = index;
+  this->tail_ = index;
+  if (this->head_ == NONE)
+    this->head_ = index;
+  return entry;
+}
+
+NodeEntry *NodeTable::insert_(uint8_t index, uint32_t num) {
+  NodeEntry &entry = this->entries_[index];
+  memset(&entry, 0, sizeof(entry));
+  entry.num = num;
+  entry.snr = INT8_MIN;
+  entry.hops = NodeEntry::HOPS_UNKNOWN;
+  entry.battery = NodeEntry::BATTERY_UNKNOWN;
+
+  size_t slot = this->slot_of_(num);
+  while (this->slots_[slot] != NONE)
+    slot = (slot + 1) & (this->slots_.size() - 1);
+  this->slots_[slot] = index;
+  return &entry;
+}
+
+void NodeTable::remove_from_index_(uint32_t num) {
+  size_t mask = this->slots_.size() - 1;
+  size_t slot = this->slot_of_(num);
+  while (this->entries_[this->slots_[slot]].num != num)
+    slot = (slot + 1) & mask;
+
+  // Backward shift deletion: move later entries of the probe run into the hole so lookups never stop early
+  size_t hole = slot;
+  for (size_t next = (hole + 1) & mask; this->slots_[next] != NONE; next = (next + 1) & mask) {
+    size_t home = this->slot_of_(this->entries_[this->slots_[next]].num);
+    // The entry may move into the hole unless its home lies cyclically in (hole, next]
+    bool stays = hole <= next ? (home > hole && home <= next) : (home > hole || home <= next);
+    if (!stays) {
+      this->slots_[hole] = this->slots_[next];
+      hole = next;
+    }
+  }
+  this->slots_[hole] = NONE;
+}
+
+void NodeTable::unlink_(uint8_t index) {
+  uint8_t prev = this->prev_[index];
+  uint8_t next = this->next_[index];
+  if (prev != NONE)
+    this->next_[prev] = next;
+  else
+    this->head_ = next;
+  if (next != NONE)
+    this->prev_[next] = prev;
+  else
+    this->tail_ = prev;
+  this->prev_[index] = NONE;
+  this->next_[index] = NONE;
+}
+
+void NodeTable::push_front_(uint8_t index) {
+  this->prev_[index] = NONE;
+  this->next_[index] = this->head_;
+  if (this->head_ != NONE)
+    this->prev_[this->head_] = index;
+  this->head_ = index;
+  if (this->tail_ == NONE)
+    this->tail_ = index;
+}
+
+}  // namespace meshtastic
+}  // namespace esphome
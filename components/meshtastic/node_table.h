@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace esphome {
+namespace meshtastic {
+
+/// What is known about a node of the mesh, kept small so a few dozen fit in RAM and a part of them in flash.
+struct NodeEntry {
+  uint32_t num;
+  /// Unix time the radio last heard the node, 0 if unknown.
+  uint32_t last_heard;
+  char short_name[5];
+  /// SNR of the last packet in quarter dB, INT8_MIN if unknown.
+  int8_t snr;
+  /// RSSI of the last packet in dBm, 0 if unknown.
+  int16_t rssi;
+  /// Hops the last packet took, HOPS_UNKNOWN if unknown.
+  uint8_t hops;
+  /// Battery level in percent, 101 when externally powered, BATTERY_UNKNOWN if unknown.
+  uint8_t battery;
+
+  static constexpr uint8_t HOPS_UNKNOWN = 0xFF;
+  static constexpr uint8_t BATTERY_UNKNOWN = 0xFF;
+
+  bool has_snr() const { return this->snr != INT8_MIN; }
+  float get_snr() const { return this->snr / 4.0f; }
+} __attribute__((packed));
+
+/** Fixed capacity table of mesh nodes with O(1) lookup by node number.
+ *
+ * Entries sit in one array. An open addressing hash index with linear probing maps node numbers to them and a doubly
+ * linked list threaded through the array keeps them in use order, so a lookup, an update and the eviction of the
+ * least recently heard node when the table is full take constant time.
+ */
+class NodeTable {
+ public:
+  static constexpr size_t MAX_CAPACITY = 254;
+
+  /// Clears the table.
+  void set_capacity(size_t capacity);
+  size_t get_capacity() const { return this->entries_.size(); }
+  size_t size() const { return this->count_; }
+
+  /// The entry of a node, or nullptr. Does not change the use order.
+  const NodeEntry *get(uint32_t num) const;
+  /// The entry of a node, created if needed (evicting the least recently heard one) and moved to the front.
+  NodeEntry *touch(uint32_t num);
+  /** The entry of a node without changing the use order, a new one is added at the back.
+   *
+   * For nodes learned second hand, like the radio's node list, which must not push out nodes heard directly.
+   * @return nullptr if the node is new and the table is full
+   */
+  NodeEntry *find_or_append(uint32_t num);
+
+  /// Calls `fn(const NodeEntry &)` for every node, most recently heard first.
+  template<typename F> void for_each(F &&fn) const {
+    for (uint8_t i = this->head_; i != NONE; i = this->next_[i])
+      fn(this->entries_[i]);
+  }
+
+ protected:
+  static constexpr uint8_t NONE = 0xFF;
+
+  size_t slot_of_(uint32_t num) const;
+  uint8_t find_(uint32_t num) const;
+  void unlink_(uint8_t index);
+  void push_front_(uint8_t index);
+  void remove_from_index_(uint32_t num);
+  NodeEntry *insert_(uint8_t index, uint32_t num);
+
+  std::vector<NodeEntry> entries_;
+  // Use order, NONE terminated
+  std::vector<uint8_t> prev_;
+  std::vector<uint8_t> next_;
+  uint8_t head_{NONE};
+  uint8_t tail_{NONE};
+  // Hash slots holding entry indices, NONE when empty; at least twice the capacity and a power of two
+  std::vector<uint8_t> slots_;
+  // 32 - log2 of the slot count, the hash keeps its high bits
+  uint8_t slot_shift_{32};
+  size_t count_{0};
+};
+
+}  // namespace meshtastic
+}  // namespace esphome
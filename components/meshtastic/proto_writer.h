@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace esphome {
+namespace meshtastic {
+
+// Protobuf wire types
+static const uint8_t WT_VARINT = 0;
+static const uint8_t WT_64BIT = 1;
+static const uint8_t WT_LENGTH = 2;
+static const uint8_t WT_32BIT = 5;
+
+/// Number of bytes the varint encoding of a value takes.
+inline size_t varint_size(uint32_t value) {
+  size_t n = 1;
+  while (value > 0x7F) {
+    value >>= 7;
+    n++;
+  }
+  return n;
+}
+
+/** Field encoding shared by ProtoSizer and ProtoWriter.
+ *
+ * Nested messages are written by a callable that takes the encoder, `[&](auto &w) { w.write_varint(1, x); }`. The
+ * writer runs it once on a ProtoSizer to learn the length prefix and once more to write the fields in place, so a
+ * ToRadio with its MeshPacket and Data is encoded front to back into one buffer without copying sub-messages.
+ */
+template<typename Derived> class ProtoEncoder {
+ public:
+  void write_varint(uint32_t field_num, uint32_t value) {
+    this->write_tag_(field_num, WT_VARINT);
+    this->write_raw_varint_(value);
+  }
+
+  void write_fixed32(uint32_t field_num, uint32_t value) {
+    this->write_tag_(field_num, WT_32BIT);
+    uint8_t bytes[4] = {uint8_t(value), uint8_t(value >> 8), uint8_t(value >> 16), uint8_t(value >> 24)};
+    this->derived_().put_(bytes, 4);
+  }
+
+  void write_bytes(uint32_t field_num, const uint8_t *data, size_t len) {
+    this->write_tag_(field_num, WT_LENGTH);
+    this->write_raw_varint_(len);
+    this->derived_().put_(data, len);
+  }
+
+  void write_string(uint32_t field_num, const std::string &value) {
+    this->write_bytes(field_num, reinterpret_cast<const uint8_t *>(value.data()), value.size());
+  }
+
+ protected:
+  Derived &derived_() { return *static_cast<Derived *>(this); }
+
+  void write_tag_(uint32_t field_num, uint8_t wire_type) { this->write_raw_varint_((field_num << 3) | wire_type); }
+
+  void write_raw_varint_(uint32_t value) {
+    uint8_t bytes[5];
+    size_t n = 0;
+    while (value > 0x7F) {
+      bytes[n++] = (value & 0x7F) | 0x80;
+      value >>= 7;
+    }
+    bytes[n++] = value;
+    this->derived_().put_(bytes, n);
+  }
+};
+
+/// Counts the encoded size of a message without writing it.
+class ProtoSizer : public ProtoEncoder<ProtoSizer> {
+ public:
+  template<typename F> void write_message(uint32_t field_num, F &&fields) {
+    ProtoSizer inner;
+    fields(inner);
+    this->size_ += varint_size(field_num << 3) + varint_size(inner.size_) + inner.size_;
+  }
+
+  size_t size() const { return this->size_; }
+
+ protected:
+  friend class ProtoEncoder<ProtoSizer>;
+  void put_(const uint8_t * /*data*/, size_t len) { this->size_ += len; }
+
+  size_t size_{0};
+};
+
+/// Encodes fields into a caller supplied buffer, anything past its capacity marks the writer as overflowed.
+class ProtoWriter : public ProtoEncoder<ProtoWriter> {
+ public:
+  ProtoWriter(uint8_t *buf, size_t capacity) : buf_(buf), capacity_(capacity) {}
+
+  template<typename F> void write_message(uint32_t field_num, F &&fields) {
+    ProtoSizer sizer;
+    fields(sizer);
+    this->write_tag_(field_num, WT_LENGTH);
+    this->write_raw_varint_(sizer.size());
+    fields(*this);
+  }
+
+  const uint8_t *data() const { return this->buf_; }
+  size_t size() const { return this->pos_; }
+  bool overflow() const { return this->overflow_; }
+
+ protected:
+  friend class ProtoEncoder<ProtoWriter>;
+  void put_(const uint8_t *data, size_t len) {
+    if (this->pos_ + len > this->capacity_) {
+      this->overflow_ = true;
+      return;
+    }
+    memcpy(this->buf_ + this->pos_, data, len);
+    this->pos_ += len;
+  }
+
+  uint8_t *buf_;
+  size_t capacity_;
+  size_t pos_{0};
+  bool overflow_{false};
+};
+
+}  // namespace meshtastic
+}  // namespace esphome
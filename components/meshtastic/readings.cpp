@@ -0,0 +1,151 @@
+#include "readings.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace esphome {
+namespace meshtastic {
+
+static const float POWERS_OF_TEN[Reading::MAX_DECIMALS + 1] = {1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f};
+
+Reading Reading::from_state(uint16_t id, uint8_t decimals, float state) {
+  decimals = std::min(decimals, MAX_DECIMALS);
+  double scaled = std::round(double(state) * POWERS_OF_TEN[decimals]);
+  scaled = std::max<double>(std::min<double>(scaled, INT32_MAX), INT32_MIN);
+  return Reading{id, decimals, static_cast<int32_t>(scaled)};
+}
+
+float Reading::get_state() const { return this->value / POWERS_OF_TEN[std::min(this->decimals, MAX_DECIMALS)]; }
+
+static size_t put_varint(uint8_t *buf, size_t pos, size_t capacity, uint32_t value) {
+  do {
+    if (pos >= capacity)
+      return capacity + 1;
+    uint8_t b = value & 0x7F;
+    value >>= 7;
+    buf[pos++] = value ? b | 0x80 : b;
+  } while (value);
+  return pos;
+}
+
+static bool get_varint(const uint8_t *buf, size_t *pos, size_t len, uint32_t *value) {
+  *value = 0;
+  for (int shift = 0; shift < 35; shift += 7) {
+    if (*pos >= len)
+      return false;
+    uint8_t b = buf[(*pos)++];
+    *value |= uint32_t(b & 0x7F) << shift;
+    if (!(b & 0x80))
+      return true;
+  }
+  return false;
+}
+
+// Zigzag maps small negative and positive numbers alike to small varints; differences wrap around like uint32_t
+static uint32_t zigzag(int32_t v) { return (uint32_t(v) << 1) ^ uint32_t(v >> 31); }
+static int32_t unzigzag(uint32_t v) { return int32_t(v >> 1) ^ -int32_t(v & 1); }
+
+static void store(std::vector<std::pair<uint16_t, int32_t>> *values, uint16_t id, int32_t value) {
+  for (auto &entry : *values) {
+    if (entry.first == id) {
+      entry.second = value;
+      return;
+    }
+  }
+  values->emplace_back(id, value);
+}
+
+int32_t ReadingsEncoder::last_value_(uint16_t id) const {
+  for (const auto &entry : this->last_) {
+    if (entry.first == id)
+      return entry.second;
+  }
+  return 0;
+}
+
+size_t ReadingsEncoder::encode(const std::vector<Reading> &readings, uint8_t *buf, size_t capacity) {
+  if (capacity < HEADER_SIZE)
+    return 0;
+  bool key = this->frames_since_key_ >= this->key_frame_interval_ - 1;
+  uint8_t sequence = this->sequence_ + 1;
+  buf[0] = VERSION | (key ? 0 : FLAG_DELTA);
+  buf[1] = sequence;
+
+  size_t pos = HEADER_SIZE;
+  for (const Reading &reading : readings) {
+    int32_t value = key ? reading.value : int32_t(uint32_t(reading.value) - uint32_t(this->last_value_(reading.id)));
+    pos = put_varint(buf, pos, capacity, (uint32_t(reading.id) << 3) | std::min(reading.decimals, Reading::MAX_DECIMALS));
+    pos = put_varint(buf, pos, capacity, zigzag(value));
+    if (pos > capacity)
+      return 0;
+  }
+
+  // The receiver starts over from a key frame, so the values to diff against do too
+  if (key)
+    this->last_.clear();
+  for (const Reading &reading : readings)
+    store(&this->last_, reading.id, reading.value);
+  this->sequence_ = sequence;
+  this->frames_since_key_ = key ? 0 : this->frames_since_key_ + 1;
+  return pos;
+}
+
+bool ReadingsDecoder::decode(uint32_t from, const uint8_t *data, size_t len, std::vector<Reading> *out) {
+  if (len < ReadingsEncoder::HEADER_SIZE || (data[0] & ReadingsEncoder::VERSION_MASK) != ReadingsEncoder::VERSION)
+    return false;
+  bool delta = data[0] & ReadingsEncoder::FLAG_DELTA;
+  uint8_t sequence = data[1];
+
+  Sender *sender = this->find_sender_(from);
+  if (delta && (sender == nullptr || uint8_t(sender->sequence + 1) != sequence))
+    return false;
+
+  out->clear();
+  size_t pos = ReadingsEncoder::HEADER_SIZE;
+  while (pos < len) {
+    uint32_t key;
+    uint32_t raw;
+    if (!get_varint(data, &pos, len, &key) || !get_varint(data, &pos, len, &raw) || (key >> 3) > UINT16_MAX)
+      return false;
+    Reading reading{static_cast<uint16_t>(key >> 3), static_cast<uint8_t>(key & 0x07), unzigzag(raw)};
+    if (delta) {
+      for (const auto &entry : sender->values) {
+        if (entry.first == reading.id) {
+          reading.value = int32_t(uint32_t(entry.second) + uint32_t(reading.value));
+          break;
+        }
+      }
+    }
+    out->push_back(reading);
+  }
+
+  // Only a frame that decoded completely moves the sender on
+  if (sender == nullptr) {
+    if (this->senders_.size() < MAX_SENDERS) {
+      this->senders_.emplace_back();
+      sender = &this->senders_.back();
+    } else {
+      sender = &*std::min_element(this->senders_.begin(), this->senders_.end(),
+                                  [](const Sender &a, const Sender &b) { return a.used < b.used; });
+    }
+    sender->from = from;
+  }
+  if (!delta)
+    sender->values.clear();
+  for (const Reading &reading : *out)
+    store(&sender->values, reading.id, reading.value);
+  sender->sequence = sequence;
+  sender->used = ++this->use_counter_;
+  return true;
+}
+
+ReadingsDecoder::Sender *ReadingsDecoder::find_sender_(uint32_t from) {
+  for (Sender &sender : this->senders_) {
+    if (sender.from == from)
+      return &sender;
+  }
+  return nullptr;
+}
+
+}  // namespace meshtastic
+}  // namespace esphome
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace esphome {
+namespace meshtastic {
+
+/// One sensor value sent as a scaled integer: the state is `value / 10^decimals`.
+struct Reading {
+  uint16_t id;
+  uint8_t decimals;
+  int32_t value;
+
+  static constexpr uint8_t MAX_DECIMALS = 7;
+
+  /// Rounds `state` to `decimals` places (at most MAX_DECIMALS).
+  static Reading from_state(uint16_t id, uint8_t decimals, float state);
+  float get_state() const;
+};
+
+/** Encodes batches of readings into frames that fit one packet.
+ *
+ * A frame is a flags byte, a sequence number and one entry per reading: a varint of `id << 3 | decimals` followed by
+ * the zigzag varint value. In a key frame the values are absolute. Other frames carry the difference to the last
+ * value sent for the same id (0 if none), which takes a byte for most sensors, so a receiver must have decoded the
+ * frame right before. A key frame is sent every key_frame_interval frames and after a failed send.
+ */
+class ReadingsEncoder {
+ public:
+  static constexpr uint8_t VERSION = 0x20;
+  static constexpr uint8_t VERSION_MASK = 0xF0;
+  static constexpr uint8_t FLAG_DELTA = 0x01;
+  static constexpr size_t HEADER_SIZE = 2;
+
+  void set_key_frame_interval(uint8_t frames) { this->key_frame_interval_ = frames; }
+  uint8_t get_key_frame_interval() const { return this->key_frame_interval_; }
+  /// Encodes the next frame, returns its size or 0 (changing nothing) if it does not fit in `capacity`.
+  size_t encode(const std::vector<Reading> &readings, uint8_t *buf, size_t capacity);
+  /// Makes the next frame a key frame, for when a frame may not have arrived.
+  void reset() { this->frames_since_key_ = UINT8_MAX; }
+
+ protected:
+  int32_t last_value_(uint16_t id) const;
+
+  // Last value sent per id
+  std::vector<std::pair<uint16_t, int32_t>> last_;
+  uint8_t sequence_{0};
+  uint8_t frames_since_key_{UINT8_MAX};
+  uint8_t key_frame_interval_{10};
+};
+
+/// Decodes frames from a bounded number of senders, keeping the values each one sent last.
+class ReadingsDecoder {
+ public:
+  static constexpr size_t MAX_SENDERS = 8;
+
+  /** Decodes one frame into `out`.
+   *
+   * @return false if the frame is malformed, or a delta frame from a sender whose previous frame was missed; its
+   *         frames are then ignored until the next key frame
+   */
+  bool decode(uint32_t from, const uint8_t *data, size_t len, std::vector<Reading> *out);
+
+ protected:
+  struct Sender {
+    uint32_t from;
+    uint8_t sequence;
+    uint32_t used;
+    std::vector<std::pair<uint16_t, int32_t>> values;
+  };
+
+  Sender *find_sender_(uint32_t from);
+
+  std::vector<Sender> senders_;
+  uint32_t use_counter_{0};
+};
+
+}  // namespace meshtastic
+}  // namespace esphome
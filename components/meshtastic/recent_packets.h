@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace esphome {
+namespace meshtastic {
+
+/** The last packets received, by sender and packet id, so copies the mesh delivers again can be dropped.
+ *
+ * A small ring searched linearly: a few dozen entries cover the packets still bouncing around the mesh and fit in a
+ * couple of cache lines, a hash would not pay off.
+ */
+class RecentPackets {
+ public:
+  static constexpr size_t SIZE = 32;
+
+  /// Whether the packet was seen before, it is remembered if not. Packet id 0 is never considered a duplicate.
+  bool check_and_add(uint32_t from, uint32_t id) {
+    if (id == 0)
+      return false;
+    for (const Entry &entry : this->entries_) {
+      if (entry.id == id && entry.from == from)
+        return true;
+    }
+    this->entries_[this->next_] = {from, id};
+    this->next_ = (this->next_ + 1) % SIZE;
+    return false;
+  }
+
+ protected:
+  struct Entry {
+    uint32_t from;
+    uint32_t id;
+  };
+
+  Entry entries_[SIZE]{};
+  size_t next_{0};
+};
+
+}  // namespace meshtastic
+}  // namespace esphome
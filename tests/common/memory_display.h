@@ -0,0 +1,47 @@
+#pragma once
+
+#include <vector>
+
+#include "esphome/components/display/display_buffer.h"
+
+namespace esphome {
+namespace testing {
+
+/// A DisplayBuffer with one byte per pixel in memory, drawn through the generic virtual per-pixel path.
+class MemoryDisplay : public display::DisplayBuffer {
+ public:
+  MemoryDisplay(int width, int height) : width_(width), height_(height) {
+    this->init_internal_(width * height);
+    memset(this->buffer_, 0, width * height);
+  }
+  ~MemoryDisplay() override { free(this->buffer_); }
+
+  void update() override { this->do_update_(); }
+  display::DisplayType get_display_type() override { return display::DisplayType::DISPLAY_TYPE_GRAYSCALE; }
+
+  /// The pixel at native coordinates, the low byte of the color it was drawn with.
+  uint8_t get_native_pixel(int x, int y) const { return this->buffer_[y * this->width_ + x]; }
+  /// Native pixels that are not 0.
+  int count_set_pixels() const {
+    int count = 0;
+    for (int i = 0; i < this->width_ * this->height_; i++)
+      count += this->buffer_[i] != 0;
+    return count;
+  }
+  void clear_buffer() { memset(this->buffer_, 0, this->width_ * this->height_); }
+
+ protected:
+  void draw_absolute_pixel_internal(int x, int y, Color color) override {
+    if (x < 0 || y < 0 || x >= this->width_ || y >= this->height_)
+      return;
+    this->buffer_[y * this->width_ + x] = color.raw_32 & 0xFF;
+  }
+  int get_width_internal() override { return this->width_; }
+  int get_height_internal() override { return this->height_; }
+
+  int width_;
+  int height_;
+};
+
+}  // namespace testing
+}  // namespace esphome
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+
+namespace esphome {
+namespace testing {
+
+/// Checks that failed in this test binary.
+inline int &failures() {
+  static int count = 0;
+  return count;
+}
+
+/// Print the result of the test binary and return its exit code.
+inline int report(const char *name) {
+  if (failures() == 0) {
+    printf("%s: passed\n", name);
+    return 0;
+  }
+  printf("%s: %d checks failed\n", name, failures());
+  return 1;
+}
+
+/// Wall clock time of the host, for the benchmarks. The millis() of the stubs only moves when a test moves it.
+class Stopwatch {
+ public:
+  Stopwatch() : start_(std::chrono::steady_clock::now()) {}
+
+  double elapsed_us() const {
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - this->start_).count();
+  }
+
+ protected:
+  std::chrono::steady_clock::time_point start_;
+};
+
+}  // namespace testing
+}  // namespace esphome
+
+#define CHECK(condition) \
+  do { \
+    if (!(condition)) { \
+      printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+      ::esphome::testing::failures()++; \
+    } \
+  } while (0)
@@ -0,0 +1,115 @@
+// Checks the per-pixel path of DisplayBuffer (clipping, rotation, watchdog) and measures how many pixels a second
+// draw_pixel_at() writes, through the generic virtual path and through the inlined path of the IT8951E driver.
+
+#include "esphome/components/it8951e/it8951e.h"
+#include "esphome/core/application.h"
+#include "memory_display.h"
+#include "test_helpers.h"
+
+using namespace esphome;
+using display::DisplayRotation;
+
+static const DisplayRotation ROTATIONS[] = {display::DISPLAY_ROTATION_0_DEGREES, display::DISPLAY_ROTATION_90_DEGREES,
+                                            display::DISPLAY_ROTATION_180_DEGREES,
+                                            display::DISPLAY_ROTATION_270_DEGREES};
+
+static void check_transform() {
+  testing::MemoryDisplay memory(40, 30);
+  for (DisplayRotation rotation : ROTATIONS) {
+    memory.set_rotation(rotation);
+    for (int y = 0; y < memory.get_height(); y++) {
+      for (int x = 0; x < memory.get_width(); x++) {
+        memory.clear_buffer();
+        memory.draw_pixel_at(x, y, Color(1, 1, 1, 1));
+        int nx = x, ny = y;
+        switch (rotation) {
+          case display::DISPLAY_ROTATION_90_DEGREES:
+            nx = 40 - y - 1;
+            ny = x;
+            break;
+          case display::DISPLAY_ROTATION_180_DEGREES:
+            nx = 40 - x - 1;
+            ny = 30 - y - 1;
+            break;
+          case display::DISPLAY_ROTATION_270_DEGREES:
+            nx = y;
+            ny = 30 - x - 1;
+            break;
+          default:
+            break;
+        }
+        CHECK(memory.count_set_pixels() == 1 && memory.get_native_pixel(nx, ny) == 1);
+      }
+    }
+    // Nothing outside of the screen lands in the buffer
+    memory.clear_buffer();
+    for (int i = -5; i < 50; i++) {
+      memory.draw_pixel_at(i, -1, Color(1, 1, 1, 1));
+      memory.draw_pixel_at(-1, i, Color(1, 1, 1, 1));
+      memory.draw_pixel_at(i, memory.get_height(), Color(1, 1, 1, 1));
+      memory.draw_pixel_at(memory.get_width(), i, Color(1, 1, 1, 1));
+    }
+    CHECK(memory.count_set_pixels() == 0);
+  }
+
+  // Only the top of the clipping stack counts
+  memory.set_rotation(display::DISPLAY_ROTATION_0_DEGREES);
+  memory.clear_buffer();
+  memory.start_clipping(10, 5, 20, 15);
+  for (int y = 0; y < 30; y++) {
+    for (int x = 0; x < 40; x++)
+      memory.draw_pixel_at(x, y, Color(1, 1, 1, 1));
+  }
+  memory.end_clipping();
+  CHECK(memory.count_set_pixels() == 10 * 10);
+  CHECK(memory.get_native_pixel(10, 5) == 1 && memory.get_native_pixel(19, 14) == 1);
+  CHECK(memory.get_native_pixel(9, 5) == 0 && memory.get_native_pixel(20, 14) == 0);
+}
+
+/// Pixels per second of draw_pixel_at() over the whole screen, several times
+static double fill_rate(display::Display &display, int passes) {
+  const int width = display.get_width();
+  const int height = display.get_height();
+  testing::Stopwatch stopwatch;
+  for (int pass = 0; pass < passes; pass++) {
+    Color color(pass & 0x0F, pass & 0x0F, pass & 0x0F, pass & 0x0F);
+    for (int y = 0; y < height; y++) {
+      for (int x = 0; x < width; x++)
+        display.draw_pixel_at(x, y, color);
+    }
+  }
+  return double(width) * height * passes / stopwatch.elapsed_us();
+}
+
+int main() {
+  check_transform();
+
+  // The watchdog is fed every 16384 pixels, not for every pixel
+  testing::MemoryDisplay memory(960, 540);
+  uint32_t feeds = App.get_wdt_feeds();
+  fill_rate(memory, 1);
+  feeds = App.get_wdt_feeds() - feeds;
+  printf("watchdog fed %u times for %d pixels\n", feeds, 960 * 540);
+  CHECK(feeds <= 960 * 540 / 16384 + 1);
+
+  it8951e::IT8951ESensor panel;
+  GPIOPin pin;
+  panel.set_busy_pin(&pin);
+  panel.set_reset_pin(&pin);
+  panel.setup();
+
+  for (DisplayRotation rotation : ROTATIONS) {
+    memory.set_rotation(rotation);
+    panel.set_rotation(rotation);
+    printf("rotation %3d: virtual path %6.1f Mpixel/s, it8951e %6.1f Mpixel/s\n", int(rotation),
+           fill_rate(memory, 10), fill_rate(panel, 10));
+  }
+  memory.set_rotation(display::DISPLAY_ROTATION_0_DEGREES);
+  panel.set_rotation(display::DISPLAY_ROTATION_0_DEGREES);
+  memory.start_clipping(100, 100, 860, 440);
+  panel.start_clipping(100, 100, 860, 440);
+  printf("clipped:      virtual path %6.1f Mpixel/s, it8951e %6.1f Mpixel/s\n", fill_rate(memory, 10),
+         fill_rate(panel, 10));
+
+  return testing::report("display_pixel_benchmark");
+}
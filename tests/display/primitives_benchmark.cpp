@@ -0,0 +1,63 @@
+// Times the filled primitives on the IT8951E frame buffer, which fills row spans a word at a time.
+
+#include <random>
+
+#include "esphome/components/it8951e/it8951e.h"
+#include "test_helpers.h"
+
+using namespace esphome;
+
+static constexpr int WIDTH = 960;
+static constexpr int HEIGHT = 540;
+
+/// Call draw(i) count times and print the time per call and the pixel rate
+template<typename F> static void time_primitive(display::Display &display, const char *name, int count, F &&draw) {
+  uint32_t pixels = display.get_stats().pixels;
+  testing::Stopwatch stopwatch;
+  for (int i = 0; i < count; i++)
+    draw(i);
+  double us = stopwatch.elapsed_us();
+  pixels = display.get_stats().pixels - pixels;
+  printf("%-24s %8.2f us per call, %7.1f Mpixel/s\n", name, us / count, pixels / us);
+  CHECK(pixels > 0);
+}
+
+int main() {
+  it8951e::IT8951ESensor panel;
+  GPIOPin pin;
+  panel.set_busy_pin(&pin);
+  panel.set_reset_pin(&pin);
+  panel.setup();
+
+  std::mt19937 rng(1);
+  std::uniform_int_distribution<int> x(0, WIDTH - 1);
+  std::uniform_int_distribution<int> y(0, HEIGHT - 1);
+  std::vector<int> points(6 * 4096);
+  for (size_t i = 0; i < points.size(); i += 2) {
+    points[i] = x(rng);
+    points[i + 1] = y(rng);
+  }
+  auto p = [&points](int i, int k) { return points[(6 * i + k) % points.size()]; };
+  auto color = [](int i) { return Color(i & 0x0F, i & 0x0F, i & 0x0F, i & 0x0F); };
+
+  time_primitive(panel, "line", 20000, [&](int i) { panel.line(p(i, 0), p(i, 1), p(i, 2), p(i, 3), color(i)); });
+  time_primitive(panel, "triangle", 20000,
+                 [&](int i) { panel.triangle(p(i, 0), p(i, 1), p(i, 2), p(i, 3), p(i, 4), p(i, 5), color(i)); });
+  time_primitive(panel, "filled_triangle", 5000, [&](int i) {
+    panel.filled_triangle(p(i, 0), p(i, 1), p(i, 2), p(i, 3), p(i, 4), p(i, 5), color(i));
+  });
+  time_primitive(panel, "circle r=100", 20000,
+                 [&](int i) { panel.circle(p(i, 0), p(i, 1), 100, color(i)); });
+  time_primitive(panel, "filled_circle r=100", 5000,
+                 [&](int i) { panel.filled_circle(p(i, 0), p(i, 1), 100, color(i)); });
+  time_primitive(panel, "filled_ring r=60..100", 5000,
+                 [&](int i) { panel.filled_ring(p(i, 0), p(i, 1), 60, 100, color(i)); });
+  time_primitive(panel, "filled_gauge r=60..100", 5000,
+                 [&](int i) { panel.filled_gauge(p(i, 0), p(i, 1), 60, 100, i % 101, color(i)); });
+  time_primitive(panel, "filled hexagon r=100", 5000,
+                 [&](int i) { panel.filled_regular_polygon(p(i, 0), p(i, 1), 100, 6, color(i)); });
+  time_primitive(panel, "filled_rectangle 200x100", 5000,
+                 [&](int i) { panel.filled_rectangle(p(i, 0), p(i, 1), 200, 100, color(i)); });
+
+  return testing::report("display_primitives_benchmark");
+}
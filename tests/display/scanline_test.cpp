@@ -0,0 +1,142 @@
+// Filled shapes against their outlines, the scanline edges against line(), and the fixed point trigonometry.
+
+#include <cmath>
+#include <random>
+
+#include "esphome/components/display/scanline.h"
+#include "memory_display.h"
+#include "test_helpers.h"
+
+using namespace esphome;
+using display::ScanEdge;
+
+static constexpr int SIZE = 200;
+
+/// Whether every pixel set in outline is also set in filled
+static bool covers(const testing::MemoryDisplay &filled, const testing::MemoryDisplay &outline) {
+  for (int y = 0; y < SIZE; y++) {
+    for (int x = 0; x < SIZE; x++) {
+      if (outline.get_native_pixel(x, y) != 0 && filled.get_native_pixel(x, y) == 0)
+        return false;
+    }
+  }
+  return true;
+}
+
+/// An edge alone covers on every row exactly the pixels line() draws there
+static void check_edges(std::mt19937 &rng) {
+  std::uniform_int_distribution<int> coordinate(-60, 60);
+  testing::MemoryDisplay line(SIZE, SIZE);
+  int mismatches = 0;
+  for (int i = 0; i < 20000; i++) {
+    int x1 = coordinate(rng), y1 = coordinate(rng), x2 = coordinate(rng), y2 = coordinate(rng);
+    line.clear_buffer();
+    line.line(x1 + 100, y1 + 100, x2 + 100, y2 + 100, Color(1, 1, 1, 1));
+    ScanEdge edge(x1, y1, x2, y2);
+    bool same = true;
+    for (int y = edge.top(); y <= edge.bottom(); y++) {
+      int x_min = INT32_MAX, x_max = INT32_MIN;
+      edge.step(x_min, x_max);
+      for (int x = -60; x <= 60; x++) {
+        bool on_line = line.get_native_pixel(x + 100, y + 100) != 0;
+        if (on_line != (x >= x_min && x <= x_max))
+          same = false;
+      }
+    }
+    mismatches += !same;
+  }
+  printf("edges that differ from line(): %d of 20000\n", mismatches);
+  CHECK(mismatches == 0);
+}
+
+static void check_triangles(std::mt19937 &rng) {
+  // Partly off the screen too, clipping must not open gaps
+  std::uniform_int_distribution<int> coordinate(-20, SIZE + 20);
+  testing::MemoryDisplay outline(SIZE, SIZE);
+  testing::MemoryDisplay filled(SIZE, SIZE);
+  int misses = 0;
+  for (int i = 0; i < 20000; i++) {
+    int p[6];
+    for (int &v : p)
+      v = coordinate(rng);
+    if (i % 4 == 0) {
+      // Small ones, where a single pixel is a large part of the shape
+      p[2] = p[0] + p[2] % 5;
+      p[3] = p[1] + p[3] % 5;
+      p[4] = p[0] + p[4] % 5;
+      p[5] = p[1] + p[5] % 5;
+    }
+    outline.clear_buffer();
+    filled.clear_buffer();
+    outline.triangle(p[0], p[1], p[2], p[3], p[4], p[5], Color(1, 1, 1, 1));
+    filled.filled_triangle(p[0], p[1], p[2], p[3], p[4], p[5], Color(1, 1, 1, 1));
+    misses += !covers(filled, outline);
+  }
+  printf("triangles whose filling misses outline pixels: %d of 20000\n", misses);
+  CHECK(misses == 0);
+
+  // Degenerate triangles are a line or a single pixel, and do not hang
+  filled.clear_buffer();
+  filled.filled_triangle(50, 50, 50, 50, 50, 50, Color(1, 1, 1, 1));
+  CHECK(filled.count_set_pixels() == 1);
+  filled.clear_buffer();
+  filled.filled_triangle(10, 10, 30, 20, 50, 30, Color(1, 1, 1, 1));
+  testing::MemoryDisplay line(SIZE, SIZE);
+  line.line(10, 10, 50, 30, Color(1, 1, 1, 1));
+  CHECK(covers(filled, line) && filled.count_set_pixels() <= line.count_set_pixels() + 2);
+}
+
+static void check_polygons_and_circles() {
+  testing::MemoryDisplay outline(SIZE, SIZE);
+  testing::MemoryDisplay filled(SIZE, SIZE);
+  int polygon_misses = 0;
+  for (int edges = 3; edges <= 12; edges++) {
+    for (int radius = 1; radius < 90; radius += 7) {
+      for (int rotation = 0; rotation < 360; rotation += 17) {
+        outline.clear_buffer();
+        filled.clear_buffer();
+        outline.regular_polygon(100, 100, radius, edges, display::VARIATION_POINTY_TOP, rotation, Color(1, 1, 1, 1),
+                                display::DRAWING_OUTLINE);
+        filled.regular_polygon(100, 100, radius, edges, display::VARIATION_POINTY_TOP, rotation, Color(1, 1, 1, 1),
+                               display::DRAWING_FILLED);
+        polygon_misses += !covers(filled, outline);
+      }
+    }
+  }
+  printf("regular polygons whose filling misses outline pixels: %d\n", polygon_misses);
+  CHECK(polygon_misses == 0);
+
+  int circle_misses = 0;
+  for (int radius = 0; radius < 95; radius++) {
+    outline.clear_buffer();
+    filled.clear_buffer();
+    outline.circle(100, 100, radius, Color(1, 1, 1, 1));
+    filled.filled_circle(100, 100, radius, Color(1, 1, 1, 1));
+    circle_misses += !covers(filled, outline);
+  }
+  printf("circles whose filling misses outline pixels: %d\n", circle_misses);
+  CHECK(circle_misses == 0);
+}
+
+static void check_trigonometry() {
+  double max_error = 0;
+  for (int32_t angle = -720 * display::FIXED_ANGLE_SCALE; angle <= 720 * display::FIXED_ANGLE_SCALE; angle++) {
+    double radians = angle * M_PI / (180.0 * display::FIXED_ANGLE_SCALE);
+    double scale = 1 << display::FIXED_TRIG_SHIFT;
+    max_error = std::max(max_error, std::fabs(display::sin_fixed(angle) / scale - std::sin(radians)));
+    max_error = std::max(max_error, std::fabs(display::cos_fixed(angle) / scale - std::cos(radians)));
+  }
+  printf("largest error of sin_fixed() and cos_fixed(): %.6f\n", max_error);
+  // Interpolating between whole degrees is off by at most (1 degree)^2 / 8 = 3.8e-5, rounding the table and the
+  // result adds up to 1 / 16384 = 6.1e-5
+  CHECK(max_error < 1e-4);
+}
+
+int main() {
+  std::mt19937 rng(1);
+  check_edges(rng);
+  check_triangles(rng);
+  check_polygons_and_circles();
+  check_trigonometry();
+  return testing::report("display_scanline_test");
+}
@@ -0,0 +1,108 @@
+// The text run cache: strings are kept from their second sighting on, values that keep changing are drawn directly
+// and leave the labels alone, strings with too many spans are never kept, and all spans stay within MAX_SPANS.
+
+#include <cstring>
+#include <string>
+
+#include "esphome/components/display/text_cache.h"
+#include "memory_display.h"
+#include "test_helpers.h"
+
+using namespace esphome;
+using display::TextRun;
+using display::TextRunCache;
+
+/// Glyphs of 8x12 pixels in a diagonal pattern, one span per pixel; counts the strings it rendered
+class PatternFont : public display::BaseFont {
+ public:
+  void print(int x, int y, display::Display *display, Color color, const char *text, Color background) override {
+    this->prints++;
+    for (int i = 0; text[i] != '\0'; i++) {
+      for (int row = 0; row < 12; row++) {
+        for (int col = 0; col < 8; col++) {
+          if ((col + row + text[i]) % 3 == 0)
+            display->draw_pixel_at(x + i * 8 + col, y + row, color);
+        }
+      }
+    }
+  }
+  void measure(const char *str, int *width, int *x_offset, int *baseline, int *height) override {
+    *width = 8 * strlen(str);
+    *x_offset = 0;
+    *baseline = 10;
+    *height = 12;
+  }
+
+  int prints{0};
+};
+
+class InspectableCache : public TextRunCache {
+ public:
+  size_t get_span_count() const { return this->span_count_; }
+  size_t get_size() const { return this->runs_.size(); }
+};
+
+int main() {
+  testing::MemoryDisplay target(200, 100);
+  PatternFont font;
+  Color white(0xFF, 0xFF, 0xFF, 0xFF);
+
+  // Drawn directly when first seen, recorded the second time, a hit from then on
+  InspectableCache cache;
+  cache.set_capacity(4);
+  CHECK(cache.get(&target, &font, white, Color(), "Label") == nullptr && font.prints == 0);
+  const TextRun *label = cache.get(&target, &font, white, Color(), "Label");
+  CHECK(label != nullptr && font.prints == 1 && label->width == 40 && label->spans.size() == 5 * 32);
+  CHECK(cache.get(&target, &font, white, Color(), "Label") == label && font.prints == 1);
+  CHECK(cache.get(&target, &font, Color(1, 1, 1, 1), Color(), "Label") == nullptr);  // Another color
+
+  // Values that change on every update never get recorded and leave the labels alone
+  for (const char *text : {"Temp", "Humidity", "Wind"}) {
+    cache.get(&target, &font, white, Color(), text);
+    cache.get(&target, &font, white, Color(), text);
+  }
+  CHECK(cache.get_size() == 4);
+  int prints = font.prints;
+  for (int i = 0; i < 100; i++) {
+    CHECK(cache.get(&target, &font, white, Color(), std::to_string(i).c_str()) == nullptr);
+    CHECK(cache.get(&target, &font, white, Color(), "Label") == label);
+  }
+  CHECK(font.prints == prints && cache.get_size() == 4);
+
+  // A string with more than MAX_RUN_SPANS spans is recorded once, found too big and drawn directly from then on
+  std::string banner(TextRunCache::MAX_RUN_SPANS / 32 + 1, 'x');
+  CHECK(cache.get(&target, &font, white, Color(), banner.c_str()) == nullptr);
+  CHECK(cache.get(&target, &font, white, Color(), banner.c_str()) == nullptr);
+  CHECK(font.prints == prints + 1);
+  CHECK(cache.get(&target, &font, white, Color(), banner.c_str()) == nullptr && font.prints == prints + 1);
+  CHECK(cache.get(&target, &font, white, Color(), "Label") == label);
+
+  // Many long labels: the least recently used ones go to keep the spans within MAX_SPANS
+  InspectableCache big;
+  big.set_capacity(1000);
+  CHECK(big.get_capacity() == TextRunCache::MAX_CAPACITY);
+  for (int i = 0; i < 40; i++) {
+    std::string text = "Label number " + std::to_string(i);
+    big.get(&target, &font, white, Color(), text.c_str());
+    CHECK(big.get(&target, &font, white, Color(), text.c_str()) != nullptr);
+    CHECK(big.get_span_count() <= TextRunCache::MAX_SPANS);
+  }
+  CHECK(big.get_size() < 40);
+
+  // Drawn through the cache, the text looks the same as drawn by the font
+  testing::MemoryDisplay direct(200, 100);
+  testing::MemoryDisplay cached(200, 100);
+  cached.set_text_cache_size(4);
+  for (int i = 0; i < 3; i++) {
+    direct.print(13, 27, &font, white, display::TextAlign::TOP_LEFT, "Cached", Color());
+    cached.print(13, 27, &font, white, display::TextAlign::TOP_LEFT, "Cached", Color());
+    bool same = true;
+    for (int y = 0; y < 100; y++) {
+      for (int x = 0; x < 200; x++)
+        same = same && direct.get_native_pixel(x, y) == cached.get_native_pixel(x, y);
+    }
+    CHECK(same && cached.count_set_pixels() > 0);
+  }
+
+  return testing::report("display_text_cache_test");
+}
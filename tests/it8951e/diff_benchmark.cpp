@@ -0,0 +1,133 @@
+// Times update() of the IT8951E driver on synthetic frames. With the page drawn, update() diffs the dirty regions
+// against the frame on the panel and starts the refresh, the upload itself runs from loop() and is not timed.
+
+#include "esphome/components/it8951e/it8951e.h"
+#include "esphome/components/sensor/sensor.h"
+#include "test_helpers.h"
+
+using namespace esphome;
+
+static constexpr int WIDTH = 960;
+static constexpr int HEIGHT = 540;
+static constexpr int FRAMES = 50;
+
+// A busy page: gray stripes, a grid of boxes and a column of "text" runs all over the panel
+static void draw_page(display::Display &it) {
+  for (int y = 0; y < HEIGHT; y += 24)
+    it.horizontal_line(0, y, WIDTH, Color(8, 8, 8, 8));
+  for (int y = 12; y < HEIGHT - 40; y += 60) {
+    for (int x = 20; x < WIDTH - 80; x += 120)
+      it.rectangle(x, y, 80, 40, Color(0, 0, 0, 0));
+  }
+  for (int y = 4; y < HEIGHT; y += 24) {
+    for (int x = 8; x < WIDTH - 8; x += 7)
+      it.vertical_line(x, y, 12 - (x % 5), Color(3, 3, 3, 3));
+  }
+}
+
+class Bench {
+ public:
+  Bench() {
+    this->panel_.set_busy_pin(&this->pin_);
+    this->panel_.set_reset_pin(&this->pin_);
+    this->panel_.setup();
+    this->panel_.set_bytes_sent_sensor(&this->bytes_sent_);
+    this->panel_.set_skipped_frames_sensor(&this->skipped_);
+    this->panel_.add_on_refresh_complete_callback([this]() { this->done_ = true; });
+  }
+
+  /// Time update() for every frame the writer draws, waiting for each refresh to finish in between
+  void run(const char *name, display::display_writer_t &&writer, uint32_t *bytes, uint32_t *skipped) {
+    this->panel_.set_writer(std::move(writer));
+    this->update_();  // settle on the first frame of the scenario
+    float skipped_before = this->skipped_.state;
+    uint64_t bytes_sent = 0;
+    double total_us = 0;
+    for (int frame = 0; frame < FRAMES; frame++) {
+      this->update_();
+      total_us += this->last_update_us_;
+      bytes_sent += this->bytes_sent_.state;
+    }
+    *bytes = bytes_sent / FRAMES;
+    *skipped = this->skipped_.state - skipped_before;
+    printf("%-28s %8.1f us per update, %7u bytes sent per frame, %2u/%d frames skipped\n", name,
+           total_us / FRAMES, *bytes, *skipped, FRAMES);
+  }
+
+ protected:
+  void update_() {
+    this->done_ = false;
+    float skipped_before = this->skipped_.state;
+    testing::Stopwatch stopwatch;
+    this->panel_.update();
+    this->last_update_us_ = stopwatch.elapsed_us();
+    if (this->skipped_.state != skipped_before)
+      return;
+    for (int i = 0; i < 100000 && !this->done_; i++) {
+      testing::advance_millis(1);
+      this->panel_.loop();
+    }
+    CHECK(this->done_);
+  }
+
+  it8951e::IT8951ESensor panel_;
+  GPIOPin pin_;
+  sensor::Sensor bytes_sent_;
+  sensor::Sensor skipped_;
+  bool done_{false};
+  double last_update_us_{0};
+};
+
+int main() {
+  Bench bench;
+  uint32_t bytes, skipped;
+
+  // Cleared and drawn again unchanged: the whole page is dirty, the diff finds nothing to send
+  bench.run("unchanged page", draw_page, &bytes, &skipped);
+  CHECK(bytes == 0);
+  CHECK(skipped == FRAMES);
+
+  // A few scattered pixels change on an otherwise unchanged page
+  int frame = 0;
+  bench.run(
+      "8 scattered pixels changed",
+      [&frame](display::Display &it) {
+        draw_page(it);
+        frame++;
+        for (int i = 0; i < 8; i++)
+          it.draw_pixel_at((frame * 97 + i * 131) % WIDTH, (frame * 53 + i * 67) % HEIGHT, Color(6, 6, 6, 6));
+      },
+      &bytes, &skipped);
+  CHECK(skipped == 0);
+  // Small blocks around the pixels set now and the ones set the frame before, not whole rows
+  CHECK(bytes > 0 && bytes <= 512);
+
+  // A counter ticking in one corner
+  bench.run(
+      "counter in a corner",
+      [&frame](display::Display &it) {
+        draw_page(it);
+        frame++;
+        for (int digit = 0; digit < 4; digit++) {
+          if ((frame >> digit) & 1)
+            it.filled_rectangle(WIDTH - 100 + digit * 20, HEIGHT - 30, 14, 20, Color(0, 0, 0, 0));
+        }
+      },
+      &bytes, &skipped);
+  CHECK(skipped == 0);
+  CHECK(bytes > 0 && bytes <= 100 * 32 / 2);
+
+  // Every pixel changes, the diff has to give up on nothing
+  bench.run(
+      "whole page inverted",
+      [&frame](display::Display &it) {
+        frame++;
+        it.fill((frame & 1) ? Color(15, 15, 15, 15) : Color(0, 0, 0, 0));
+        it.filled_rectangle(0, 0, 4, 4, Color(7, 7, 7, 7));
+      },
+      &bytes, &skipped);
+  CHECK(skipped == 0);
+  CHECK(bytes == WIDTH * HEIGHT / 2 || bytes == WIDTH * HEIGHT / 8);
+
+  return testing::report("it8951e_diff_benchmark");
+}
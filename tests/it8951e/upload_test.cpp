@@ -0,0 +1,92 @@
+// Counts what the pixel uploads of the IT8951E driver cost on the SPI bus. Image data goes out in bursts behind a
+// single preamble, a frame must not cost a chip select cycle per 16-bit word.
+
+#include "esphome/components/it8951e/it8951e.h"
+#include "esphome/components/sensor/sensor.h"
+#include "test_helpers.h"
+
+using namespace esphome;
+using esphome::spi::bus_counters;
+
+static constexpr int WIDTH = 960;
+static constexpr int HEIGHT = 540;
+static constexpr uint32_t FRAME_BYTES = WIDTH * HEIGHT / 2;
+
+struct Upload {
+  uint32_t transactions;
+  uint64_t bytes;
+};
+
+// Run the driver until the refresh it started is done, with the clock moving so its polling goes on
+static Upload run_refresh(it8951e::IT8951ESensor &panel, bool &done, const std::function<void()> &start) {
+  bus_counters = {};
+  done = false;
+  start();
+  for (int i = 0; i < 100000 && !done; i++) {
+    testing::advance_millis(1);
+    panel.loop();
+  }
+  CHECK(done);
+  return {bus_counters.transactions, bus_counters.bytes_written};
+}
+
+int main() {
+  it8951e::IT8951ESensor panel;
+  GPIOPin pin;
+  panel.set_busy_pin(&pin);
+  panel.set_reset_pin(&pin);
+  panel.setup();
+  // The stats count transfers until they are reported, the sensor keeps the last report
+  sensor::Sensor bytes_sent;
+  panel.set_bytes_sent_sensor(&bytes_sent);
+  bool done = false;
+  panel.add_on_refresh_complete_callback([&done]() { done = true; });
+
+  // Every gray level, so the first frame goes out as 4bpp over the whole panel
+  panel.set_writer([](display::Display &it) {
+    for (int x = 0; x < WIDTH; x++)
+      it.vertical_line(x, 0, HEIGHT, Color(x % 16, x % 16, x % 16, x % 16));
+  });
+  Upload full = run_refresh(panel, done, [&panel]() { panel.update(); });
+  printf("full frame: %u transactions, %llu bytes written, %u image bytes\n", full.transactions,
+         (unsigned long long) full.bytes, uint32_t(bytes_sent.state));
+  CHECK(uint32_t(bytes_sent.state) == FRAME_BYTES);
+  CHECK(full.bytes >= FRAME_BYTES);
+  // One burst per 8 KiB chunk of rows plus the commands around them, instead of one per word
+  CHECK(full.transactions < 200);
+  CHECK(full.transactions * 100 < FRAME_BYTES / 2);
+
+  // A small gray change uploads only its own area
+  panel.set_writer([](display::Display &it) {
+    for (int x = 0; x < WIDTH; x++)
+      it.vertical_line(x, 0, HEIGHT, Color(x % 16, x % 16, x % 16, x % 16));
+    it.filled_rectangle(100, 100, 20, 10, Color(7, 7, 7, 7));
+  });
+  Upload partial = run_refresh(panel, done, [&panel]() { panel.update(); });
+  printf("20x10 area: %u transactions, %llu bytes written, %u image bytes\n", partial.transactions,
+         (unsigned long long) partial.bytes, uint32_t(bytes_sent.state));
+  CHECK(uint32_t(bytes_sent.state) > 0);
+  CHECK(uint32_t(bytes_sent.state) < 1024);
+  CHECK(partial.transactions < 50);
+
+  // Black and white content goes out as a bitmap, an eighth of the 4bpp data
+  panel.set_writer([](display::Display &it) {
+    it.fill(Color(15, 15, 15, 15));
+    it.filled_rectangle(0, 0, WIDTH / 2, HEIGHT, Color(0, 0, 0, 0));
+  });
+  Upload bitmap = run_refresh(panel, done, [&panel]() { panel.update(); });
+  printf("black and white frame: %u transactions, %llu bytes written, %u image bytes\n", bitmap.transactions,
+         (unsigned long long) bitmap.bytes, uint32_t(bytes_sent.state));
+  CHECK(uint32_t(bytes_sent.state) <= FRAME_BYTES / 4);
+  CHECK(bitmap.transactions < 200);
+
+  // clear() streams its white fill the same way
+  bus_counters = {};
+  panel.clear(false);
+  printf("clear: %u transactions, %llu bytes written\n", bus_counters.transactions,
+         (unsigned long long) bus_counters.bytes_written);
+  CHECK(bus_counters.bytes_written >= FRAME_BYTES);
+  CHECK(bus_counters.transactions < 20);
+
+  return testing::report("it8951e_upload_test");
+}
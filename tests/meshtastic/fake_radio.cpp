@@ -0,0 +1,357 @@
+#include "fake_radio.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace esphome {
+namespace testing {
+
+static const uint8_t START1 = 0x94;
+static const uint8_t START2 = 0xC3;
+static const size_t HEADER_SIZE = 4;
+
+static const uint32_t PORTNUM_ROUTING = 5;
+static const uint32_t PORTNUM_ADMIN = 6;
+// Routing::Error
+static const uint32_t ROUTING_ERROR_MAX_RETRANSMIT = 5;
+// QueueStatus.res when the TX queue is full
+static const uint32_t QUEUE_FULL = 32;
+
+static bool read_varint(const uint8_t *buf, size_t *pos, size_t len, uint32_t *value) {
+  *value = 0;
+  for (int shift = 0; *pos < len && shift < 64; shift += 7) {
+    uint8_t b = buf[(*pos)++];
+    if (shift < 32)
+      *value |= uint32_t(b & 0x7F) << shift;
+    if (!(b & 0x80))
+      return true;
+  }
+  return false;
+}
+
+// Calls fn(field, wire_type, value, data, data_len) for every field of a message, false if it is malformed
+template<typename F> static bool for_each_field(const uint8_t *buf, size_t len, F &&fn) {
+  size_t pos = 0;
+  while (pos < len) {
+    uint32_t tag;
+    uint32_t value = 0;
+    if (!read_varint(buf, &pos, len, &tag))
+      return false;
+    const uint8_t *data = nullptr;
+    size_t data_len = 0;
+    switch (tag & 0x07) {
+      case 0:
+        if (!read_varint(buf, &pos, len, &value))
+          return false;
+        break;
+      case 2:
+        if (!read_varint(buf, &pos, len, &value) || pos + value > len)
+          return false;
+        data = buf + pos;
+        data_len = value;
+        pos += value;
+        break;
+      case 5:
+        if (pos + 4 > len)
+          return false;
+        value = buf[pos] | (buf[pos + 1] << 8) | (buf[pos + 2] << 16) | (uint32_t(buf[pos + 3]) << 24);
+        pos += 4;
+        break;
+      default:
+        return false;
+    }
+    fn(tag >> 3, uint8_t(tag & 0x07), value, data, data_len);
+  }
+  return true;
+}
+
+void FakeRadio::write_array(const uint8_t *data, size_t len) {
+  this->from_host_.insert(this->from_host_.end(), data, data + len);
+  // Wake bytes and anything else between frames are skipped like the firmware does
+  size_t pos = 0;
+  while (true) {
+    auto it = std::find(this->from_host_.begin() + pos, this->from_host_.end(), START1);
+    pos = it - this->from_host_.begin();
+    if (this->from_host_.size() - pos < HEADER_SIZE)
+      break;
+    if (this->from_host_[pos + 1] != START2) {
+      pos++;
+      continue;
+    }
+    size_t frame_len = (this->from_host_[pos + 2] << 8) | this->from_host_[pos + 3];
+    if (this->from_host_.size() - pos < HEADER_SIZE + frame_len)
+      break;
+    this->frames_received_++;
+    // A copy, handling the frame may reboot the radio and clear the buffer
+    std::vector<uint8_t> frame(this->from_host_.begin() + pos + HEADER_SIZE,
+                               this->from_host_.begin() + pos + HEADER_SIZE + frame_len);
+    pos += HEADER_SIZE + frame_len;
+    this->handle_to_radio_(frame.data(), frame.size());
+  }
+  this->from_host_.erase(this->from_host_.begin(), this->from_host_.begin() + std::min(pos, this->from_host_.size()));
+}
+
+bool FakeRadio::read_array(uint8_t *data, size_t len) {
+  this->uart_calls_++;
+  if (len > this->pending())
+    return false;
+  memcpy(data, this->to_host_.data() + this->read_pos_, len);
+  this->read_pos_ += len;
+  this->line_credit_ -= std::min<uint64_t>(this->line_credit_, uint64_t(len) * 10000);
+  if (this->read_pos_ == this->to_host_.size()) {
+    this->to_host_.clear();
+    this->read_pos_ = 0;
+  }
+  return true;
+}
+
+int FakeRadio::available() {
+  this->uart_calls_++;
+  this->update_();
+  size_t available = std::min(this->pending(), this->fifo_size_);
+  // Ten bits per byte on the line; the credit is in bits per 1000, the unit of ms times baud
+  if (this->baud_rate_ != 0)
+    available = std::min<size_t>(available, this->line_credit_ / 10000);
+  return available;
+}
+
+void FakeRadio::update_() {
+  uint32_t now = millis();
+  // An idle line saves nothing up
+  if (this->pending() == 0)
+    this->line_credit_ = 0;
+  else
+    this->line_credit_ += uint64_t(now - this->last_update_) * this->baud_rate_;
+  this->last_update_ = now;
+
+  // Events fire in the order they are due
+  while (true) {
+    auto it = std::min_element(this->events_.begin(), this->events_.end(),
+                               [](const Event &a, const Event &b) { return a.due < b.due; });
+    if (it == this->events_.end() || int32_t(now - it->due) < 0)
+      break;
+    Event event = std::move(*it);
+    this->events_.erase(it);
+    if (event.reboot) {
+      this->reboot();
+    } else if (event.frame.empty()) {
+      this->queue_used_--;
+    } else {
+      this->inject(event.frame.data(), event.frame.size());
+    }
+  }
+}
+
+void FakeRadio::schedule_(uint32_t delay, std::vector<uint8_t> frame, bool reboot) {
+  this->events_.push_back(Event{millis() + delay, std::move(frame), reboot});
+}
+
+bool FakeRadio::chance_(float probability) {
+  return probability > 0 && std::uniform_real_distribution<float>(0, 1)(this->rng_) < probability;
+}
+
+void FakeRadio::inject(const uint8_t *data, size_t len) {
+  // The line starts sending now, not when the component next looks
+  if (this->pending() == 0) {
+    this->line_credit_ = 0;
+    this->last_update_ = millis();
+  }
+  this->to_host_.insert(this->to_host_.end(), data, data + len);
+}
+
+void FakeRadio::send_frame(const uint8_t *payload, size_t len) {
+  const uint8_t header[HEADER_SIZE] = {START1, START2, uint8_t(len >> 8), uint8_t(len)};
+  this->inject(header, sizeof(header));
+  this->inject(payload, len);
+}
+
+void FakeRadio::send_packet(uint32_t from, uint32_t to, uint32_t id, uint32_t portnum, const std::string &payload,
+                            uint32_t request_id) {
+  // FromRadio { packet = MeshPacket { from, to, channel, decoded = Data { portnum, payload, request_id }, id } }
+  this->send([&](auto &from_radio) {
+    from_radio.write_message(2, [&](auto &packet) {
+      packet.write_fixed32(1, from);
+      packet.write_fixed32(2, to);
+      packet.write_varint(3, 0);
+      packet.write_message(4, [&](auto &data) {
+        data.write_varint(1, portnum);
+        data.write_string(2, payload);
+        if (request_id != 0)
+          data.write_fixed32(6, request_id);
+      });
+      packet.write_fixed32(6, id);
+    });
+  });
+}
+
+void FakeRadio::send_node_info(uint32_t num, const std::string &long_name, const std::string &short_name,
+                               uint32_t last_heard) {
+  // FromRadio { node_info = NodeInfo { num, user = User { id, long_name, short_name }, snr, last_heard } }
+  char id[12];
+  snprintf(id, sizeof(id), "!%08x", num);
+  this->send([&](auto &from_radio) {
+    from_radio.write_message(4, [&](auto &node) {
+      node.write_varint(1, num);
+      node.write_message(2, [&](auto &user) {
+        user.write_string(1, id);
+        user.write_string(2, long_name);
+        user.write_string(3, short_name);
+      });
+      float snr = 6.25f;
+      uint32_t snr_bits;
+      memcpy(&snr_bits, &snr, sizeof(snr_bits));
+      node.write_fixed32(4, snr_bits);
+      node.write_fixed32(5, last_heard);
+    });
+  });
+}
+
+void FakeRadio::set_names(const std::string &long_name, const std::string &short_name) {
+  this->long_name_ = long_name;
+  this->short_name_ = short_name;
+}
+
+void FakeRadio::set_section(uint32_t from_radio_field, const std::string &section) {
+  // Config and ModuleConfig frames hold one section, told apart by its field; channels by their index, field 1
+  std::string key;
+  for_each_field(reinterpret_cast<const uint8_t *>(section.data()), section.size(),
+                 [&](uint32_t field, uint8_t, uint32_t value, const uint8_t *, size_t) {
+                   if (key.empty())
+                     key = std::to_string(field) + "/" + (from_radio_field == 9 ? std::to_string(value) : "");
+                 });
+  for (Section &existing : this->sections_) {
+    if (existing.field == from_radio_field && existing.key == key) {
+      existing.data = section;
+      return;
+    }
+  }
+  this->sections_.push_back(Section{from_radio_field, key, section});
+}
+
+void FakeRadio::reboot() {
+  this->reboots_++;
+  this->events_.clear();
+  this->queue_used_ = 0;
+  this->from_host_.clear();
+  this->send([](auto &from_radio) { from_radio.write_varint(8, 1); });
+}
+
+void FakeRadio::send_dump_(uint32_t nonce) {
+  // my_info, our own node, the others most recently heard first, the config sections, then config_complete_id
+  this->config_requests_++;
+  this->send([](auto &from_radio) {
+    from_radio.write_message(3, [](auto &my_info) { my_info.write_varint(1, NODE_NUM); });
+  });
+  this->send_node_info(NODE_NUM, this->long_name_, this->short_name_, MESH_TIME);
+  for (size_t i = 0; i < this->dump_nodes_; i++) {
+    uint32_t num = 0x10000000 + i * 0x1111;
+    this->send_node_info(num, "Mesh node " + std::to_string(i), "M" + std::to_string(i % 1000), MESH_TIME - i * 60);
+  }
+  for (const Section &section : this->sections_)
+    this->send([&section](auto &from_radio) { from_radio.write_string(section.field, section.data); });
+  this->send([nonce](auto &from_radio) { from_radio.write_varint(7, nonce); });
+}
+
+void FakeRadio::handle_to_radio_(const uint8_t *buf, size_t len) {
+  // ToRadio { packet (1), want_config_id (3) }
+  for_each_field(buf, len, [this](uint32_t field, uint8_t wire_type, uint32_t value, const uint8_t *data, size_t n) {
+    if (field == 1 && wire_type == 2) {
+      this->handle_packet_(data, n);
+    } else if (field == 3 && wire_type == 0) {
+      this->send_dump_(value);
+    }
+  });
+}
+
+void FakeRadio::handle_packet_(const uint8_t *buf, size_t len) {
+  // MeshPacket { to (2), decoded (4) = Data { portnum (1), payload (2) }, id (6), want_ack (10) }
+  Packet packet{};
+  packet.at = millis();
+  for_each_field(buf, len, [&packet](uint32_t field, uint8_t, uint32_t value, const uint8_t *data, size_t n) {
+    if (field == 2) {
+      packet.to = value;
+    } else if (field == 6) {
+      packet.id = value;
+    } else if (field == 10) {
+      packet.want_ack = value != 0;
+    } else if (field == 4 && data != nullptr) {
+      for_each_field(data, n, [&packet](uint32_t data_field, uint8_t, uint32_t data_value, const uint8_t *payload,
+                                        size_t payload_len) {
+        if (data_field == 1) {
+          packet.portnum = data_value;
+        } else if (data_field == 2 && payload != nullptr) {
+          packet.payload.assign(reinterpret_cast<const char *>(payload), payload_len);
+        }
+      });
+    }
+  });
+  this->packets_.push_back(packet);
+
+  // QueueStatus { res, free, maxlen, mesh_packet_id } for every packet, like the firmware
+  bool full = this->queue_used_ >= this->queue_size_;
+  if (full) {
+    this->rejected_++;
+  } else {
+    this->queue_used_++;
+  }
+  uint32_t free = this->queue_size_ - this->queue_used_;
+  this->send([&](auto &from_radio) {
+    from_radio.write_message(11, [&](auto &status) {
+      status.write_varint(1, full ? QUEUE_FULL : 0);
+      status.write_varint(2, free);
+      status.write_varint(3, this->queue_size_);
+      status.write_varint(4, packet.id);
+    });
+  });
+  if (full)
+    return;
+
+  // The slot frees up once the packet went out, and the mesh answers about then
+  this->schedule_(this->ack_delay_, {});
+  if (packet.portnum == PORTNUM_ADMIN && packet.to == NODE_NUM)
+    this->handle_admin_(reinterpret_cast<const uint8_t *>(packet.payload.data()), packet.payload.size());
+  if (!packet.want_ack || this->chance_(this->loss_))
+    return;
+
+  // FromRadio { packet = MeshPacket { from, to, decoded = Data { ROUTING, Routing { error_reason }, request_id },
+  //                                   id } }, from the destination or from ourselves for a broadcast
+  uint32_t error = this->chance_(this->nak_rate_) ? ROUTING_ERROR_MAX_RETRANSMIT : 0;
+  uint32_t from = packet.to == 0xFFFFFFFF ? NODE_NUM : packet.to;
+  uint32_t id = this->next_id_++;
+  uint8_t reply_buf[64];
+  meshtastic::ProtoWriter from_radio(reply_buf, sizeof(reply_buf));
+  from_radio.write_message(2, [&](auto &reply) {
+    reply.write_fixed32(1, from);
+    reply.write_fixed32(2, NODE_NUM);
+    reply.write_message(4, [&](auto &data) {
+      data.write_varint(1, PORTNUM_ROUTING);
+      data.write_message(2, [error](auto &routing) { routing.write_varint(3, error); });
+      data.write_fixed32(6, packet.id);
+    });
+    reply.write_fixed32(6, id);
+  });
+  std::vector<uint8_t> frame = {START1, START2, uint8_t(from_radio.size() >> 8), uint8_t(from_radio.size())};
+  frame.insert(frame.end(), from_radio.data(), from_radio.data() + from_radio.size());
+  this->schedule_(this->ack_delay_, std::move(frame));
+}
+
+void FakeRadio::handle_admin_(const uint8_t *buf, size_t len) {
+  // AdminMessage { set_channel (33), set_config (34), set_module_config (35), reboot_seconds (97) }
+  for_each_field(buf, len, [this](uint32_t field, uint8_t wire_type, uint32_t value, const uint8_t *data, size_t n) {
+    if (wire_type == 2 && (field == 33 || field == 34 || field == 35)) {
+      std::string section(reinterpret_cast<const char *>(data), n);
+      this->set_section(field == 33 ? 9 : field - 29, section);
+    } else if (field == 97 && wire_type == 0) {
+      this->schedule_(value * 1000, {}, true);
+    }
+  });
+}
+
+bool bring_up(meshtastic::MeshtasticComponent &mesh, uint32_t timeout_ms, uint32_t step_ms) {
+  mesh.setup();
+  return run_until(mesh, timeout_ms, [&mesh]() { return mesh.is_ready(); }, step_ms);
+}
+
+}  // namespace testing
+}  // namespace esphome
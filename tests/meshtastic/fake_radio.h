@@ -0,0 +1,166 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "esphome/components/meshtastic/meshtastic.h"
+#include "esphome/components/meshtastic/proto_writer.h"
+#include "esphome/components/uart/uart.h"
+#include "esphome/core/hal.h"
+
+namespace esphome {
+namespace testing {
+
+/** A Meshtastic radio on the other end of the UART, speaking the 0x94 0xC3 serial framing.
+ *
+ * It answers want_config with a scripted dump: its own node, the nodes of the mesh and the config sections it holds.
+ * Packets from the component are answered with a QueueStatus right away and, when they want one, a routing ACK or
+ * NAK once the mesh delivered them, unless they got lost. Admin messages change the config sections of the next dump
+ * and reboot_seconds reboots it. Anything else the component should receive is queued with send() or inject().
+ *
+ * Time is the millis() of the stubs, so a test decides how fast the mesh answers. The component reads at most
+ * fifo_size bytes per available(), and no faster than the baud rate if one is set.
+ */
+class FakeRadio : public uart::UARTComponent {
+ public:
+  static constexpr uint32_t NODE_NUM = 0x0A0B0C0D;
+  static constexpr uint32_t MESH_TIME = 1700000000;
+
+  /// A packet the component handed to the radio.
+  struct Packet {
+    uint32_t id;
+    uint32_t to;
+    uint32_t portnum;
+    std::string payload;
+    bool want_ack;
+    uint32_t at;
+  };
+
+  void write_array(const uint8_t *data, size_t len) override;
+  bool read_array(uint8_t *data, size_t len) override;
+  int available() override;
+
+  /// Bytes available() reports at most, what the UART holds between two loop() calls.
+  void set_fifo_size(size_t size) { this->fifo_size_ = size; }
+  /// Serial speed the radio sends at, 0 (the default) for as fast as the component reads.
+  void set_baud_rate(uint32_t baud) { this->baud_rate_ = baud; }
+  /// available() and read_array() calls so far.
+  uint32_t get_uart_calls() const { return this->uart_calls_; }
+  void reset_uart_calls() { this->uart_calls_ = 0; }
+  /// Bytes queued for the component that it has not read yet.
+  size_t pending() const { return this->to_host_.size() - this->read_pos_; }
+  /// ToRadio frames received from the component.
+  uint32_t get_frames_received() const { return this->frames_received_; }
+
+  // The config dump
+  void set_names(const std::string &long_name, const std::string &short_name);
+  /// Other nodes listed in the dump, most recently heard first.
+  void set_dump_nodes(size_t count) { this->dump_nodes_ = count; }
+  /// A config (5), module_config (6) or channel (9) field of the dump, replacing the one for the same section.
+  void set_section(uint32_t from_radio_field, const std::string &section);
+  /// want_config requests answered.
+  uint32_t get_config_requests() const { return this->config_requests_; }
+
+  // The mesh
+  /// Time from taking a packet until its ACK, the airtime and hops of a real mesh.
+  void set_ack_delay(uint32_t ms) { this->ack_delay_ = ms; }
+  /// Chance that a packet gets no answer at all, and that it is NAKed.
+  void set_loss(float probability) { this->loss_ = probability; }
+  void set_nak_rate(float probability) { this->nak_rate_ = probability; }
+  /// TX queue slots; a packet holds one until it went out, after the ACK delay. When full, packets are turned away.
+  void set_queue_size(uint32_t slots) { this->queue_size_ = slots; }
+  void set_seed(uint32_t seed) { this->rng_.seed(seed); }
+  /// Packets the component sent, admin messages included, in order.
+  const std::vector<Packet> &get_packets() const { return this->packets_; }
+  /// Packets turned away because the TX queue was full.
+  uint32_t get_rejected() const { return this->rejected_; }
+
+  /// Restart as the firmware does: drop what is queued and in flight and tell the component with rebooted.
+  void reboot();
+  uint32_t get_reboots() const { return this->reboots_; }
+
+  /// Queue raw bytes, e.g. debug text the firmware prints on the same UART.
+  void inject(const uint8_t *data, size_t len);
+  void inject(const std::string &text) { this->inject(reinterpret_cast<const uint8_t *>(text.data()), text.size()); }
+  /// Queue a FromRadio message in a frame.
+  template<typename F> void send(F &&fields) {
+    uint8_t buf[512];
+    meshtastic::ProtoWriter writer(buf, sizeof(buf));
+    fields(writer);
+    this->send_frame(writer.data(), writer.size());
+  }
+  void send_frame(const uint8_t *payload, size_t len);
+  /// Queue a FromRadio packet with decoded Data, as the radio passes on a packet from the mesh.
+  void send_packet(uint32_t from, uint32_t to, uint32_t id, uint32_t portnum, const std::string &payload,
+                   uint32_t request_id = 0);
+  /// Queue a FromRadio node_info for a node of the mesh.
+  void send_node_info(uint32_t num, const std::string &long_name, const std::string &short_name, uint32_t last_heard);
+
+ protected:
+  struct Event {
+    uint32_t due;
+    std::vector<uint8_t> frame;  // FromRadio frame to send, or empty to free a TX queue slot
+    bool reboot;                 // Reboot instead
+  };
+  struct Section {
+    uint32_t field;
+    std::string key;
+    std::string data;
+  };
+
+  void update_();
+  void handle_to_radio_(const uint8_t *buf, size_t len);
+  void handle_packet_(const uint8_t *buf, size_t len);
+  void handle_admin_(const uint8_t *buf, size_t len);
+  void send_dump_(uint32_t nonce);
+  void schedule_(uint32_t delay, std::vector<uint8_t> frame, bool reboot = false);
+  bool chance_(float probability);
+
+  std::vector<uint8_t> to_host_;
+  size_t read_pos_{0};
+  std::vector<uint8_t> from_host_;
+  size_t fifo_size_{256};
+  uint32_t baud_rate_{0};
+  uint64_t line_credit_{0};
+  uint32_t last_update_{0};
+  uint32_t uart_calls_{0};
+  uint32_t frames_received_{0};
+
+  std::string long_name_{"Fake Radio"};
+  std::string short_name_{"FAKE"};
+  size_t dump_nodes_{0};
+  std::vector<Section> sections_;
+  uint32_t config_requests_{0};
+
+  uint32_t ack_delay_{0};
+  float loss_{0};
+  float nak_rate_{0};
+  uint32_t queue_size_{16};
+  uint32_t queue_used_{0};
+  uint32_t next_id_{1};
+  std::mt19937 rng_{25};
+  std::vector<Event> events_;
+  std::vector<Packet> packets_;
+  uint32_t rejected_{0};
+  uint32_t reboots_{0};
+};
+
+/// Run the component until it is ready, in steps of `step_ms` of the stub clock.
+bool bring_up(meshtastic::MeshtasticComponent &mesh, uint32_t timeout_ms = 10000, uint32_t step_ms = 10);
+/// Run the component for `ms` of the stub clock, or until `done` returns true.
+template<typename F>
+bool run_until(meshtastic::MeshtasticComponent &mesh, uint32_t ms, F &&done, uint32_t step_ms = 10) {
+  for (uint32_t t = 0; t < ms; t += step_ms) {
+    if (done())
+      return true;
+    advance_millis(step_ms);
+    mesh.loop();
+  }
+  return done();
+}
+
+}  // namespace testing
+}  // namespace esphome
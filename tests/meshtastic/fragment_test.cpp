@@ -0,0 +1,195 @@
+// LZSS round trips and malformed input, fragment headers, the Reassembler's slots and timeout, and a compressed
+// transfer put back together by the component from fragments arriving out of order.
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "esphome/components/meshtastic/fragment.h"
+#include "esphome/components/meshtastic/lzss.h"
+#include "fake_radio.h"
+#include "test_helpers.h"
+
+using namespace esphome;
+using namespace esphome::meshtastic;
+using esphome::testing::FakeRadio;
+
+static constexpr uint32_t PORTNUM_PRIVATE = 256;
+
+static const uint8_t *bytes(const std::string &s) { return reinterpret_cast<const uint8_t *>(s.data()); }
+
+static bool round_trips(const std::string &input) {
+  std::string compressed;
+  if (!lzss_compress(bytes(input), input.size(), &compressed))
+    return false;
+  std::string output;
+  return compressed.size() < input.size() &&
+         lzss_decompress(bytes(compressed), compressed.size(), input.size(), &output) && output == input;
+}
+
+// What an ESPHome node logs about its sensors, the kind of text worth sending compressed
+static std::string sensor_log(size_t min_size) {
+  static const char *const NAMES[] = {"Outdoor Temperature", "Outdoor Humidity", "Pressure", "Battery Voltage"};
+  static const char *const UNITS[] = {"°C", "%", "hPa", "V"};
+  std::string log;
+  char line[160];
+  for (int i = 0; log.size() < min_size; i++) {
+    snprintf(line, sizeof(line),
+             "[08:%02d:%02d][D][sensor:093]: '%s': Sending state %.5f %s with 2 decimals of accuracy\n", 15 + i / 60,
+             i % 60, NAMES[i % 4], 20.0 + (i * 37 % 100) / 10.0, UNITS[i % 4]);
+    log += line;
+  }
+  return log;
+}
+
+static std::string fragment(const std::string &body, uint16_t transfer_id, size_t index, uint8_t flags) {
+  size_t count = (body.size() + FRAGMENT_DATA_SIZE - 1) / FRAGMENT_DATA_SIZE;
+  FragmentHeader header{transfer_id, uint8_t(index), uint8_t(count), flags};
+  std::string packet(FragmentHeader::SIZE, '\0');
+  header.write(reinterpret_cast<uint8_t *>(&packet[0]));
+  packet.append(body, index * FRAGMENT_DATA_SIZE, FRAGMENT_DATA_SIZE);
+  return packet;
+}
+
+// Feed one fragment to a reassembler, true if it completed a payload, which must equal `expected`
+static bool add(Reassembler &reassembler, uint32_t from, const std::string &packet, uint32_t now,
+                const std::string &expected = "") {
+  FragmentHeader header;
+  CHECK(header.read(bytes(packet), packet.size()));
+  std::string payload;
+  uint8_t flags;
+  if (!reassembler.add(from, header, bytes(packet) + FragmentHeader::SIZE, packet.size() - FragmentHeader::SIZE, now,
+                       &payload, &flags))
+    return false;
+  CHECK(payload == expected);
+  return true;
+}
+
+int main() {
+  std::mt19937 rng(22);
+
+  // LZSS: runs, overlapping matches, the 18 byte match limit
+  CHECK(round_trips(std::string(1000, 'a')));
+  CHECK(round_trips("abcabcabcabcabcabcabcabcabcabcabcabc"));
+  // Random bytes around a long run: the copy at exactly the window size is a match, one byte further it is not
+  std::string head(50, '\0');
+  for (char &c : head)
+    c = char(rng());
+  std::string in_window = head + std::string(4046, 'z') + head;
+  std::string past_window = head + std::string(4047, 'z') + head;
+  CHECK(round_trips(in_window) && round_trips(past_window));
+  std::string in_window_compressed, past_window_compressed;
+  lzss_compress(bytes(in_window), in_window.size(), &in_window_compressed);
+  lzss_compress(bytes(past_window), past_window.size(), &past_window_compressed);
+  CHECK(in_window_compressed.size() + 30 < past_window_compressed.size());
+  std::string block(4000, '\0');
+  for (char &c : block)
+    c = char(rng());
+  std::string compressed;
+  CHECK(!lzss_compress(bytes(block), block.size(), &compressed));  // Random data does not get smaller
+  CHECK(!lzss_compress(bytes(block), 2, &compressed));
+
+  std::string log = sensor_log(2900);
+  CHECK(lzss_compress(bytes(log), log.size(), &compressed));
+  std::string output;
+  CHECK(lzss_decompress(bytes(compressed), compressed.size(), MAX_TRANSFER_SIZE, &output) && output == log);
+  size_t packets = (log.size() + FRAGMENT_DATA_SIZE - 1) / FRAGMENT_DATA_SIZE;
+  size_t compressed_packets = (compressed.size() + FRAGMENT_DATA_SIZE - 1) / FRAGMENT_DATA_SIZE;
+  CHECK(compressed.size() * 3 < log.size());
+  printf("sensor log: %u bytes in %u packets, compressed %u bytes in %u packets\n", unsigned(log.size()),
+         unsigned(packets), unsigned(compressed.size()), unsigned(compressed_packets));
+
+  // Malformed input is refused: cut short, trailing bytes, a size over the limit, a reference before the start
+  CHECK(!lzss_decompress(bytes(compressed), compressed.size() - 1, MAX_TRANSFER_SIZE, &output));
+  CHECK(!lzss_decompress(bytes(compressed + "x"), compressed.size() + 1, MAX_TRANSFER_SIZE, &output));
+  CHECK(!lzss_decompress(bytes(compressed), compressed.size(), log.size() - 1, &output));
+  const uint8_t bad_reference[] = {0x05, 0x01, 0x20, 0x00};
+  CHECK(!lzss_decompress(bad_reference, sizeof(bad_reference), 100, &output));
+  const uint8_t endless_size[] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x01};
+  CHECK(!lzss_decompress(endless_size, sizeof(endless_size), MAX_TRANSFER_SIZE, &output));
+  for (int i = 0; i < 2000; i++) {
+    std::string garbage = compressed;
+    garbage[rng() % garbage.size()] ^= char(1 << rng() % 8);
+    if (lzss_decompress(bytes(garbage), garbage.size(), MAX_TRANSFER_SIZE, &output))
+      CHECK(output.size() <= MAX_TRANSFER_SIZE);
+  }
+
+  // Headers: round trip, and what is not a fragment of this version
+  FragmentHeader header{0xBEEF, 3, 7, FragmentHeader::VERSION | FragmentHeader::FLAG_COMPRESSED};
+  uint8_t raw[FragmentHeader::SIZE];
+  header.write(raw);
+  FragmentHeader read;
+  CHECK(read.read(raw, sizeof(raw)) && read.transfer_id == 0xBEEF && read.index == 3 && read.count == 7 &&
+        read.flags == header.flags);
+  CHECK(!read.read(raw, FragmentHeader::SIZE - 1));
+  raw[4] = 0x20;
+  CHECK(!read.read(raw, sizeof(raw)));
+  raw[4] = FragmentHeader::VERSION;
+  raw[2] = 7;
+  CHECK(!read.read(raw, sizeof(raw)));
+  raw[2] = 0;
+  raw[3] = MAX_FRAGMENTS + 1;
+  CHECK(!read.read(raw, sizeof(raw)));
+
+  // Reassembly in any order, with duplicates, of a full size transfer
+  std::string big(MAX_TRANSFER_SIZE, '\0');
+  for (char &c : big)
+    c = char(rng());
+  std::vector<size_t> order(MAX_FRAGMENTS);
+  for (size_t i = 0; i < order.size(); i++)
+    order[i] = i;
+  std::shuffle(order.begin(), order.end(), rng);
+  Reassembler reassembler;
+  reassembler.set_slots(2);
+  int completed = 0;
+  for (size_t i = 0; i < order.size(); i++) {
+    completed += add(reassembler, 1, fragment(big, 1, order[i], FragmentHeader::VERSION), 0, big);
+    if (i % 5 == 0)
+      completed += add(reassembler, 1, fragment(big, 1, order[i], FragmentHeader::VERSION), 0, big);
+  }
+  CHECK(completed == 1);
+
+  // A short last fragment is fine, a short one that is not last is refused
+  std::string small = big.substr(0, FRAGMENT_DATA_SIZE + 10);
+  CHECK(!add(reassembler, 2, fragment(small, 9, 1, FragmentHeader::VERSION), 0));
+  CHECK(add(reassembler, 2, fragment(small, 9, 0, FragmentHeader::VERSION), 0, small));
+  std::string cut = fragment(big, 3, 0, FragmentHeader::VERSION);
+  cut.pop_back();
+  CHECK(!add(reassembler, 2, cut, 0));
+
+  // Two slots: the same transfer id from two senders is two transfers, a third one evicts the least recently active
+  std::string a = big.substr(0, 2 * FRAGMENT_DATA_SIZE);
+  std::string b = big.substr(100, 2 * FRAGMENT_DATA_SIZE);
+  reassembler.set_slots(2);
+  CHECK(!add(reassembler, 10, fragment(a, 5, 0, FragmentHeader::VERSION), 100));
+  CHECK(!add(reassembler, 11, fragment(b, 5, 0, FragmentHeader::VERSION), 200));
+  CHECK(!add(reassembler, 12, fragment(a, 6, 0, FragmentHeader::VERSION), 300));  // Evicts sender 10
+  CHECK(add(reassembler, 11, fragment(b, 5, 1, FragmentHeader::VERSION), 400, b));
+  CHECK(!add(reassembler, 10, fragment(a, 5, 1, FragmentHeader::VERSION), 500));
+  // Sender 12 stalls past the timeout and has to start over
+  reassembler.set_timeout(1000);
+  reassembler.expire(1301);
+  CHECK(!add(reassembler, 12, fragment(a, 6, 1, FragmentHeader::VERSION), 1400));
+  CHECK(add(reassembler, 12, fragment(a, 6, 0, FragmentHeader::VERSION), 1500, a));
+
+  // The component: a compressed log in fragments, out of order and one repeated, is delivered once and inflated
+  FakeRadio radio;
+  MeshtasticComponent mesh;
+  mesh.set_uart_parent(&radio);
+  mesh.set_reassembly_slots(2);
+  CHECK(testing::bring_up(mesh));
+  std::vector<std::string> received;
+  mesh.add_on_message_callback([&received](const std::string &message) { received.push_back(message); });
+  uint8_t flags = FragmentHeader::VERSION | FragmentHeader::FLAG_COMPRESSED;
+  for (size_t i = compressed_packets; i-- > 0;)
+    radio.send_packet(0x4321, FakeRadio::NODE_NUM, 100 + i, PORTNUM_PRIVATE, fragment(compressed, 0x77, i, flags));
+  radio.send_packet(0x4321, FakeRadio::NODE_NUM, 200, PORTNUM_PRIVATE, fragment(compressed, 0x77, 0, flags));
+  for (int i = 0; i < 10; i++) {
+    testing::advance_millis(10);
+    mesh.loop();
+  }
+  CHECK(received.size() == 1 && received[0] == log);
+
+  return testing::report("meshtastic_fragment_test");
+}
@@ -0,0 +1,97 @@
+// The serial frame parser of the meshtastic component: frames buried in debug text and broken headers, read in chunks
+// of any size, all come out in order; and what taking in a config dump costs in UART calls and time.
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "fake_radio.h"
+#include "test_helpers.h"
+
+using namespace esphome;
+using namespace esphome::meshtastic;
+using esphome::testing::FakeRadio;
+
+static constexpr uint32_t BROADCAST = 0xFFFFFFFF;
+static constexpr int NOISY_FRAMES = 400;
+static constexpr int DUMP_FRAMES = 300;
+static constexpr int DUMP_RUNS = 200;
+
+// Run the component until it has read everything the radio queued, reading at most max_chunk bytes per UART read
+static void drain(MeshtasticComponent &mesh, FakeRadio &radio, std::mt19937 *rng = nullptr, size_t max_chunk = 256) {
+  for (int i = 0; i < 1000000 && radio.pending() > 0; i++) {
+    if (rng != nullptr)
+      radio.set_fifo_size(1 + (*rng)() % max_chunk);
+    mesh.loop();
+  }
+}
+
+int main() {
+  FakeRadio radio;
+  MeshtasticComponent mesh;
+  mesh.set_uart_parent(&radio);
+  CHECK(testing::bring_up(mesh));
+  CHECK(mesh.get_my_node_num() == FakeRadio::NODE_NUM);
+
+  std::vector<std::string> received;
+  mesh.add_on_message_callback([&received](const std::string &text) { received.push_back(text); });
+
+  // Text packets with what a radio and a noisy line put between them: debug lines the firmware prints on the same
+  // UART, a lone START1, headers that claim more than MAX_PAYLOAD or nothing at all
+  std::mt19937 rng(18);
+  std::vector<std::string> sent;
+  for (int i = 0; i < NOISY_FRAMES; i++) {
+    switch (rng() % 5) {
+      case 0:
+        radio.inject("DEBUG | 12:00:" + std::to_string(i % 60) + " [Router] Received text msg from=0x" +
+                     std::to_string(i) + "\r\n");
+        break;
+      case 1:
+        radio.inject("\x94");
+        break;
+      case 2:
+        radio.inject(std::string("\x94\xC3\xFF\xFF", 4));
+        break;
+      case 3:
+        radio.inject(std::string("\x94\xC3\x00\x00", 4));
+        break;
+      default:
+        break;
+    }
+    sent.push_back("message " + std::to_string(i));
+    radio.send_packet(0x1000 + i % 7, BROADCAST, i + 1, 1, sent.back());
+  }
+  radio.inject("trailing debug output\r\n");
+  drain(mesh, radio, &rng, 300);
+  CHECK(received == sent);
+  printf("noisy stream: %u of %d frames delivered in order\n", unsigned(received.size()), NOISY_FRAMES);
+
+  // A config dump as the radio sends it after want_config: one node_info frame per node it knows
+  FakeRadio source;
+  for (int i = 0; i < DUMP_FRAMES; i++)
+    source.send_node_info(0x2000 + i, "Node number " + std::to_string(i), "N" + std::to_string(i % 100), 1700000000);
+  std::vector<uint8_t> dump(source.pending());
+  source.read_array(dump.data(), dump.size());
+
+  // At most 256 bytes per read, the default RX buffer of an ESPHome UART
+  radio.set_fifo_size(256);
+  radio.reset_uart_calls();
+  uint32_t frames_before = mesh.get_stats().frames_received;
+  double elapsed_us = 0;
+  for (int run = 0; run < DUMP_RUNS; run++) {
+    radio.inject(dump.data(), dump.size());
+    testing::Stopwatch stopwatch;
+    drain(mesh, radio);
+    elapsed_us += stopwatch.elapsed_us();
+  }
+  uint32_t frames = mesh.get_stats().frames_received - frames_before;
+  uint64_t bytes = uint64_t(dump.size()) * DUMP_RUNS;
+  CHECK(frames == uint32_t(DUMP_FRAMES) * DUMP_RUNS);
+  // Reading byte by byte took an available() and a read_byte() per byte
+  CHECK(radio.get_uart_calls() * 100 < bytes);
+  printf("%d-frame dump (%u bytes) x %d: %u UART calls (byte by byte: %llu), %.1f us per dump, %.2f Mframes/s\n",
+         DUMP_FRAMES, unsigned(dump.size()), DUMP_RUNS, radio.get_uart_calls(), (unsigned long long) (2 * bytes),
+         elapsed_us / DUMP_RUNS, frames / elapsed_us);
+
+  return testing::report("meshtastic_frame_parser_test");
+}
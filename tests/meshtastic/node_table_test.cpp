@@ -0,0 +1,182 @@
+// NodeTable against a plain list kept in use order, and the component filling it from the radio, refusing sends to
+// nodes not heard for too long and restoring it from preferences.
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "fake_radio.h"
+#include "test_helpers.h"
+
+using namespace esphome;
+using namespace esphome::meshtastic;
+using esphome::testing::FakeRadio;
+
+/// Exposes how far entries sit from the slot they hash to
+class ProbedTable : public NodeTable {
+ public:
+  size_t longest_probe() const {
+    size_t longest = 0;
+    for (size_t slot = 0; slot < this->slots_.size(); slot++) {
+      if (this->slots_[slot] == NONE)
+        continue;
+      size_t home = this->slot_of_(this->entries_[this->slots_[slot]].num);
+      longest = std::max(longest, (slot - home) & (this->slots_.size() - 1));
+    }
+    return longest;
+  }
+};
+
+static std::vector<uint32_t> order_of(const NodeTable &table) {
+  std::vector<uint32_t> order;
+  table.for_each([&order](const NodeEntry &node) { order.push_back(node.num); });
+  return order;
+}
+
+// Random touches, appends and lookups on a table of the given capacity, compared with a list most recent first
+static void check_against_list(size_t capacity, uint32_t num_range, std::mt19937 &rng) {
+  NodeTable table;
+  table.set_capacity(capacity);
+  std::vector<uint32_t> model;
+  for (int op = 0; op < 20000; op++) {
+    // Node numbers differing only in their high bits, like MAC derived ones
+    uint32_t num = 0xA0000000 + (rng() % num_range) * 0x10000;
+    auto it = std::find(model.begin(), model.end(), num);
+    switch (rng() % 3) {
+      case 0: {
+        NodeEntry *entry = table.touch(num);
+        CHECK(entry != nullptr && entry->num == num);
+        if (it != model.end()) {
+          model.erase(it);
+        } else {
+          if (model.size() == capacity)
+            model.pop_back();
+          entry->battery = num >> 16 & 0x7F;
+        }
+        model.insert(model.begin(), num);
+        break;
+      }
+      case 1: {
+        NodeEntry *entry = table.find_or_append(num);
+        if (it != model.end()) {
+          CHECK(entry != nullptr && entry->num == num);
+        } else if (model.size() < capacity) {
+          CHECK(entry != nullptr && entry->num == num && entry->hops == NodeEntry::HOPS_UNKNOWN);
+          entry->battery = num >> 16 & 0x7F;
+          model.push_back(num);
+        } else {
+          CHECK(entry == nullptr);
+        }
+        break;
+      }
+      default: {
+        const NodeEntry *entry = table.get(num);
+        CHECK((entry != nullptr) == (it != model.end()));
+        if (entry != nullptr)
+          CHECK(entry->num == num && entry->battery == (num >> 16 & 0x7F));
+        break;
+      }
+    }
+    if (op % 97 == 0)
+      CHECK(order_of(table) == model);
+  }
+  CHECK(table.size() == model.size());
+  CHECK(order_of(table) == model);
+}
+
+// FromRadio packet with the metadata the node table keeps; rx_rssi is negative, a sign-extended ten byte varint
+static std::vector<uint8_t> packet_from(uint32_t from, uint32_t id, uint32_t rx_time) {
+  std::vector<uint8_t> packet(64);
+  ProtoWriter writer(packet.data(), packet.size());
+  float snr = -7.5f;
+  uint32_t snr_bits;
+  memcpy(&snr_bits, &snr, sizeof(snr_bits));
+  writer.write_fixed32(1, from);
+  writer.write_fixed32(2, FakeRadio::NODE_NUM);
+  writer.write_fixed32(6, id);
+  writer.write_fixed32(7, rx_time);
+  writer.write_fixed32(8, snr_bits);
+  writer.write_varint(9, 1);
+  packet.resize(writer.size());
+  const uint8_t rssi[] = {0x60, 0xA6, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x01};  // rx_rssi = -90
+  packet.insert(packet.end(), rssi, rssi + sizeof(rssi));
+  packet.push_back(15 << 3);  // hop_start = 3, after the RSSI so a misparsed varint shows
+  packet.push_back(3);
+
+  std::vector<uint8_t> from_radio = {0x12, uint8_t(packet.size())};
+  from_radio.insert(from_radio.end(), packet.begin(), packet.end());
+  return from_radio;
+}
+
+int main() {
+  CHECK(sizeof(NodeEntry) == 18);
+
+  std::mt19937 rng(20);
+  for (size_t capacity : {1, 2, 5, 32, 100})
+    check_against_list(capacity, capacity * 2 + 3, rng);
+  check_against_list(NodeTable::MAX_CAPACITY, 400, rng);
+
+  // Lookups stay O(1) when node numbers differ only above the bits that index the slots, or only below
+  for (uint32_t stride : {0x10000u, 0x1000000u, 1u}) {
+    ProbedTable probed;
+    probed.set_capacity(NodeTable::MAX_CAPACITY);
+    for (uint32_t i = 0; i < NodeTable::MAX_CAPACITY; i++)
+      probed.touch(0xA0000000 + i * stride);
+    printf("%u nodes %u apart: longest probe %u slots\n", unsigned(NodeTable::MAX_CAPACITY), unsigned(stride),
+           unsigned(probed.longest_probe()));
+    CHECK(probed.longest_probe() < 16);
+  }
+
+  NodeTable empty;
+  empty.set_capacity(0);
+  CHECK(empty.touch(1) == nullptr);
+  CHECK(empty.get(1) == nullptr);
+
+  // The component fills the table from the dump and from packets, then refuses stale unicasts
+  static constexpr uint32_t NOW = 1700000000;
+  FakeRadio radio;
+  MeshtasticComponent mesh;
+  mesh.set_uart_parent(&radio);
+  mesh.set_restore_nodes(true);
+  mesh.set_node_table_size(8);
+  mesh.set_max_node_age(3600);
+  CHECK(testing::bring_up(mesh));
+
+  radio.send_node_info(0x1111, "Dump node", "DMP", NOW - 600);
+  std::vector<uint8_t> frame = packet_from(0x2222, 1, NOW);
+  radio.send_frame(frame.data(), frame.size());
+  for (int i = 0; i < 10; i++) {
+    testing::advance_millis(10);
+    mesh.loop();
+  }
+  const NodeEntry *dumped = mesh.get_node(0x1111);
+  const NodeEntry *heard = mesh.get_node(0x2222);
+  CHECK(dumped != nullptr && strcmp(dumped->short_name, "DMP") == 0 && dumped->last_heard == NOW - 600);
+  CHECK(dumped != nullptr && dumped->snr == 25);
+  CHECK(heard != nullptr && heard->last_heard == NOW && heard->snr == -30 && heard->rssi == -90 && heard->hops == 2);
+  CHECK(mesh.get_mesh_time() == NOW);
+  CHECK(mesh.get_node_age(0x1111) == 600);
+  CHECK(order_of(mesh.get_nodes()) == (std::vector<uint32_t>{0x2222, 0x1111}));
+
+  CHECK(mesh.send_text("hi", 0x2222, 0));
+  CHECK(mesh.send_text("hi", 0x1111, 0));
+  CHECK(!mesh.send_text("hi", 0x3333, 0));  // Never heard
+  testing::advance_millis(3601 * 1000);
+  CHECK(!mesh.send_text("hi", 0x2222, 0));
+  CHECK(mesh.send_text("hi", 0xFFFFFFFF, 0));  // Broadcasts go out regardless
+
+  // Saved on shutdown, restored by the next instance in the same order
+  mesh.on_safe_shutdown();
+  MeshtasticComponent restored;
+  restored.set_uart_parent(&radio);
+  restored.set_restore_nodes(true);
+  restored.set_node_table_size(8);
+  restored.set_enable_on_boot(false);
+  restored.setup();
+  CHECK(order_of(restored.get_nodes()) == (std::vector<uint32_t>{0x2222, 0x1111}));
+  const NodeEntry *restored_heard = restored.get_node(0x2222);
+  CHECK(restored_heard != nullptr && restored_heard->rssi == -90 && restored_heard->last_heard == NOW);
+
+  return testing::report("meshtastic_node_table_test");
+}
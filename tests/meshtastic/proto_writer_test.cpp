@@ -0,0 +1,86 @@
+// ProtoWriter and ProtoSizer against reference protobuf encodings.
+
+#include <string>
+#include <vector>
+
+#include "esphome/components/meshtastic/proto_writer.h"
+#include "test_helpers.h"
+
+using namespace esphome;
+using namespace esphome::meshtastic;
+
+/// Encode with a writer of the given capacity, empty if it overflowed
+template<typename F> static std::vector<uint8_t> encode(F &&fields, size_t capacity = 512) {
+  std::vector<uint8_t> buf(capacity);
+  ProtoWriter writer(buf.data(), buf.size());
+  fields(writer);
+  ProtoSizer sizer;
+  fields(sizer);
+  if (writer.overflow())
+    return {};
+  CHECK(sizer.size() == writer.size());
+  buf.resize(writer.size());
+  return buf;
+}
+
+int main() {
+  using Bytes = std::vector<uint8_t>;
+
+  // The examples of the protobuf encoding guide
+  CHECK(encode([](auto &w) { w.write_varint(1, 150); }) == (Bytes{0x08, 0x96, 0x01}));
+  CHECK(encode([](auto &w) { w.write_string(2, "testing"); }) ==
+        (Bytes{0x12, 0x07, 0x74, 0x65, 0x73, 0x74, 0x69, 0x6E, 0x67}));
+  CHECK(encode([](auto &w) { w.write_message(3, [](auto &m) { m.write_varint(1, 150); }); }) ==
+        (Bytes{0x1A, 0x03, 0x08, 0x96, 0x01}));
+
+  // Edges of the varint and fixed32 encodings, and a field number that needs a two byte tag
+  CHECK(encode([](auto &w) { w.write_varint(1, 0); }) == (Bytes{0x08, 0x00}));
+  CHECK(encode([](auto &w) { w.write_varint(1, 0xFFFFFFFF); }) == (Bytes{0x08, 0xFF, 0xFF, 0xFF, 0xFF, 0x0F}));
+  CHECK(encode([](auto &w) { w.write_fixed32(6, 0x12345678); }) == (Bytes{0x35, 0x78, 0x56, 0x34, 0x12}));
+  CHECK(encode([](auto &w) { w.write_varint(16, 1); }) == (Bytes{0x80, 0x01, 0x01}));
+  CHECK(encode([](auto &w) { w.write_bytes(2, nullptr, 0); }) == (Bytes{0x12, 0x00}));
+
+  // A text message to 0x12345678 on channel 2, as the radio expects it: ToRadio.packet with a MeshPacket that
+  // carries the Data in decoded. Captured from the encoder the component used before ProtoWriter.
+  const std::string text = "hello";
+  auto to_radio = [&text](auto &w) {
+    w.write_message(1, [&text](auto &packet) {
+      packet.write_fixed32(2, 0x12345678);
+      packet.write_varint(3, 2);
+      packet.write_message(4, [&text](auto &data) {
+        data.write_varint(1, 1);
+        data.write_string(2, text);
+      });
+      packet.write_fixed32(6, 0x00001001);
+      packet.write_varint(9, 3);
+      packet.write_varint(10, 1);
+      packet.write_varint(11, 70);
+    });
+  };
+  const Bytes text_reference = {0x0A, 0x1D, 0x15, 0x78, 0x56, 0x34, 0x12, 0x18, 0x02, 0x22, 0x09, 0x08,
+                                0x01, 0x12, 0x05, 0x68, 0x65, 0x6C, 0x6C, 0x6F, 0x35, 0x01, 0x10, 0x00,
+                                0x00, 0x48, 0x03, 0x50, 0x01, 0x58, 0x46};
+  CHECK(encode(to_radio) == text_reference);
+
+  // A payload past 127 bytes takes a two byte length prefix at every level it is nested in
+  const std::string long_text(233, 'x');
+  Bytes long_message = encode([&long_text](auto &w) {
+    w.write_message(1, [&long_text](auto &packet) {
+      packet.write_message(4, [&long_text](auto &data) { data.write_string(2, long_text); });
+    });
+  });
+  CHECK(long_message.size() == 3 + 3 + 3 + 233);
+  long_message.resize(9);
+  CHECK(long_message == (Bytes{0x0A, 0xEF, 0x01, 0x22, 0xEC, 0x01, 0x12, 0xE9, 0x01}));
+
+  // Running out of space flags the writer instead of writing past the buffer
+  std::vector<uint8_t> small(text_reference.size() + 8, 0xAA);
+  ProtoWriter writer(small.data(), text_reference.size() - 1);
+  to_radio(writer);
+  CHECK(writer.overflow());
+  CHECK(writer.size() < text_reference.size());
+  for (size_t i = text_reference.size() - 1; i < small.size(); i++)
+    CHECK(small[i] == 0xAA);
+
+  return testing::report("meshtastic_proto_writer_test");
+}
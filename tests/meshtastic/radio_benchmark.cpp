@@ -0,0 +1,124 @@
+// The meshtastic component against a simulated radio. Config ingest is the time from want_config until
+// config_complete, on the stub clock at 115200 baud and on the host when the line is not the limit. Send throughput is
+// messages delivered per minute when the mesh takes 1.5 s to ACK each one. ACK latency is the time from a send until
+// its ACK on a lossy mesh, retries included.
+
+#include <algorithm>
+#include <string>
+
+#include "fake_radio.h"
+#include "test_helpers.h"
+
+using namespace esphome;
+using namespace esphome::meshtastic;
+using esphome::testing::FakeRadio;
+
+static constexpr uint32_t LOOP_MS = 16;  // ESPHome's default loop interval
+static constexpr uint32_t PEER = 0x10000000;
+static constexpr uint32_t ACK_DELAY = 1500;
+static constexpr int MESSAGES = 60;
+
+static void config_ingest(size_t nodes, uint32_t baud) {
+  FakeRadio radio;
+  radio.set_dump_nodes(nodes);
+  radio.set_baud_rate(baud);
+  MeshtasticComponent mesh;
+  mesh.set_uart_parent(&radio);
+  mesh.set_node_table_size(NodeTable::MAX_CAPACITY);
+  testing::Stopwatch stopwatch;
+  CHECK(testing::bring_up(mesh, 60000, LOOP_MS));
+  double host_us = stopwatch.elapsed_us();
+  const MeshStats &stats = mesh.get_stats();
+  CHECK(stats.config_frames == nodes + 3);
+  CHECK(mesh.get_nodes().size() == nodes);
+  if (baud != 0) {
+    printf("config ingest, %3u nodes at %u baud: %5u ms, %3u frames\n", unsigned(nodes), unsigned(baud),
+           unsigned(stats.config_ms), unsigned(stats.config_frames));
+  } else {
+    printf("config ingest, %3u nodes, host:        %7.1f us, %3u frames, %5.2f us per frame\n", unsigned(nodes),
+           host_us, unsigned(stats.config_frames), host_us / stats.config_frames);
+  }
+}
+
+// Send MESSAGES texts at once and run until all were delivered, returns messages per minute of the stub clock
+static double send_throughput(uint8_t max_in_flight) {
+  FakeRadio radio;
+  radio.set_ack_delay(ACK_DELAY);
+  MeshtasticComponent mesh;
+  mesh.set_uart_parent(&radio);
+  mesh.set_max_in_flight(max_in_flight);
+  mesh.set_queue_size(MESSAGES);
+  CHECK(testing::bring_up(mesh, 10000, LOOP_MS));
+
+  int delivered = 0;
+  uint32_t start = millis();
+  testing::Stopwatch stopwatch;
+  for (int i = 0; i < MESSAGES; i++) {
+    CHECK(mesh.send_text("message " + std::to_string(i), PEER, 0,
+                         [&delivered](bool success) { delivered += success; }));
+  }
+  CHECK(testing::run_until(mesh, 600000, [&delivered]() { return delivered == MESSAGES; }, LOOP_MS));
+  double host_us = stopwatch.elapsed_us();
+  uint32_t elapsed = millis() - start;
+  double per_minute = MESSAGES * 60000.0 / elapsed;
+  printf("send throughput, max_in_flight %u: %5.1f messages per minute, %6.2f us per message on the host\n",
+         max_in_flight, per_minute, host_us / MESSAGES);
+  return per_minute;
+}
+
+// Send MESSAGES texts one after the other on a mesh losing a tenth of them, returns the mean latency in ms
+static double ack_latency() {
+  FakeRadio radio;
+  radio.set_ack_delay(ACK_DELAY);
+  radio.set_loss(0.1f);
+  radio.set_seed(25);
+  MeshtasticComponent mesh;
+  mesh.set_uart_parent(&radio);
+  mesh.set_ack_timeout(5000);
+  mesh.set_max_retries(3);
+  CHECK(testing::bring_up(mesh, 10000, LOOP_MS));
+
+  // Latency from the first attempt; the component's own ack_latency_ms counts from the last one
+  uint64_t total = 0;
+  uint32_t worst = 0;
+  uint32_t worst_last_attempt = 0;
+  int delivered = 0;
+  for (int i = 0; i < MESSAGES; i++) {
+    uint32_t start = millis();
+    int result = -1;
+    CHECK(mesh.send_text("ping " + std::to_string(i), PEER, 0, [&result](bool success) { result = success; }));
+    CHECK(testing::run_until(mesh, 60000, [&result]() { return result != -1; }, LOOP_MS));
+    if (result != 1)
+      continue;
+    uint32_t latency = millis() - start;
+    delivered++;
+    total += latency;
+    worst = std::max(worst, latency);
+    worst_last_attempt = std::max(worst_last_attempt, mesh.get_stats().ack_latency_ms);
+  }
+  CHECK(delivered >= MESSAGES - 1);
+  CHECK(worst_last_attempt < ACK_DELAY + 2 * LOOP_MS);
+  double mean = double(total) / delivered;
+  printf("ACK latency, 10%% loss: %2d/%d delivered in %u packets, mean %6.1f ms, max %5u ms (%u ms from the last "
+         "attempt)\n",
+         delivered, MESSAGES, unsigned(radio.get_packets().size()), mean, unsigned(worst),
+         unsigned(worst_last_attempt));
+  return mean;
+}
+
+int main() {
+  for (size_t nodes : {0, 30, 100, 250})
+    config_ingest(nodes, 115200);
+  for (size_t nodes : {0, 30, 100, 250})
+    config_ingest(nodes, 0);
+
+  double one = send_throughput(1);
+  double four = send_throughput(4);
+  CHECK(one < 60000.0 / ACK_DELAY);
+  CHECK(four > 3 * one);
+
+  double mean = ack_latency();
+  CHECK(mean >= ACK_DELAY && mean < 2 * ACK_DELAY);
+
+  return testing::report("meshtastic_radio_benchmark");
+}
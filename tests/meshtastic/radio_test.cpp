@@ -0,0 +1,153 @@
+// The component against a simulated radio: the want_config handshake, ACKs, NAKs and lost packets with retries,
+// max_in_flight and a full radio TX queue, the admin config applied with a reboot, and a radio rebooting by itself.
+
+#include <string>
+#include <vector>
+
+#include "fake_radio.h"
+#include "test_helpers.h"
+
+using namespace esphome;
+using namespace esphome::meshtastic;
+using esphome::testing::FakeRadio;
+
+static constexpr uint32_t PORTNUM_TEXT = 1;
+static constexpr uint32_t PORTNUM_ADMIN = 6;
+static constexpr uint32_t DUMP_NODES = 20;
+static constexpr uint32_t PEER = 0x10000000;  // The first node of the dump
+
+// AdminMessage { begin_edit_settings (64) }, { set_config (34) = Config { lora (6) = { region (7) = EU_868,
+// hop_limit (8) = 5 } } } and { commit_edit_settings (65) }, what the codegen emits for a lora: block
+static const uint8_t BEGIN_EDIT[] = {0x80, 0x04, 0x01};
+static const uint8_t SET_LORA[] = {0x92, 0x02, 0x06, 0x32, 0x04, 0x38, 0x03, 0x40, 0x05};
+static const uint8_t COMMIT_EDIT[] = {0x88, 0x04, 0x01};
+
+static void add_config(MeshtasticComponent &mesh) {
+  mesh.add_config_admin_msg(BEGIN_EDIT, sizeof(BEGIN_EDIT));
+  mesh.add_config_admin_msg(SET_LORA, sizeof(SET_LORA));
+  mesh.add_config_admin_msg(COMMIT_EDIT, sizeof(COMMIT_EDIT));
+  mesh.set_configure_on_boot(true);
+}
+
+// Queue a text and run until its callback said how it went; -1 if it never did
+static int send_and_wait(MeshtasticComponent &mesh, const std::string &text, uint32_t ms) {
+  int result = -1;
+  if (!mesh.send_text(text, PEER, 0, [&result](bool success) { result = success; }))
+    return -1;
+  testing::run_until(mesh, ms, [&result]() { return result != -1; });
+  return result;
+}
+
+int main() {
+  FakeRadio radio;
+  radio.set_names("Base Station", "BASE");
+  radio.set_dump_nodes(DUMP_NODES);
+  MeshtasticComponent mesh;
+  mesh.set_uart_parent(&radio);
+  int succeeded = 0;
+  int failed = 0;
+  mesh.add_on_send_success_callback([&succeeded]() { succeeded++; });
+  mesh.add_on_send_failed_callback([&failed]() { failed++; });
+
+  // The handshake: want_config answered with my_info, our node, the mesh, then config_complete
+  CHECK(testing::bring_up(mesh));
+  CHECK(radio.get_config_requests() == 1);
+  CHECK(mesh.get_my_node_num() == FakeRadio::NODE_NUM);
+  CHECK(mesh.get_my_long_name() == "Base Station" && mesh.get_my_short_name() == "BASE");
+  CHECK(mesh.get_nodes().size() == DUMP_NODES);
+  CHECK(mesh.get_node(PEER + (DUMP_NODES - 1) * 0x1111) != nullptr);
+  CHECK(mesh.get_stats().config_frames == DUMP_NODES + 3);
+
+  // ACKed after the mesh took its time
+  radio.set_ack_delay(1500);
+  CHECK(send_and_wait(mesh, "hello", 5000) == 1);
+  CHECK(radio.get_packets().size() == 1 && radio.get_packets()[0].payload == "hello");
+  CHECK(radio.get_packets()[0].portnum == PORTNUM_TEXT && radio.get_packets()[0].to == PEER);
+  CHECK(radio.get_packets()[0].want_ack);
+  CHECK(mesh.get_stats().delivered == 1 && mesh.get_stats().ack_latency_ms >= 1500);
+  CHECK(mesh.get_stats().ack_latency_ms < 1600);
+  CHECK(succeeded == 1 && failed == 0);
+  CHECK(mesh.is_ready() && mesh.get_pending_count() == 0);
+
+  // NAKed: failed at once, no retry
+  mesh.set_max_retries(2);
+  radio.set_nak_rate(1);
+  CHECK(send_and_wait(mesh, "nak", 5000) == 0);
+  CHECK(radio.get_packets().size() == 2);
+  CHECK(mesh.get_stats().failed == 1 && succeeded == 1 && failed == 1);
+  radio.set_nak_rate(0);
+
+  // Lost: sent again with the same id after each ACK timeout, failed after the last retry
+  mesh.set_ack_timeout(3000);
+  radio.set_loss(1);
+  CHECK(send_and_wait(mesh, "lost", 20000) == 0);
+  CHECK(radio.get_packets().size() == 5);
+  uint32_t lost_id = radio.get_packets()[2].id;
+  CHECK(radio.get_packets()[3].id == lost_id && radio.get_packets()[4].id == lost_id);
+  CHECK(radio.get_packets()[4].at - radio.get_packets()[2].at >= 6000);
+  CHECK(mesh.get_stats().failed == 2 && failed == 2);
+  radio.set_loss(0);
+
+  // No more than max_in_flight waiting for their ACK, the rest goes out as ACKs come back
+  mesh.set_max_in_flight(2);
+  size_t sent_before = radio.get_packets().size();
+  int results = 0;
+  for (int i = 0; i < 6; i++)
+    CHECK(mesh.send_text("burst " + std::to_string(i), PEER, 0, [&results](bool success) { results += success; }));
+  testing::run_until(mesh, 500, []() { return false; });
+  CHECK(radio.get_packets().size() - sent_before == 2);
+  CHECK(testing::run_until(mesh, 10000, [&results]() { return results == 6; }));
+  CHECK(radio.get_packets().size() - sent_before == 6);
+
+  // A radio TX queue of two slots turns packets away; they wait for room without using up retries
+  mesh.set_max_in_flight(4);
+  mesh.set_max_retries(0);
+  radio.set_queue_size(2);
+  sent_before = radio.get_packets().size();
+  results = 0;
+  for (int i = 0; i < 6; i++)
+    CHECK(mesh.send_text("full " + std::to_string(i), PEER, 0, [&results](bool success) { results += success; }));
+  CHECK(testing::run_until(mesh, 60000,
+                           [&results, &mesh]() { return results == 6 && mesh.get_pending_count() == 0; }));
+  CHECK(radio.get_rejected() > 0);
+  CHECK(radio.get_packets().size() - sent_before == 6 + radio.get_rejected());
+  CHECK(failed == 2);
+  radio.set_queue_size(16);
+
+  // The radio reboots by itself: the component notices, asks for the config again and comes back
+  uint32_t requests = radio.get_config_requests();
+  radio.reboot();
+  CHECK(testing::run_until(mesh, 100, [&mesh]() { return !mesh.is_ready(); }));
+  CHECK(testing::run_until(mesh, 10000, [&mesh]() { return mesh.is_ready(); }));
+  CHECK(radio.get_config_requests() == requests + 1);
+  CHECK(send_and_wait(mesh, "after reboot", 5000) == 1);
+
+  // Admin config that differs from the radio's: sent in one edit, then a reboot, then ready on the new config
+  FakeRadio unconfigured;
+  MeshtasticComponent configuring;
+  configuring.set_uart_parent(&unconfigured);
+  add_config(configuring);
+  configuring.setup();
+  CHECK(testing::run_until(configuring, 5000, [&configuring]() {
+    return configuring.get_state() == State::APPLYING_CONFIG;
+  }));
+  CHECK(testing::run_until(configuring, 30000, [&configuring]() { return configuring.is_ready(); }));
+  CHECK(unconfigured.get_reboots() == 1 && unconfigured.get_config_requests() == 2);
+  std::vector<std::string> admin;
+  for (const FakeRadio::Packet &packet : unconfigured.get_packets()) {
+    if (packet.portnum == PORTNUM_ADMIN && packet.to == FakeRadio::NODE_NUM)
+      admin.push_back(packet.payload);
+  }
+  CHECK(admin.size() == 4);
+  CHECK(admin.size() == 4 && admin[1] == std::string(reinterpret_cast<const char *>(SET_LORA), sizeof(SET_LORA)));
+  CHECK(admin.size() == 4 && admin[3] == std::string("\x88\x06\x02", 3));  // reboot_seconds = 2
+
+  // The next boot finds the config in the dump and leaves the radio alone
+  MeshtasticComponent configured;
+  configured.set_uart_parent(&unconfigured);
+  add_config(configured);
+  CHECK(testing::bring_up(configured));
+  CHECK(unconfigured.get_reboots() == 1 && unconfigured.get_config_requests() == 3);
+
+  return testing::report("meshtastic_radio_test");
+}
@@ -0,0 +1,165 @@
+// The readings encoder and decoder: scaling, key and delta frames, sequence gaps, senders, malformed frames, the frame
+// size against the same values as text, and the component passing a frame from the radio to on_readings.
+
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "esphome/components/meshtastic/readings.h"
+#include "fake_radio.h"
+#include "test_helpers.h"
+
+using namespace esphome;
+using namespace esphome::meshtastic;
+using esphome::testing::FakeRadio;
+
+static constexpr uint32_t PORTNUM_READINGS = 257;
+static constexpr size_t MAX_DATA_PAYLOAD = 233;
+
+static bool same(const std::vector<Reading> &a, const std::vector<Reading> &b) {
+  if (a.size() != b.size())
+    return false;
+  for (size_t i = 0; i < a.size(); i++) {
+    if (a[i].id != b[i].id || a[i].decimals != b[i].decimals || a[i].value != b[i].value)
+      return false;
+  }
+  return true;
+}
+
+static std::vector<uint8_t> encode(ReadingsEncoder &encoder, const std::vector<Reading> &readings) {
+  std::vector<uint8_t> frame(MAX_DATA_PAYLOAD);
+  frame.resize(encoder.encode(readings, frame.data(), frame.size()));
+  return frame;
+}
+
+static bool decode(ReadingsDecoder &decoder, uint32_t from, const std::vector<uint8_t> &frame,
+                   std::vector<Reading> *out) {
+  return decoder.decode(from, frame.data(), frame.size(), out);
+}
+
+int main() {
+  // Scaling rounds to the decimals, clamps to int32 and caps the decimals
+  CHECK(Reading::from_state(1, 2, 21.436f).value == 2144);
+  CHECK(Reading::from_state(1, 1, -3.25f).value == -33);  // Halves round away from zero
+  CHECK(Reading::from_state(1, 0, 1e12f).value == INT32_MAX);
+  CHECK(Reading::from_state(1, 0, -1e12f).value == INT32_MIN);
+  CHECK(Reading::from_state(1, 9, 1.0f).decimals == Reading::MAX_DECIMALS);
+  CHECK(std::fabs(Reading::from_state(1, 3, 3.912f).get_state() - 3.912f) < 1e-6f);
+
+  // A weather node: twelve sensors drifting slowly, sent every minute
+  struct Sensor {
+    uint8_t decimals;
+    float state;
+    float step;
+  };
+  std::vector<Sensor> sensors = {{2, 21.43f, 0.05f}, {1, 55.2f, 0.3f},   {1, 1013.2f, 0.1f}, {3, 3.912f, 0.002f},
+                                 {0, 412, 3},         {1, 4.6f, 0.4f},    {0, 270, 10},       {2, 19.87f, 0.05f},
+                                 {1, 0.0f, 0.1f},     {0, 86, 1},         {2, 2.31f, 0.02f},  {1, -1.5f, 0.2f}};
+  std::mt19937 rng(23);
+  ReadingsEncoder encoder;
+  ReadingsDecoder decoder;
+  size_t frame_bytes = 0;
+  size_t text_bytes = 0;
+  static constexpr int FRAMES = 200;
+  for (int f = 0; f < FRAMES; f++) {
+    std::vector<Reading> readings;
+    std::string text;
+    char item[32];
+    for (size_t i = 0; i < sensors.size(); i++) {
+      Sensor &sensor = sensors[i];
+      sensor.state += sensor.step * (int(rng() % 3) - 1);
+      readings.push_back(Reading::from_state(i, sensor.decimals, sensor.state));
+      snprintf(item, sizeof(item), "s%u=%.*f,", unsigned(i), sensor.decimals, sensor.state);
+      text += item;
+    }
+    std::vector<uint8_t> frame = encode(encoder, readings);
+    CHECK(!frame.empty());
+    // Key frames every key_frame_interval frames, the first one included
+    CHECK(bool(frame[0] & ReadingsEncoder::FLAG_DELTA) == (f % 10 != 0));
+    std::vector<Reading> decoded;
+    CHECK(decode(decoder, 1, frame, &decoded) && same(decoded, readings));
+    frame_bytes += frame.size();
+    text_bytes += text.size();
+  }
+  CHECK(frame_bytes * 2 < text_bytes);
+  printf("%u sensors: %.1f bytes per frame, %.1f bytes as text\n", unsigned(sensors.size()),
+         double(frame_bytes) / FRAMES, double(text_bytes) / FRAMES);
+
+  // A missed delta frame: the following deltas are refused until the next key frame
+  ReadingsEncoder gap_encoder;
+  ReadingsDecoder gap_decoder;
+  gap_encoder.set_key_frame_interval(4);
+  std::vector<Reading> readings = {{1, 0, 100}, {2, 1, -50}};
+  std::vector<Reading> decoded;
+  CHECK(decode(gap_decoder, 7, encode(gap_encoder, readings), &decoded));  // Key
+  readings[0].value++;
+  encode(gap_encoder, readings);  // Lost
+  readings[0].value++;
+  CHECK(!decode(gap_decoder, 7, encode(gap_encoder, readings), &decoded));
+  readings[1].value--;
+  CHECK(!decode(gap_decoder, 7, encode(gap_encoder, readings), &decoded));
+  CHECK(decode(gap_decoder, 7, encode(gap_encoder, readings), &decoded) && same(decoded, readings));  // Key
+  // A delta frame from a sender never heard is refused too, and reset() makes the next frame a key frame
+  CHECK(!decode(gap_decoder, 8, encode(gap_encoder, readings), &decoded));
+  gap_encoder.reset();
+  std::vector<uint8_t> key = encode(gap_encoder, readings);
+  CHECK(!(key[0] & ReadingsEncoder::FLAG_DELTA));
+  CHECK(decode(gap_decoder, 8, key, &decoded) && same(decoded, readings));
+
+  // Deltas wrap around like uint32_t
+  ReadingsEncoder wrap_encoder;
+  ReadingsDecoder wrap_decoder;
+  std::vector<Reading> extreme = {{3, 0, INT32_MAX}};
+  CHECK(decode(wrap_decoder, 1, encode(wrap_encoder, extreme), &decoded));
+  extreme[0].value = INT32_MIN;
+  std::vector<uint8_t> wrapped = encode(wrap_encoder, extreme);
+  CHECK((wrapped[0] & ReadingsEncoder::FLAG_DELTA) && wrapped.size() == 4);
+  CHECK(decode(wrap_decoder, 1, wrapped, &decoded) && same(decoded, extreme));
+
+  // A batch that does not fit leaves the encoder as it was, the next frame continues the sequence
+  ReadingsEncoder full_encoder;
+  ReadingsDecoder full_decoder;
+  std::vector<Reading> many;
+  for (uint16_t i = 0; i < 60; i++)
+    many.push_back({uint16_t(1000 + i), 2, -1000000});
+  CHECK(decode(full_decoder, 1, encode(full_encoder, readings), &decoded));
+  CHECK(encode(full_encoder, many).empty());
+  CHECK(decode(full_decoder, 1, encode(full_encoder, readings), &decoded) && same(decoded, readings));
+
+  // Malformed frames: another version, cut short, an id past 16 bits
+  std::vector<uint8_t> frame = encode(full_encoder, readings);
+  std::vector<uint8_t> other_version = frame;
+  other_version[0] = (other_version[0] & ~ReadingsEncoder::VERSION_MASK) | 0x30;
+  CHECK(!decode(full_decoder, 1, other_version, &decoded));
+  std::vector<uint8_t> cut(frame.begin(), frame.end() - 1);
+  CHECK(!decode(full_decoder, 1, cut, &decoded));
+  CHECK(decode(full_decoder, 1, frame, &decoded) && same(decoded, readings));
+  const std::vector<uint8_t> big_id = {ReadingsEncoder::VERSION, 1, 0x80, 0x80, 0x80, 0x04, 0x00};
+  CHECK(!decode(full_decoder, 2, big_id, &decoded));
+
+  // More senders than MAX_SENDERS: the least recently heard one is forgotten, its next delta frame is refused
+  ReadingsDecoder senders_decoder;
+  std::vector<ReadingsEncoder> encoders(ReadingsDecoder::MAX_SENDERS + 1);
+  for (size_t i = 0; i < encoders.size(); i++)
+    CHECK(decode(senders_decoder, 100 + i, encode(encoders[i], readings), &decoded));
+  CHECK(!decode(senders_decoder, 100, encode(encoders[0], readings), &decoded));
+  CHECK(decode(senders_decoder, 100 + encoders.size() - 1, encode(encoders.back(), readings), &decoded));
+
+  // The component hands a frame from the radio to on_readings
+  FakeRadio radio;
+  MeshtasticComponent mesh;
+  mesh.set_uart_parent(&radio);
+  CHECK(testing::bring_up(mesh));
+  std::vector<Reading> received;
+  mesh.add_on_readings_callback([&received](const std::vector<Reading> &r) { received = r; });
+  ReadingsEncoder sender;
+  std::vector<uint8_t> packet = encode(sender, readings);
+  radio.send_packet(0x5555, FakeRadio::NODE_NUM, 1, PORTNUM_READINGS, std::string(packet.begin(), packet.end()));
+  testing::advance_millis(10);
+  mesh.loop();
+  CHECK(same(received, readings));
+  CHECK(mesh.get_last_from_node() == 0x5555);
+
+  return testing::report("meshtastic_readings_test");
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "esphome/core/component.h"
+
+namespace esphome {
+namespace spi {
+
+enum SPIBitOrder { BIT_ORDER_LSB_FIRST, BIT_ORDER_MSB_FIRST };
+enum SPIClockPolarity { CLOCK_POLARITY_LOW, CLOCK_POLARITY_HIGH };
+enum SPIClockPhase { CLOCK_PHASE_LEADING, CLOCK_PHASE_TRAILING };
+enum SPIDataRate : uint32_t { DATA_RATE_1MHZ = 1000000, DATA_RATE_10MHZ = 10000000, DATA_RATE_20MHZ = 20000000 };
+
+/// What went over the bus, so tests can see how a driver talks to its chip.
+struct SPIBusCounters {
+  uint32_t transactions{0};  ///< enable() calls, each one a chip select cycle
+  uint32_t calls{0};         ///< Write, read and transfer calls
+  uint64_t bytes_written{0};
+  uint64_t bytes_read{0};
+};
+
+extern SPIBusCounters bus_counters;  // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+
+/// A bus without a device on it: writes are counted, reads return zeros.
+template<SPIBitOrder BIT_ORDER, SPIClockPolarity CLOCK_POLARITY, SPIClockPhase CLOCK_PHASE, SPIDataRate DATA_RATE>
+class SPIDevice {
+ public:
+  void spi_setup() {}
+  void enable() { bus_counters.transactions++; }
+  void disable() {}
+
+  void write_byte(uint8_t data) { this->count_write_(1); }
+  void write_byte16(uint16_t data) { this->count_write_(2); }
+  void write_array(const uint8_t *data, size_t length) { this->count_write_(length); }
+  void write_array16(const uint16_t *data, size_t length) { this->count_write_(2 * length); }
+  void read_array(uint8_t *data, size_t length) {
+    memset(data, 0, length);
+    bus_counters.calls++;
+    bus_counters.bytes_read += length;
+  }
+  uint8_t transfer_byte(uint8_t data) {
+    this->count_write_(1);
+    return 0;
+  }
+  void transfer_array(uint8_t *data, size_t length) {
+    this->count_write_(length);
+    memset(data, 0, length);
+  }
+
+ protected:
+  void count_write_(size_t length) {
+    bus_counters.calls++;
+    bus_counters.bytes_written += length;
+  }
+};
+
+}  // namespace spi
+}  // namespace esphome
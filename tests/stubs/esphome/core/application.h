@@ -0,0 +1,24 @@
+#pragma once
+
+#include <string>
+
+#include "esphome/core/component.h"
+
+namespace esphome {
+
+class Application {
+ public:
+  void feed_wdt() { this->wdt_feeds_++; }
+  const std::string &get_name() const { return this->name_; }
+
+  /// How often feed_wdt() was called, for tests of how busy loops keep the watchdog happy.
+  uint32_t get_wdt_feeds() const { return this->wdt_feeds_; }
+
+ protected:
+  std::string name_{"host"};
+  uint32_t wdt_feeds_{0};
+};
+
+extern Application App;  // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+
+}  // namespace esphome
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <functional>
+
+#include "esphome/core/component.h"
+#include "esphome/core/helpers.h"
+
+namespace esphome {
+
+template<typename T, typename... X> class TemplatableValue {
+ public:
+  TemplatableValue() = default;
+  TemplatableValue(T value) : value_(value), has_value_(true) {}
+  template<typename F> TemplatableValue(F f) : f_(f), has_value_(true), is_lambda_(true) {}
+
+  bool has_value() const { return this->has_value_; }
+  T value(X... x) { return this->is_lambda_ ? this->f_(x...) : this->value_; }
+
+ protected:
+  T value_{};
+  std::function<T(X...)> f_;
+  bool has_value_{false};
+  bool is_lambda_{false};
+};
+
+#define TEMPLATABLE_VALUE(type, name) \
+ protected: \
+  TemplatableValue<type, Ts...> name##_{}; \
+\
+ public: \
+  template<typename V> void set_##name(V name) { this->name##_ = name; }
+
+template<typename... Ts> class Trigger {
+ public:
+  void trigger(Ts... x) {}
+};
+
+template<typename... Ts> class Action {
+ public:
+  virtual ~Action() = default;
+  virtual void play(Ts... x) = 0;
+};
+
+template<typename... Ts> class Condition {
+ public:
+  virtual ~Condition() = default;
+  virtual bool check(Ts... x) = 0;
+};
+
+template<typename T> class Parented {
+ public:
+  void set_parent(T *parent) { this->parent_ = parent; }
+
+ protected:
+  T *parent_{nullptr};
+};
+
+}  // namespace esphome
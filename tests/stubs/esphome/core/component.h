@@ -0,0 +1,56 @@
+#pragma once
+
+#include <functional>
+#include <string>
+
+#include "esphome/core/gpio.h"
+#include "esphome/core/hal.h"
+#include "esphome/core/helpers.h"
+#include "esphome/core/optional.h"
+
+namespace esphome {
+
+namespace setup_priority {
+const float HARDWARE = 800.0f;
+const float DATA = 600.0f;
+const float PROCESSOR = 400.0f;
+const float AFTER_WIFI = 200.0f;
+}  // namespace setup_priority
+
+/// Timers and status flags are not simulated, the tests call setup() and loop() themselves.
+class Component {
+ public:
+  virtual ~Component() = default;
+  virtual void setup() {}
+  virtual void loop() {}
+  virtual void dump_config() {}
+  virtual void on_safe_shutdown() {}
+  virtual void on_shutdown() {}
+  virtual float get_setup_priority() const { return 0.0f; }
+  virtual float get_loop_priority() const { return 0.0f; }
+
+  void mark_failed() { this->failed_ = true; }
+  bool is_failed() const { return this->failed_; }
+  bool is_ready() const { return !this->failed_; }
+  void status_set_warning() {}
+  void status_clear_warning() {}
+
+ protected:
+  void set_timeout(const std::string &name, uint32_t timeout, std::function<void()> &&f) {}
+  void set_timeout(uint32_t timeout, std::function<void()> &&f) {}
+  void set_interval(const std::string &name, uint32_t interval, std::function<void()> &&f) {}
+  bool cancel_timeout(const std::string &name) { return true; }
+  void defer(std::function<void()> &&f) {}
+
+  bool failed_{false};
+};
+
+class PollingComponent : public Component {
+ public:
+  virtual void update() = 0;
+  void start_poller() {}
+  void stop_poller() {}
+  uint32_t get_update_interval() const { return 0; }
+};
+
+}  // namespace esphome
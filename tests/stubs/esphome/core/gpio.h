@@ -0,0 +1,19 @@
+#pragma once
+
+namespace esphome {
+
+namespace gpio {
+enum Flags { FLAG_NONE = 0, FLAG_INPUT = 1, FLAG_OUTPUT = 2 };
+}  // namespace gpio
+
+/// A pin that reads high, which the drivers under test take as "not busy".
+class GPIOPin {
+ public:
+  virtual ~GPIOPin() = default;
+  virtual void setup() {}
+  virtual void pin_mode(gpio::Flags flags) {}
+  virtual bool digital_read() { return true; }
+  virtual void digital_write(bool value) {}
+};
+
+}  // namespace esphome
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+
+namespace esphome {
+
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+void yield();
+
+inline uint8_t progmem_read_byte(const uint8_t *addr) { return *addr; }
+
+namespace testing {
+/// The clock behind millis() and micros(), it only moves when a test moves it.
+void set_millis(uint32_t now);
+void advance_millis(uint32_t ms);
+}  // namespace testing
+
+}  // namespace esphome
+
+/// Comes with the Arduino core on the devices. Deterministic on the host so runs can be compared.
+uint32_t esp_random();
@@ -0,0 +1,78 @@
+#pragma once
+
+// Host build stand-ins for the parts of esphome/core/helpers.h the components use.
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "esphome/core/defines.h"
+
+#define ESPHOME_ALWAYS_INLINE __attribute__((always_inline))
+#define HOT
+#define PROGMEM
+
+namespace esphome {
+
+template<typename T> T clamp(T value, T min, T max) { return std::min(std::max(value, min), max); }
+
+inline uint16_t encode_uint16(uint8_t msb, uint8_t lsb) { return (uint16_t(msb) << 8) | lsb; }
+
+inline uint8_t esp_scale8(uint8_t i, uint8_t scale) { return (uint16_t(i) * (1 + uint16_t(scale))) / 256; }
+
+inline uint32_t fnv1_hash(const std::string &str) {
+  uint32_t hash = 2166136261UL;
+  for (char c : str) {
+    hash *= 16777619UL;
+    hash ^= c;
+  }
+  return hash;
+}
+
+/// Plain heap memory, the host has no PSRAM.
+template<class T> class ExternalRAMAllocator {
+ public:
+  enum Flags { NONE = 0, REFUSE_INTERNAL = 1, ALLOW_FAILURE = 2 };
+
+  ExternalRAMAllocator() = default;
+  ExternalRAMAllocator(Flags flags) {}
+
+  T *allocate(size_t n) { return static_cast<T *>(malloc(n * sizeof(T))); }
+  void deallocate(T *p, size_t n) { free(p); }
+};
+
+template<class T> class RAMAllocator : public ExternalRAMAllocator<T> {
+ public:
+  using ExternalRAMAllocator<T>::ExternalRAMAllocator;
+};
+
+template<typename... Ts> class CallbackManager;
+
+template<typename... Ts> class CallbackManager<void(Ts...)> {
+ public:
+  void add(std::function<void(Ts...)> &&callback) { this->callbacks_.push_back(std::move(callback)); }
+  void call(Ts... args) {
+    for (auto &cb : this->callbacks_)
+      cb(args...);
+  }
+  size_t size() const { return this->callbacks_.size(); }
+
+ protected:
+  std::vector<std::function<void(Ts...)>> callbacks_;
+};
+
+class HighFrequencyLoopRequester {
+ public:
+  void start() {}
+  void stop() {}
+  static bool is_high_frequency() { return false; }
+};
+
+}  // namespace esphome
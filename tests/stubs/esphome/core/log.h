@@ -0,0 +1,28 @@
+#pragma once
+
+// Logging compiles to nothing on the host so benchmarks measure the component, the arguments are still type checked.
+
+#include "esphome/core/helpers.h"
+
+namespace esphome {
+inline void esp_log_discard(const char *format, ...) __attribute__((format(printf, 1, 2)));
+inline void esp_log_discard(const char *format, ...) {}
+}  // namespace esphome
+
+#define ESP_LOGE(tag, ...) ::esphome::esp_log_discard(__VA_ARGS__)
+#define ESP_LOGW(tag, ...) ::esphome::esp_log_discard(__VA_ARGS__)
+#define ESP_LOGI(tag, ...) ::esphome::esp_log_discard(__VA_ARGS__)
+#define ESP_LOGD(tag, ...) ::esphome::esp_log_discard(__VA_ARGS__)
+#define ESP_LOGV(tag, ...) ::esphome::esp_log_discard(__VA_ARGS__)
+#define ESP_LOGVV(tag, ...) ::esphome::esp_log_discard(__VA_ARGS__)
+#define ESP_LOGCONFIG(tag, ...) ::esphome::esp_log_discard(__VA_ARGS__)
+
+#define LOG_PIN(prefix, pin) (void) (pin)
+#define LOG_SENSOR(prefix, type, obj) (void) (obj)
+#define LOG_BINARY_SENSOR(prefix, type, obj) (void) (obj)
+#define LOG_TEXT_SENSOR(prefix, type, obj) (void) (obj)
+#define LOG_UPDATE_INTERVAL(this) (void) (this)
+
+struct LogString;
+#define LOG_STR(s) (reinterpret_cast<const LogString *>(s))
+#define LOG_STR_ARG(s) (reinterpret_cast<const char *>(s))
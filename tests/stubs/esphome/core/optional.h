@@ -0,0 +1,19 @@
+#pragma once
+
+namespace esphome {
+
+template<typename T> class optional {
+ public:
+  optional() = default;
+  optional(T value) : value_(value), has_value_(true) {}
+
+  bool has_value() const { return this->has_value_; }
+  T &operator*() { return this->value_; }
+  T value() const { return this->value_; }
+
+ protected:
+  T value_{};
+  bool has_value_{false};
+};
+
+}  // namespace esphome
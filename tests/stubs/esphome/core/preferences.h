@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace esphome {
+
+/// Preferences kept in memory, so a test can restore what an earlier instance saved.
+class ESPPreferenceObject {
+ public:
+  ESPPreferenceObject() = default;
+  explicit ESPPreferenceObject(std::shared_ptr<std::vector<uint8_t>> data) : data_(std::move(data)) {}
+
+  template<typename T> bool save(const T *src) {
+    if (!this->data_)
+      return false;
+    this->data_->assign(reinterpret_cast<const uint8_t *>(src), reinterpret_cast<const uint8_t *>(src) + sizeof(T));
+    return true;
+  }
+  template<typename T> bool load(T *dest) {
+    if (!this->data_ || this->data_->size() != sizeof(T))
+      return false;
+    memcpy(dest, this->data_->data(), sizeof(T));
+    return true;
+  }
+
+ protected:
+  std::shared_ptr<std::vector<uint8_t>> data_;
+};
+
+class ESPPreferences {
+ public:
+  template<typename T> ESPPreferenceObject make_preference(uint32_t type, bool in_flash = false) {
+    for (auto &entry : this->entries_) {
+      if (entry.first == type)
+        return ESPPreferenceObject(entry.second);
+    }
+    this->entries_.emplace_back(type, std::make_shared<std::vector<uint8_t>>());
+    return ESPPreferenceObject(this->entries_.back().second);
+  }
+
+ protected:
+  std::vector<std::pair<uint32_t, std::shared_ptr<std::vector<uint8_t>>>> entries_;
+};
+
+extern ESPPreferences *global_preferences;  // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+
+}  // namespace esphome
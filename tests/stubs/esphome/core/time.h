@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstddef>
+#include <ctime>
+
+namespace esphome {
+
+struct ESPTime {
+  size_t strftime(char *buffer, size_t buffer_len, const char *format) {
+    struct tm c_tm {};
+    return ::strftime(buffer, buffer_len, format, &c_tm);
+  }
+};
+
+}  // namespace esphome
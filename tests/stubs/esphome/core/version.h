@@ -0,0 +1,4 @@
+#pragma once
+
+#define VERSION_CODE(major, minor, patch) ((major) << 16 | (minor) << 8 | (patch))
+#define ESPHOME_VERSION_CODE VERSION_CODE(2024, 6, 0)
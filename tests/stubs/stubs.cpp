@@ -0,0 +1,40 @@
+#include "esphome/components/spi/spi.h"
+#include "esphome/core/application.h"
+#include "esphome/core/color.h"
+#include "esphome/core/hal.h"
+#include "esphome/core/preferences.h"
+
+namespace esphome {
+
+Application App;  // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+ESPPreferences *global_preferences = new ESPPreferences();  // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+
+const Color Color::BLACK(0, 0, 0, 0);
+const Color Color::WHITE(255, 255, 255, 255);
+
+static uint32_t now_ms = 0;  // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+
+uint32_t millis() { return now_ms; }
+uint32_t micros() { return now_ms * 1000; }
+void delay(uint32_t ms) { now_ms += ms; }
+void yield() {}
+
+namespace testing {
+void set_millis(uint32_t now) { now_ms = now; }
+void advance_millis(uint32_t ms) { now_ms += ms; }
+}  // namespace testing
+
+namespace spi {
+SPIBusCounters bus_counters;  // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+}  // namespace spi
+
+}  // namespace esphome
+
+uint32_t esp_random() {
+  // xorshift32, the same sequence on every run
+  static uint32_t state = 0x12345678;
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state;
+}